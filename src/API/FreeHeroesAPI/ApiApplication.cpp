@@ -22,6 +22,7 @@
 #include "SpriteMapPainterPixmap.hpp"
 #include "Painter.hpp"
 
+#include <optional>
 #include <string>
 
 namespace FreeHeroes {
@@ -62,6 +63,8 @@ struct ApiApplication::Impl {
 
     FHMap m_map;
 
+    std::optional<FHDerandomizePools> m_derandomizePools;
+
     ScopeTimer   m_timer;
     SpriteMap    m_spriteMap;
     ViewSettings m_viewSettings;
@@ -150,6 +153,7 @@ void ApiApplication::reinit() noexcept(false)
     {
         m_impl->m_map       = {};
         m_impl->m_spriteMap = {};
+        m_impl->m_derandomizePools.reset();
     }
 
     Logger(Logger::Info) << "reinit - end";
@@ -194,6 +198,7 @@ void ApiApplication::loadMap(const std::string& mapPath) noexcept(false)
     auto               fullpath = Mernel::string2path(mapPath);
     auto               ext      = fullpath.extension();
     const bool         isH3M    = Mernel::path2string(ext) == ".h3m";
+    const bool         isBinary = Mernel::path2string(ext) == ".fhmapb";
 
     MapConverter::Settings sett;
     if (isH3M)
@@ -209,6 +214,8 @@ void ApiApplication::loadMap(const std::string& mapPath) noexcept(false)
 
         if (isH3M)
             converter.run(MapConverter::Task::LoadH3M);
+        else if (isBinary)
+            converter.run(MapConverter::Task::LoadFHBinary);
         else
             converter.run(MapConverter::Task::LoadFH);
 
@@ -236,7 +243,10 @@ void ApiApplication::derandomize()
 {
     auto rng = m_impl->m_randomGeneratorFactory->create();
     rng->makeGoodSeed();
-    m_impl->m_map.derandomize(rng.get());
+    // pools depend only on the database, so they are rebuilt only when a map of other version is loaded.
+    if (!m_impl->m_derandomizePools || m_impl->m_derandomizePools->m_database != m_impl->m_map.m_database)
+        m_impl->m_derandomizePools.emplace(m_impl->m_map.m_database);
+    m_impl->m_map.derandomize(rng.get(), *m_impl->m_derandomizePools);
 }
 
 void ApiApplication::setRenderWindow(const RenderWindow& renderWindow) noexcept
@@ -4,12 +4,17 @@
  * See LICENSE file for details.
  */
 
+#include <algorithm>
 #include <iostream>
 
 #include "CoreApplication.hpp"
 #include "MernelPlatform/CommandLineUtils.hpp"
+#include "MernelPlatform/FileIOUtils.hpp"
+#include "MernelPlatform/FileFormatJson.hpp"
 
 #include "MapConverter.hpp"
+#include "MapConverterBatch.hpp"
+#include "MapIndex.hpp"
 
 using namespace FreeHeroes;
 using namespace Mernel;
@@ -34,6 +39,9 @@ int main(int argc, char** argv)
                                    "dump-uncompressed",
                                    "dump-json",
                                    "logging-level",
+                                   "jobs",
+                                   "summary-json",
+                                   "index-file",
                                },
                                { "tasks" });
     parser.markRequired({ "tasks" });
@@ -47,9 +55,31 @@ int main(int argc, char** argv)
     const bool        dumpUncompressed = parser.getArg("dump-uncompressed") == "1";
     const bool        dumpJson         = parser.getArg("dump-json") == "1";
     const std::string loggingLevelStr  = parser.getArg("logging-level");
+    const std::string jobsStr          = parser.getArg("jobs");
+    const std::string summaryJson      = parser.getArg("summary-json");
+    const std::string indexFile        = parser.getArg("index-file");
 
     const int loggingLevel = loggingLevelStr.empty() ? 4 : std::strtoull(loggingLevelStr.c_str(), nullptr, 10);
 
+    const size_t jobs = jobsStr.empty() ? 1 : std::max(1ULL, std::strtoull(jobsStr.c_str(), nullptr, 10));
+
+    // map list summary for input-folder; only maps changed since last run are parsed.
+    if (tasks.size() == 1 && tasks[0] == "IndexFolder") {
+        const std_path root = string2path(parser.getArg("input-folder"));
+        if (root.empty()) {
+            std::cerr << "IndexFolder requires --input-folder\n";
+            return 1;
+        }
+        const std_path indexPath = indexFile.empty() ? root / ".fhmapindex" : string2path(indexFile);
+
+        MapIndex index;
+        index.load(indexPath);
+        const size_t parsed = index.update(root, jobs);
+        index.save(indexPath);
+        std::cerr << "Indexed " << index.m_entries.size() << " maps, parsed " << parsed << ": " << path2string(indexPath) << "\n";
+        return 0;
+    }
+
     Core::CoreApplication fhCoreApp;
     fhCoreApp.initLogger(loggingLevel);
     if (!fhCoreApp.load())
@@ -114,43 +144,31 @@ int main(int argc, char** argv)
         batch.push_back(settings);
     }
 
-    MapConverter                        converter(std::cerr,
-                           fhCoreApp.getDatabaseContainer(),
-                           fhCoreApp.getRandomGeneratorFactory(),
-                           settings);
+    std::vector<MapConverter::Task> taskList;
+    for (const std::string& taskStr : tasks) {
+        const MapConverter::Task task = stringToTask(taskStr);
+        if (task == MapConverter::Task::Invalid) {
+            std::cerr << "Unknown task: " << taskStr << "\n";
+            return 1;
+        }
+        taskList.push_back(task);
+    }
+
+    using RunStatus = MapConverterBatch::RunStatus;
+
+    MapConverterBatch                            batchRunner(std::cerr, fhCoreApp.getDatabaseContainer(), fhCoreApp.getRandomGeneratorFactory());
+    const std::vector<MapConverterBatch::Result> results = batchRunner.run(batch, taskList, batchModeEnabled ? jobs : 1);
+
     std::vector<MapConverter::Settings> batchFailedTrip;
     std::vector<MapConverter::Settings> batchFatalError;
     std::vector<MapConverter::Settings> batchSucceeded;
-
-    for (const auto& setting : batch) {
-        converter.setSettings(setting);
-        bool isFailed = false;
-        bool isFatal  = false;
-        for (const std::string& taskStr : tasks) {
-            const MapConverter::Task task = stringToTask(taskStr);
-            if (task == MapConverter::Task::Invalid) {
-                std::cerr << "Unknown task: " << taskStr << "\n";
-                return 1;
-            }
-            try {
-                converter.run(task);
-            }
-            catch (MapConverter::RoundTripException&) {
-                isFailed = true;
-                continue;
-            }
-            catch (std::exception& ex) {
-                std::cerr << ex.what() << "\n";
-                isFatal = true;
-                continue;
-            }
-        }
-        if (isFatal)
-            batchFatalError.push_back(setting);
-        else if (isFailed)
-            batchFailedTrip.push_back(setting);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (results[i].m_status == RunStatus::Fatal)
+            batchFatalError.push_back(batch[i]);
+        else if (results[i].m_status == RunStatus::FailedRoundTrip)
+            batchFailedTrip.push_back(batch[i]);
         else
-            batchSucceeded.push_back(setting);
+            batchSucceeded.push_back(batch[i]);
     }
     if (batchModeEnabled) {
         std::cerr << "Successful runs:\n";
@@ -164,5 +182,11 @@ int main(int argc, char** argv)
             std::cerr << sett.m_inputs.m_h3m.m_binary << "\n";
     }
 
+    if (batchModeEnabled && !summaryJson.empty()) {
+        PropertyTree json;
+        MapConverterBatch::writeSummaryJson(json, batch, results);
+        writeFileFromBuffer(string2path(summaryJson), writeJsonToBuffer(json, true));
+    }
+
     return batchFailedTrip.size() + batchFatalError.size() != 0;
 }
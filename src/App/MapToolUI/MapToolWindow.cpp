@@ -155,7 +155,7 @@ MapToolWindow::MapToolWindow(
     m_ui->mapGamename->setValidator(new QRegularExpressionValidator(QRegularExpression("[a-zA-Z0-9_ -]+"), this));
     m_ui->comboBoxStageDebug->addItem(tr("--show debug--"));
     for (int i = 1; i <= int(FHTemplateProcessor::Stage::PlayerInfo); i++) {
-        m_ui->comboBoxStageDebug->addItem(QString::fromStdString(FHTemplateProcessor::stageToString(FHTemplateProcessor::Stage(i))));
+        m_ui->comboBoxStageDebug->addItem(QString::fromUtf8(FHTemplateProcessor::stageToString(FHTemplateProcessor::Stage(i))));
     }
 
     updatePaths();
@@ -4,16 +4,180 @@
  * See LICENSE file for details.
  */
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <mutex>
+#include <set>
+#include <thread>
 
 #include "CoreApplication.hpp"
 #include "MernelPlatform/CommandLineUtils.hpp"
+#include "MernelPlatform/FileIOUtils.hpp"
+#include "MernelPlatform/FileFormatJson.hpp"
+#include "MernelPlatform/Profiler.hpp"
+#include "MernelExecution/ParallelExecutor.hpp"
+#include "MernelExecution/TaskQueue.hpp"
 
 #include "MapConverter.hpp"
 
 using namespace FreeHeroes;
 using namespace Mernel;
 
+namespace {
+
+struct BatchResult {
+    uint64_t                      m_seed    = 0;
+    bool                          m_success = false;
+    std::string                   m_error;
+    int64_t                       m_totalUS    = 0;
+    int64_t                       m_guardCount = 0;
+    int64_t                       m_guardValue = 0;
+    FHTemplateProcessor::RunStats m_stats;
+};
+
+// converter keeps reference to log, so both live together until map is saved.
+struct SeedJob {
+    size_t                        m_index = 0;
+    std::ostringstream            m_log;
+    std::unique_ptr<MapConverter> m_converter;
+};
+
+// whole string must be a decimal number; throws otherwise.
+uint64_t parseSeedNumber(const std::string& str, const std::string& argName)
+{
+    if (str.empty() || str[0] < '0' || str[0] > '9')
+        throw std::runtime_error("Invalid " + argName + " value: '" + str + "'");
+    char* end = nullptr;
+    errno     = 0;
+
+    const uint64_t value = std::strtoull(str.c_str(), &end, 10);
+    if (errno == ERANGE || *end != '\0')
+        throw std::runtime_error("Invalid " + argName + " value: '" + str + "'");
+    return value;
+}
+
+// "10..20" range, "1,5,7" list, or --count N seeds starting from firstSeed. Throws on malformed input.
+std::vector<uint64_t> parseSeeds(const std::string& seedsStr, const std::string& countStr, uint64_t firstSeed)
+{
+    constexpr uint64_t s_maxSeeds = 1000000;
+
+    auto addRange = [](std::vector<uint64_t>& result, uint64_t from, uint64_t to) {
+        if (to - from >= s_maxSeeds)
+            throw std::runtime_error("Too many seeds, limit is " + std::to_string(s_maxSeeds));
+        result.reserve(to - from + 1);
+        for (uint64_t seed = from;; ++seed) {
+            result.push_back(seed);
+            if (seed == to)
+                break;
+        }
+    };
+
+    std::vector<uint64_t> result;
+    if (!countStr.empty()) {
+        const uint64_t count = parseSeedNumber(countStr, "--count");
+        if (!count)
+            return result;
+        if (count - 1 > UINT64_MAX - firstSeed)
+            throw std::runtime_error("Seed range overflows: " + std::to_string(firstSeed) + " + " + countStr);
+        addRange(result, firstSeed, firstSeed + (count - 1));
+        return result;
+    }
+    if (auto rangePos = seedsStr.find(".."); rangePos != std::string::npos) {
+        const uint64_t from = parseSeedNumber(seedsStr.substr(0, rangePos), "--seeds range start");
+        const uint64_t to   = parseSeedNumber(seedsStr.substr(rangePos + 2), "--seeds range end");
+        if (from > to)
+            throw std::runtime_error("Reversed --seeds range: " + seedsStr);
+        addRange(result, from, to);
+        return result;
+    }
+    std::istringstream is(seedsStr);
+    std::string        part;
+    while (std::getline(is, part, ','))
+        result.push_back(parseSeedNumber(part, "--seeds"));
+    return result;
+}
+
+// "map.fhMap.json" => "map_42.fhMap.json"; "{seed}" placeholder in file name is replaced if present.
+std_path pathForSeed(const std_path& path, uint64_t seed)
+{
+    if (path.empty())
+        return path;
+    std::string       filename = path2string(path.filename());
+    const std::string seedStr  = std::to_string(seed);
+    if (auto pos = filename.find("{seed}"); pos != std::string::npos) {
+        filename.replace(pos, 6, seedStr);
+    } else {
+        auto dotPos = filename.find('.');
+        filename.insert(dotPos == std::string::npos ? filename.size() : dotPos, "_" + seedStr);
+    }
+    return path.parent_path() / string2path(filename);
+}
+
+std::string makeSummaryCsv(const std::vector<BatchResult>& results)
+{
+    std::vector<std::string> stages;
+    std::set<std::string>    zoneIds;
+    for (const auto& result : results) {
+        for (const auto& [stage, time] : result.m_stats.m_stageTimesUS) {
+            if (std::find(stages.cbegin(), stages.cend(), stage) == stages.cend())
+                stages.push_back(stage);
+        }
+        for (const auto& [zoneId, zone] : result.m_stats.m_zones)
+            zoneIds.insert(zoneId);
+    }
+
+    std::ostringstream os;
+    os << "seed,status,totalUS";
+    for (const auto& stage : stages)
+        os << ",stage" << stage << "US";
+    for (const auto& zoneId : zoneIds)
+        os << ",zoneArea_" << zoneId;
+    os << ",guardCount,guardValueTotal,failedStage,error\n";
+
+    for (const auto& result : results) {
+        os << result.m_seed << "," << (result.m_success ? "ok" : "failed") << "," << result.m_totalUS;
+        for (const auto& stage : stages) {
+            os << ",";
+            for (const auto& [stageDone, time] : result.m_stats.m_stageTimesUS) {
+                if (stageDone == stage)
+                    os << time;
+            }
+        }
+        for (const auto& zoneId : zoneIds) {
+            os << ",";
+            if (auto it = result.m_stats.m_zones.find(zoneId); it != result.m_stats.m_zones.cend())
+                os << it->second.m_placedArea;
+        }
+        std::string error = result.m_error;
+        for (char& c : error) {
+            if (c == '"' || c == '\n' || c == '\r')
+                c = '\'';
+        }
+        os << "," << result.m_guardCount << "," << result.m_guardValue << "," << result.m_stats.m_failedStage << ",\"" << error << "\"\n";
+    }
+    return os.str();
+}
+
+void writeJson(const std_path& filename, const FHTemplateRunStats& stats)
+{
+    PropertyTree json;
+    stats.toJson(json);
+    writeFileFromBuffer(filename, writeJsonToBuffer(json, true));
+}
+
+void writeJson(const std_path& filename, const FHTemplateStatsAggregator& aggregator)
+{
+    PropertyTree json;
+    aggregator.toJson(json);
+    writeFileFromBuffer(filename, writeJsonToBuffer(json, true));
+}
+
+}
+
 int main(int argc, char** argv)
 {
     AbstractCommandLine parser({
@@ -29,6 +193,14 @@ int main(int argc, char** argv)
                                    "stage-show-debug",
                                    "heat-stop-after",
                                    "tile-filter",
+                                   "checkpoint-dir",
+                                   "resume-from",
+                                   "seeds",
+                                   "count",
+                                   "jobs",
+                                   "summary-csv",
+                                   "metrics-report",
+                                   "output-metrics",
                                },
                                { "tasks" });
     parser.markRequired({ "tasks" });
@@ -51,6 +223,8 @@ int main(int argc, char** argv)
     templateSettings.m_showDebugStage  = parser.getArg("stage-show-debug");
     templateSettings.m_tileFilter      = parser.getArg("tile-filter");
     templateSettings.m_rngUserSettings = Mernel::string2path(parser.getArg("rng-settings-file"));
+    templateSettings.m_checkpointDir   = Mernel::string2path(parser.getArg("checkpoint-dir"));
+    templateSettings.m_resumeFrom      = Mernel::string2path(parser.getArg("resume-from"));
 
     const std::string loggingLevelStr = parser.getArg("logging-level");
     const int         loggingLevel    = loggingLevelStr.empty() ? 4 : std::strtoull(loggingLevelStr.c_str(), nullptr, 10);
@@ -78,18 +252,195 @@ int main(int argc, char** argv)
         .m_outputs = makePaths("output-"),
     };
 
-    MapConverter converter(std::cerr,
-                           fhCoreApp.getDatabaseContainer(),
-                           fhCoreApp.getRandomGeneratorFactory(),
-                           settings);
-    converter.setTemplateSettings(templateSettings);
-
+    std::vector<MapConverter::Task> taskList;
     for (const std::string& taskStr : tasks) {
         const MapConverter::Task task = stringToTask(taskStr);
         if (task == MapConverter::Task::Invalid) {
             std::cerr << "Unknown task: " << taskStr << "\n";
             return 1;
         }
+        taskList.push_back(task);
+    }
+
+    const std_path metricsReport = string2path(parser.getArg("metrics-report"));
+    const std_path outputMetrics = string2path(parser.getArg("output-metrics"));
+
+    const std::string seedsStr = parser.getArg("seeds");
+    const std::string countStr = parser.getArg("count");
+    if (!seedsStr.empty() || !countStr.empty()) {
+        std::vector<uint64_t> seeds;
+        try {
+            seeds = parseSeeds(seedsStr, countStr, templateSettings.m_seed ? templateSettings.m_seed : 1);
+        }
+        catch (std::exception& ex) {
+            std::cerr << ex.what() << "\n";
+            return 1;
+        }
+        if (seeds.empty()) {
+            std::cerr << "No seeds to generate\n";
+            return 1;
+        }
+        // checkpoint is bound to the seed it was made for.
+        if (!templateSettings.m_resumeFrom.empty() && seeds.size() > 1) {
+            std::cerr << "--resume-from can be used only with a single seed\n";
+            return 1;
+        }
+        const std::string jobsStr = parser.getArg("jobs");
+        const size_t      jobs    = jobsStr.empty() ? std::max(1U, std::thread::hardware_concurrency()) : std::strtoull(jobsStr.c_str(), nullptr, 10);
+
+        MapConverter::preloadDatabases(fhCoreApp.getDatabaseContainer());
+
+        templateSettings.m_preparedCache = std::make_shared<FHPreparedTemplateCache>();
+        // seeds already run in parallel, so work inside one map is not split further.
+        settings.m_threads = 1;
+
+        // when tasks are generation followed by h3m export, saving goes to separate executor,
+        // so generation of next seeds overlaps with conversion and compression of previous ones.
+        const bool pipelineSave = !taskList.empty() && taskList.front() == MapConverter::Task::GenerateFHMap
+                                  && std::all_of(taskList.cbegin() + 1, taskList.cend(), [](MapConverter::Task task) { return task == MapConverter::Task::SaveH3M; });
+
+        std::vector<BatchResult> results(seeds.size());
+        std::mutex               logMutex;
+        size_t                   finished = 0;
+
+        auto finishSeed = [&](SeedJob& job) {
+            BatchResult& result = results[job.m_index];
+            result.m_stats      = job.m_converter->m_templateStats;
+            if (!outputMetrics.empty())
+                writeJson(pathForSeed(outputMetrics, result.m_seed), result.m_stats);
+
+            std::lock_guard lock(logMutex);
+            finished++;
+            std::cerr << "[" << finished << "/" << seeds.size() << "] seed=" << result.m_seed << " " << (result.m_success ? "done" : "FAILED") << " (" << result.m_totalUS << " us.)\n";
+            if (!result.m_success)
+                std::cerr << job.m_log.str() << result.m_error << "\n";
+        };
+        // runs converter tasks for one seed; returns job whose map still needs to be saved.
+        auto generateSeed = [&](size_t index) -> std::shared_ptr<SeedJob> {
+            BatchResult& result = results[index];
+            result.m_seed       = seeds[index];
+
+            MapConverter::Settings seedSettings = settings;
+            seedSettings.m_outputs.m_fhMap      = pathForSeed(settings.m_outputs.m_fhMap, result.m_seed);
+            seedSettings.m_outputs.m_fhTemplate = pathForSeed(settings.m_outputs.m_fhTemplate, result.m_seed);
+            seedSettings.m_outputs.m_h3m        = { .m_binary = pathForSeed(settings.m_outputs.m_h3m.m_binary, result.m_seed) };
+
+            MapConverter::TemplateSettings seedTemplateSettings = templateSettings;
+            seedTemplateSettings.m_seed                         = result.m_seed;
+            seedTemplateSettings.m_saveResult                   = !pipelineSave;
+            if (!templateSettings.m_checkpointDir.empty())
+                seedTemplateSettings.m_checkpointDir = templateSettings.m_checkpointDir / string2path(std::to_string(result.m_seed));
+
+            auto job         = std::make_shared<SeedJob>();
+            job->m_index     = index;
+            job->m_converter = std::make_unique<MapConverter>(job->m_log,
+                                                              fhCoreApp.getDatabaseContainer(),
+                                                              fhCoreApp.getRandomGeneratorFactory(),
+                                                              seedSettings);
+            job->m_converter->setTemplateSettings(seedTemplateSettings);
+
+            Mernel::ScopeTimer timer;
+            try {
+                for (auto task : taskList) {
+                    job->m_converter->run(task);
+                    if (pipelineSave)
+                        break;
+                }
+                result.m_success = true;
+            }
+            catch (std::exception& ex) {
+                result.m_error = ex.what();
+            }
+            catch (...) {
+                result.m_error = "Unknown error";
+            }
+            result.m_totalUS = timer.elapsedUS();
+            for (const auto& monster : job->m_converter->m_mapFH.m_objects.m_monsters) {
+                result.m_guardCount++;
+                result.m_guardValue += monster.m_guardValue;
+            }
+
+            if (pipelineSave && result.m_success)
+                return job;
+            finishSeed(*job);
+            return nullptr;
+        };
+        // json is written before h3m, as h3m conversion changes map database.
+        auto saveSeed = [&](SeedJob& job) {
+            BatchResult&       result = results[job.m_index];
+            Mernel::ScopeTimer timer;
+            try {
+                job.m_converter->run(MapConverter::Task::SaveFH);
+                for (auto it = taskList.cbegin() + 1; it != taskList.cend(); ++it)
+                    job.m_converter->run(*it);
+            }
+            catch (std::exception& ex) {
+                result.m_success = false;
+                result.m_error   = ex.what();
+            }
+            catch (...) {
+                result.m_success = false;
+                result.m_error   = "Unknown error";
+            }
+            result.m_totalUS += timer.elapsedUS();
+            finishSeed(job);
+        };
+
+        // seeds go in waves: while one wave is generated, maps of the previous one are saved.
+        // no worker waits for the other executor, and at most two waves of maps are kept in memory.
+        const size_t     threads  = std::max(size_t(1), jobs);
+        const size_t     waveSize = pipelineSave ? threads : seeds.size();
+        ParallelExecutor generateExecutor(threads);
+        ParallelExecutor saveExecutor(threads);
+        ParallelExecutor waveExecutor(2);
+
+        std::vector<std::shared_ptr<SeedJob>> generated;
+        for (size_t waveStart = 0; waveStart < seeds.size() || !generated.empty(); waveStart += waveSize) {
+            std::vector<std::shared_ptr<SeedJob>> saving = std::move(generated);
+            generated.assign(waveStart < seeds.size() ? std::min(waveSize, seeds.size() - waveStart) : 0, nullptr);
+
+            TaskQueue generateQueue;
+            for (size_t i = 0; i < generated.size(); ++i)
+                generateQueue.addTask([&generateSeed, &generated, i, index = waveStart + i] { generated[i] = generateSeed(index); });
+            TaskQueue saveQueue;
+            for (auto& job : saving) {
+                if (job)
+                    saveQueue.addTask([&saveSeed, job] { saveSeed(*job); });
+            }
+            TaskQueue waveQueue;
+            waveQueue.addTask([&generateExecutor, &generateQueue] { generateExecutor.execQueue(generateQueue); });
+            waveQueue.addTask([&saveExecutor, &saveQueue] { saveExecutor.execQueue(saveQueue); });
+            waveExecutor.execQueue(waveQueue);
+        }
+
+        const size_t failures = std::count_if(results.cbegin(), results.cend(), [](const BatchResult& result) { return !result.m_success; });
+        std::cerr << "Generated " << (results.size() - failures) << " maps, failed: " << failures << "\n";
+
+        const std::string summaryCsv = parser.getArg("summary-csv");
+        if (!summaryCsv.empty())
+            writeFileFromBuffer(string2path(summaryCsv), makeSummaryCsv(results));
+
+        if (!metricsReport.empty()) {
+            FHTemplateStatsAggregator aggregator;
+            for (const auto& result : results) {
+                if (result.m_success)
+                    aggregator.addRun(result.m_seed, result.m_stats);
+                else
+                    aggregator.addFailure(result.m_seed, result.m_error);
+            }
+            writeJson(metricsReport, aggregator);
+        }
+
+        return failures != 0;
+    }
+
+    MapConverter converter(std::cerr,
+                           fhCoreApp.getDatabaseContainer(),
+                           fhCoreApp.getRandomGeneratorFactory(),
+                           settings);
+    converter.setTemplateSettings(templateSettings);
+
+    for (auto task : taskList) {
         try {
             converter.run(task);
         }
@@ -98,9 +449,19 @@ int main(int argc, char** argv)
         }
         catch (std::exception& ex) {
             std::cerr << ex.what() << "\n";
+            if (!outputMetrics.empty())
+                writeJson(outputMetrics, converter.m_templateStats);
             return 1;
         }
     }
 
+    if (!outputMetrics.empty())
+        writeJson(outputMetrics, converter.m_templateStats);
+    if (!metricsReport.empty()) {
+        FHTemplateStatsAggregator aggregator;
+        aggregator.addRun(converter.m_mapFH.m_seed, converter.m_templateStats);
+        writeJson(metricsReport, aggregator);
+    }
+
     return 0;
 }
@@ -5,8 +5,14 @@
  */
 #pragma once
 
-#include <map>
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 namespace FreeHeroes::Core {
 
@@ -30,6 +36,152 @@ enum class ScoreAttr
     SpellAny,
     Support,
 };
-using MapScore = std::map<ScoreAttr, int64_t>;
+
+// Map-like container ScoreAttr => value, stored as fixed array and presence mask.
+// Iteration goes in enum order, same as std::map did; value of missing key is always 0.
+class MapScore {
+public:
+    using key_type    = ScoreAttr;
+    using mapped_type = int64_t;
+    using value_type  = std::pair<ScoreAttr, int64_t>;
+    using size_type   = size_t;
+
+    static constexpr size_t s_size = static_cast<size_t>(ScoreAttr::Support) + 1;
+
+    template<bool isConst>
+    class Iterator {
+    public:
+        using ValueRef  = std::conditional_t<isConst, const int64_t&, int64_t&>;
+        using reference = std::pair<ScoreAttr, ValueRef>;
+
+        reference operator*() const noexcept { return { static_cast<ScoreAttr>(m_index), m_values[m_index] }; }
+        Iterator& operator++() noexcept
+        {
+            m_index = nextIndex(m_mask, m_index + 1);
+            return *this;
+        }
+        bool operator==(const Iterator& rh) const noexcept { return m_index == rh.m_index; }
+
+    private:
+        friend class MapScore;
+        using ValuesPtr = std::conditional_t<isConst, const int64_t*, int64_t*>;
+
+        Iterator(ValuesPtr values, uint32_t mask, size_t index) noexcept
+            : m_values(values)
+            , m_mask(mask)
+            , m_index(nextIndex(mask, index))
+        {}
+
+        ValuesPtr m_values = nullptr;
+        uint32_t  m_mask   = 0;
+        size_t    m_index  = s_size;
+    };
+    using iterator       = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    MapScore() = default;
+    MapScore(std::initializer_list<value_type> values)
+    {
+        for (const auto& [key, value] : values)
+            (*this)[key] = value;
+    }
+
+    iterator       begin() noexcept { return iterator(m_values.data(), m_mask, 0); }
+    iterator       end() noexcept { return iterator(m_values.data(), m_mask, s_size); }
+    const_iterator begin() const noexcept { return const_iterator(m_values.data(), m_mask, 0); }
+    const_iterator end() const noexcept { return const_iterator(m_values.data(), m_mask, s_size); }
+
+    bool   empty() const noexcept { return m_mask == 0; }
+    size_t size() const noexcept { return std::popcount(m_mask); }
+    bool   contains(ScoreAttr key) const noexcept { return m_mask & bit(key); }
+
+    int64_t& operator[](ScoreAttr key) noexcept
+    {
+        m_mask |= bit(key);
+        return m_values[index(key)];
+    }
+    int64_t at(ScoreAttr key) const
+    {
+        if (!contains(key))
+            throw std::out_of_range("MapScore has no such key");
+        return m_values[index(key)];
+    }
+    // 0 for missing key.
+    int64_t get(ScoreAttr key) const noexcept { return m_values[index(key)]; }
+
+    void erase(ScoreAttr key) noexcept
+    {
+        m_mask &= ~bit(key);
+        m_values[index(key)] = 0;
+    }
+    void clear() noexcept
+    {
+        m_mask = 0;
+        m_values.fill(0);
+    }
+
+    // keys of rh are inserted even if sum is zero.
+    MapScore& operator+=(const MapScore& rh) noexcept
+    {
+        for (size_t i = 0; i < s_size; ++i)
+            m_values[i] += rh.m_values[i];
+        m_mask |= rh.m_mask;
+        return *this;
+    }
+    // keys of rh that become zero are removed.
+    MapScore& operator-=(const MapScore& rh) noexcept
+    {
+        uint32_t zeroMask = 0;
+        for (size_t i = 0; i < s_size; ++i) {
+            m_values[i] -= rh.m_values[i];
+            zeroMask |= uint32_t(m_values[i] == 0) << i;
+        }
+        m_mask = (m_mask | rh.m_mask) & ~(zeroMask & rh.m_mask);
+        return *this;
+    }
+
+    // true if some key is missing in limit, or value is greater than limit value.
+    bool isOverflow(const MapScore& limit) const noexcept
+    {
+        if (m_mask & ~limit.m_mask)
+            return true;
+        uint32_t greaterMask = 0;
+        for (size_t i = 0; i < s_size; ++i)
+            greaterMask |= uint32_t(m_values[i] > limit.m_values[i]) << i;
+        return greaterMask & m_mask;
+    }
+
+    int64_t total() const noexcept
+    {
+        int64_t result = 0;
+        for (size_t i = 0; i < s_size; ++i)
+            result += m_values[i];
+        return result;
+    }
+    // maximum of values, but not less than 0.
+    int64_t maxValue() const noexcept
+    {
+        int64_t result = 0;
+        for (size_t i = 0; i < s_size; ++i)
+            result = std::max(result, m_values[i]);
+        return result;
+    }
+
+    bool operator==(const MapScore&) const noexcept = default;
+
+private:
+    static constexpr size_t   index(ScoreAttr key) noexcept { return static_cast<size_t>(key); }
+    static constexpr uint32_t bit(ScoreAttr key) noexcept { return uint32_t(1) << index(key); }
+    static size_t             nextIndex(uint32_t mask, size_t index) noexcept
+    {
+        if (index >= s_size)
+            return s_size;
+        const uint32_t rest = mask >> index;
+        return rest ? index + std::countr_zero(rest) : s_size;
+    }
+
+    std::array<int64_t, s_size> m_values{};
+    uint32_t                    m_mask = 0;
+};
 
 }
@@ -18,6 +18,8 @@
 
 #include "MernelPlatform/Logger.hpp"
 
+#include <cassert>
+
 namespace FreeHeroes {
 using namespace Mernel;
 
@@ -100,24 +102,69 @@ void FHMap::rescaleToUserSize()
     m_tileMap.m_height = mapSize;
 }
 
-void FHMap::derandomize(Core::IRandomGenerator* rng)
+FHDerandomizePools::FHDerandomizePools(const Core::IGameDatabase* database)
+    : m_database(database)
 {
-    std::vector<Core::LibraryFactionConstPtr> factionsTown;
-    std::set<Core::LibraryFactionConstPtr>    factionsDwelling;
-    {
-        auto& factions = m_database->factions()->records();
-        for (auto* faction : factions) {
-            if (faction->alignment == Core::LibraryFaction::Alignment::Special)
-                continue;
-            factionsDwelling.insert(faction);
-            if (faction->alignment == Core::LibraryFaction::Alignment::Independent)
-                continue;
-            factionsTown.push_back(faction);
+    std::set<Core::LibraryFactionConstPtr> factionsDwelling;
+    for (auto* faction : m_database->factions()->records()) {
+        if (faction->alignment == Core::LibraryFaction::Alignment::Special)
+            continue;
+        factionsDwelling.insert(faction);
+        if (faction->alignment == Core::LibraryFaction::Alignment::Independent)
+            continue;
+        m_townFactions.push_back(faction);
+    }
+
+    m_resources = m_database->resources()->records();
+
+    for (auto* art : m_database->artifacts()->records()) {
+        if (art->treasureClass == Core::LibraryArtifact::TreasureClass::Treasure) {
+            m_artifacts[FHRandomArtifact::Type::Treasure].push_back(art);
+            m_artifacts[FHRandomArtifact::Type::Any].push_back(art);
+        }
+        if (art->treasureClass == Core::LibraryArtifact::TreasureClass::Minor) {
+            m_artifacts[FHRandomArtifact::Type::Minor].push_back(art);
+            m_artifacts[FHRandomArtifact::Type::Any].push_back(art);
         }
+        if (art->treasureClass == Core::LibraryArtifact::TreasureClass::Major) {
+            m_artifacts[FHRandomArtifact::Type::Major].push_back(art);
+            m_artifacts[FHRandomArtifact::Type::Any].push_back(art);
+        }
+        if (art->treasureClass == Core::LibraryArtifact::TreasureClass::Relic) {
+            m_artifacts[FHRandomArtifact::Type::Relic].push_back(art);
+            m_artifacts[FHRandomArtifact::Type::Any].push_back(art);
+        }
+    }
+
+    for (auto* unit : m_database->units()->records()) {
+        if (!factionsDwelling.contains(unit->faction))
+            continue;
+        m_units[unit->level / 10].push_back(unit);
+        m_units[0].push_back(unit);
     }
+
+    for (auto* dwell : m_database->dwellings()->records()) {
+        if (dwell->creatureIds.size() != 1)
+            continue;
+        if (!factionsDwelling.contains(dwell->creatureIds[0]->faction))
+            continue;
+        m_dwellings[dwell->creatureIds[0]->level / 10].push_back(dwell);
+        m_dwellings[0].push_back(dwell);
+    }
+}
+
+void FHMap::derandomize(Core::IRandomGenerator* rng)
+{
+    derandomize(rng, FHDerandomizePools(m_database));
+}
+
+void FHMap::derandomize(Core::IRandomGenerator* rng, const FHDerandomizePools& pools)
+{
+    assert(pools.m_database == m_database);
     {
-        auto allRes = m_database->resources()->records();
+        auto& allRes = pools.m_resources;
 
+        m_objects.m_resources.reserve(m_objects.m_resources.size() + m_objects.m_resourcesRandom.size());
         for (auto& obj : m_objects.m_resourcesRandom) {
             auto*      rndRes = allRes[rng->gen(allRes.size() - 1)];
             FHResource res;
@@ -131,25 +178,9 @@ void FHMap::derandomize(Core::IRandomGenerator* rng)
         m_objects.m_resourcesRandom.clear();
     }
     {
-        std::map<FHRandomArtifact::Type, std::vector<Core::LibraryArtifactConstPtr>> arts;
-        for (auto* art : m_database->artifacts()->records()) {
-            if (art->treasureClass == Core::LibraryArtifact::TreasureClass::Treasure) {
-                arts[FHRandomArtifact::Type::Treasure].push_back(art);
-                arts[FHRandomArtifact::Type::Any].push_back(art);
-            }
-            if (art->treasureClass == Core::LibraryArtifact::TreasureClass::Minor) {
-                arts[FHRandomArtifact::Type::Minor].push_back(art);
-                arts[FHRandomArtifact::Type::Any].push_back(art);
-            }
-            if (art->treasureClass == Core::LibraryArtifact::TreasureClass::Major) {
-                arts[FHRandomArtifact::Type::Major].push_back(art);
-                arts[FHRandomArtifact::Type::Any].push_back(art);
-            }
-            if (art->treasureClass == Core::LibraryArtifact::TreasureClass::Relic) {
-                arts[FHRandomArtifact::Type::Relic].push_back(art);
-                arts[FHRandomArtifact::Type::Any].push_back(art);
-            }
-        }
+        auto& arts = pools.m_artifacts;
+
+        m_objects.m_artifacts.reserve(m_objects.m_artifacts.size() + m_objects.m_artifactsRandom.size());
         for (auto& obj : m_objects.m_artifactsRandom) {
             auto&      artstc = arts.at(obj.m_type);
             auto*      rndArt = artstc[rng->gen(artstc.size() - 1)];
@@ -161,13 +192,7 @@ void FHMap::derandomize(Core::IRandomGenerator* rng)
         m_objects.m_artifactsRandom.clear();
     }
     {
-        std::map<int, std::vector<Core::LibraryUnitConstPtr>> units;
-        for (auto* unit : m_database->units()->records()) {
-            if (!factionsDwelling.contains(unit->faction))
-                continue;
-            units[unit->level / 10].push_back(unit);
-            units[0].push_back(unit);
-        }
+        auto& units = pools.m_units;
 
         std::vector<FHMonster> keepMonsters;
         std::vector<FHMonster> extraMonsters;
@@ -196,7 +221,7 @@ void FHMap::derandomize(Core::IRandomGenerator* rng)
                 keepTowns.push_back(obj);
                 continue;
             }
-            auto*  rndFaction = factionsTown[rng->gen(factionsTown.size() - 1)];
+            auto*  rndFaction = pools.m_townFactions[rng->gen(pools.m_townFactions.size() - 1)];
             FHTown town;
             town.m_pos       = obj.m_pos;
             town.m_factionId = rndFaction;
@@ -209,15 +234,9 @@ void FHMap::derandomize(Core::IRandomGenerator* rng)
         m_towns.insert(m_towns.end(), extraTowns.cbegin(), extraTowns.cend());
     }
     {
-        std::map<int, std::vector<Core::LibraryDwellingConstPtr>> dwellings;
-        for (auto* dwell : m_database->dwellings()->records()) {
-            if (dwell->creatureIds.size() != 1)
-                continue;
-            if (!factionsDwelling.contains(dwell->creatureIds[0]->faction))
-                continue;
-            dwellings[dwell->creatureIds[0]->level / 10].push_back(dwell);
-            dwellings[0].push_back(dwell);
-        }
+        auto& dwellings = pools.m_dwellings;
+
+        m_objects.m_dwellings.reserve(m_objects.m_dwellings.size() + m_objects.m_randomDwellings.size());
         for (auto& obj : m_objects.m_randomDwellings) {
             int level = obj.m_hasLevel ? rng->genMinMax(obj.m_minLevel, obj.m_maxLevel) + 1 : 0;
             // @todo: faction
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <compare>
+#include <map>
 #include <set>
 #include <optional>
 
@@ -559,6 +560,19 @@ struct FHLossCondition {
     bool operator==(const FHLossCondition&) const noexcept = default;
 };
 
+// Candidate lists used by FHMap::derandomize(); depend only on database, so they can be built once and reused for many maps.
+struct MAPUTIL_EXPORT FHDerandomizePools {
+    explicit FHDerandomizePools(const Core::IGameDatabase* database);
+
+    const Core::IGameDatabase* const m_database;
+
+    std::vector<Core::LibraryResourceConstPtr>                                   m_resources;
+    std::map<FHRandomArtifact::Type, std::vector<Core::LibraryArtifactConstPtr>> m_artifacts;
+    std::map<int, std::vector<Core::LibraryUnitConstPtr>>                        m_units;     // by level, 0 = any level
+    std::map<int, std::vector<Core::LibraryDwellingConstPtr>>                    m_dwellings; // by level, 0 = any level
+    std::vector<Core::LibraryFactionConstPtr>                                    m_townFactions;
+};
+
 struct MAPUTIL_EXPORT FHMap {
     using PlayersMap = std::map<Core::LibraryPlayerConstPtr, FHPlayer>;
     using DefMap     = std::map<Core::LibraryObjectDefConstPtr, Core::LibraryObjectDef>;
@@ -646,36 +660,40 @@ struct MAPUTIL_EXPORT FHMap {
             (..., vis(std::get<Args>(t)));
         }
 
-        auto getAllContainers() const noexcept
+        template<typename Self>
+        static auto tieContainers(Self& self) noexcept
         {
             return std::tie(
-                m_resources,
-                m_resourcesRandom,
-                m_artifacts,
-                m_artifactsRandom,
-                m_monsters,
-                m_dwellings,
-                m_randomDwellings,
-                m_banks,
-                m_obstacles,
-                m_visitables,
-                m_controlledVisitables,
-                m_mines,
-                m_abandonedMines,
-                m_pandoras,
-                m_shrines,
-                m_skillHuts,
-                m_scholars,
-                m_questHuts,
-                m_questGuards,
-                m_localEvents,
-                m_signs,
-                m_garisons,
-                m_heroPlaceholders,
-                m_grails,
-                m_unknownObjects);
+                self.m_resources,
+                self.m_resourcesRandom,
+                self.m_artifacts,
+                self.m_artifactsRandom,
+                self.m_monsters,
+                self.m_dwellings,
+                self.m_randomDwellings,
+                self.m_banks,
+                self.m_obstacles,
+                self.m_visitables,
+                self.m_controlledVisitables,
+                self.m_mines,
+                self.m_abandonedMines,
+                self.m_pandoras,
+                self.m_shrines,
+                self.m_skillHuts,
+                self.m_scholars,
+                self.m_questHuts,
+                self.m_questGuards,
+                self.m_localEvents,
+                self.m_signs,
+                self.m_garisons,
+                self.m_heroPlaceholders,
+                self.m_grails,
+                self.m_unknownObjects);
         }
 
+        auto getAllContainers() const noexcept { return tieContainers(*this); }
+        auto getAllContainers() noexcept { return tieContainers(*this); }
+
         std::vector<const FHCommonObject*> getAllObjects() const noexcept
         {
             std::vector<const FHCommonObject*> result;
@@ -804,6 +822,7 @@ struct MAPUTIL_EXPORT FHMap {
 
     void rescaleToUserSize();
     void derandomize(Core::IRandomGenerator* rng);
+    void derandomize(Core::IRandomGenerator* rng, const FHDerandomizePools& pools);
 };
 
 // clang-format off
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2023 Smirnov Vladimir / mapron1@gmail.com
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file for details.
+ */
+#include "FHPreparedTemplate.hpp"
+
+#include "IGameDatabase.hpp"
+
+#include "LibraryFaction.hpp"
+#include "LibraryUnit.hpp"
+
+#include <cassert>
+
+namespace FreeHeroes {
+
+FHPreparedTemplate::FHPreparedTemplate(const Core::IGameDatabase* database, int width, int height, int depth, bool withTiles)
+    : m_database(database)
+{
+    auto& factions = m_database->factions()->records();
+    for (auto* faction : factions) {
+        if (faction->alignment == Core::LibraryFaction::Alignment::Special)
+            continue;
+        m_rewardFactions.push_back(faction);
+        if (faction->alignment == Core::LibraryFaction::Alignment::Independent)
+            continue;
+        m_playableFactions.push_back(faction);
+    }
+    assert(!m_playableFactions.empty());
+    auto&                                  units = m_database->units()->records();
+    std::vector<Core::LibraryUnitConstPtr> guardUnits;
+    for (auto* unit : units) {
+        if (unit->faction->alignment == Core::LibraryFaction::Alignment::Special)
+            continue;
+        guardUnits.push_back(unit);
+    }
+    m_guardUnits.init(guardUnits);
+
+    m_obstacleIndex.init(m_database);
+    if (withTiles)
+        m_tileContainer.init(width, height, depth);
+}
+
+FHPreparedTemplateConstPtr FHPreparedTemplateCache::get(const Core::IGameDatabase* database, int width, int height, int depth)
+{
+    std::lock_guard lock(m_mutex);
+    auto&           prepared = m_prepared[Key{ database, width, height, depth }];
+    if (!prepared)
+        prepared = std::make_shared<const FHPreparedTemplate>(database, width, height, depth);
+    return prepared;
+}
+
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2023 Smirnov Vladimir / mapron1@gmail.com
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file for details.
+ */
+#pragma once
+
+#include "RmgUtil/GuardUnitTable.hpp"
+#include "RmgUtil/MapTileContainer.hpp"
+#include "RmgUtil/ObstacleHelper.hpp"
+
+#include "LibraryFwd.hpp"
+
+#include "MapUtilExport.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace FreeHeroes {
+
+namespace Core {
+class IGameDatabase;
+}
+
+// Seed-independent part of generation setup for given database and map size.
+// Immutable after construction, so one instance can be shared by concurrent runs.
+class MAPUTIL_EXPORT FHPreparedTemplate {
+public:
+    // withTiles=false leaves m_tileContainer empty, for a single run that builds its tiles in place.
+    FHPreparedTemplate(const Core::IGameDatabase* database, int width, int height, int depth, bool withTiles = true);
+
+    const Core::IGameDatabase* const m_database;
+
+    std::vector<Core::LibraryFactionConstPtr> m_playableFactions;
+    std::vector<Core::LibraryFactionConstPtr> m_rewardFactions;
+    GuardUnitTable                            m_guardUnits;
+
+    ObstacleIndex    m_obstacleIndex;
+    MapTileContainer m_tileContainer; // every run makes own copy
+};
+using FHPreparedTemplateConstPtr = std::shared_ptr<const FHPreparedTemplate>;
+
+// Thread-safe storage of prepared data, built on first request.
+class MAPUTIL_EXPORT FHPreparedTemplateCache {
+public:
+    FHPreparedTemplateConstPtr get(const Core::IGameDatabase* database, int width, int height, int depth);
+
+private:
+    using Key = std::tuple<const Core::IGameDatabase*, int, int, int>;
+
+    std::mutex                                m_mutex;
+    std::map<Key, FHPreparedTemplateConstPtr> m_prepared;
+};
+
+}
@@ -36,23 +36,14 @@ void FHTemplate::rescaleToSize(int newMapSize, int oldWidth, int oldHeight)
 Core::MapScore operator+(const Core::MapScore& l, const Core::MapScore& r)
 {
     FreeHeroes::Core::MapScore result = l;
-
-    for (const auto& [key, val] : r)
-        result[key] += val;
-
+    result += r;
     return result;
 }
 
 Core::MapScore operator-(const Core::MapScore& l, const Core::MapScore& r)
 {
     FreeHeroes::Core::MapScore result = l;
-
-    for (const auto& [key, val] : r) {
-        result[key] -= val;
-        if (!result[key])
-            result.erase(key);
-    }
-
+    result -= r;
     return result;
 }
 
@@ -71,18 +62,12 @@ std::ostream& operator<<(std::ostream& stream, const Core::MapScore& score)
 
 int64_t maxScoreValue(const Core::MapScore& score)
 {
-    int64_t result = 0;
-    for (const auto& [attr, value] : score)
-        result = std::max(result, value);
-    return result;
+    return score.maxValue();
 }
 
 int64_t totalScoreValue(const Core::MapScore& score)
 {
-    int64_t result = 0;
-    for (const auto& [attr, value] : score)
-        result += value;
-    return result;
+    return score.total();
 }
 
 }
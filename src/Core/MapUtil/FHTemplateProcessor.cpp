@@ -25,6 +25,7 @@
 #include <functional>
 #include <stdexcept>
 #include <iostream>
+#include <iterator>
 
 namespace Mernel::Reflection {
 
@@ -77,14 +78,18 @@ struct DistanceRecord {
 
 }
 
-FHTemplateProcessor::FHTemplateProcessor(FHMap&                  map,
-                                         Core::IRandomGenerator* rng,
-                                         std::ostream&           logOutput,
-                                         const std::string&      stopAfterStage,
-                                         const std::string&      debugStage,
-                                         const std::string&      tileZoneFilter,
-                                         int                     stopAfterHeat,
-                                         bool                    extraLogs)
+FHTemplateProcessor::FHTemplateProcessor(FHMap&                     map,
+                                         Core::IRandomGenerator*    rng,
+                                         std::ostream&              logOutput,
+                                         const std::string&         stopAfterStage,
+                                         const std::string&         debugStage,
+                                         const std::string&         tileZoneFilter,
+                                         int                        stopAfterHeat,
+                                         bool                       extraLogs,
+                                         const Mernel::std_path&    checkpointDir,
+                                         const Mernel::std_path&    resumeFrom,
+                                         FHPreparedTemplateConstPtr prepared,
+                                         size_t                     threads)
     : m_map(map)
     , m_database(map.m_database)
     , m_rng(rng)
@@ -94,33 +99,45 @@ FHTemplateProcessor::FHTemplateProcessor(FHMap&                  map,
     , m_tileZoneFilter(tileZoneFilter)
     , m_stopAfterHeat(stopAfterHeat)
     , m_extraLogging(extraLogs)
+    , m_checkpointDir(checkpointDir)
+    , m_resumeFrom(resumeFrom)
+    , m_preparedShared(prepared != nullptr)
+    , m_prepared(prepared ? prepared : std::make_shared<const FHPreparedTemplate>(map.m_database, map.m_tileMap.m_width, map.m_tileMap.m_height, map.m_tileMap.m_depth, false))
+    , m_threads(threads)
 {
-    auto& factions = m_database->factions()->records();
-    for (auto* faction : factions) {
-        if (faction->alignment == Core::LibraryFaction::Alignment::Special)
-            continue;
-        m_rewardFactions.push_back(faction);
-        if (faction->alignment == Core::LibraryFaction::Alignment::Independent)
-            continue;
-        m_playableFactions.push_back(faction);
+    const MapTileContainer& preparedTiles = m_prepared->m_tileContainer;
+    if (m_preparedShared && (m_prepared->m_database != m_database || preparedTiles.m_width != map.m_tileMap.m_width || preparedTiles.m_height != map.m_tileMap.m_height || preparedTiles.m_depth != map.m_tileMap.m_depth))
+        throw std::runtime_error("Prepared template does not match map database or size");
+
+    for (auto* faction : m_prepared->m_playableFactions) {
         for (auto* hero : faction->heroes) {
             if (!map.m_disabledHeroes.isDisabled(map.m_isWaterMap, hero))
                 m_heroPool.insert(hero);
         }
     }
-    assert(!m_playableFactions.empty());
-    auto& units = m_database->units()->records();
-    for (auto* unit : units) {
-        if (unit->faction->alignment == Core::LibraryFaction::Alignment::Special)
-            continue;
-        m_guardUnits.push_back(unit);
-    }
 }
 
-std::string FHTemplateProcessor::stageToString(Stage stage)
+const char* FHTemplateProcessor::stageToString(Stage stage)
 {
-    auto str = Mernel::Reflection::EnumTraits::enumToString(stage);
-    return std::string(str.begin(), str.end());
+    // string literals, so result can be used as a profiler scope key.
+    static constexpr const char* s_names[] = {
+        "Invalid",
+        "ZoneCenterPlacement",
+        "ZoneTilesInitial",
+        "BorderRoads",
+        "TownsPlacement",
+        "CellSegmentation",
+        "RoadsPlacement",
+        "SegmentationRefinement",
+        "HeatMap",
+        "Rewards",
+        "CorrectObjectTerrains",
+        "Obstacles",
+        "Guards",
+        "PlayerInfo",
+    };
+    const auto index = static_cast<size_t>(stage);
+    return index < std::size(s_names) ? s_names[index] : s_names[0];
 }
 
 void FHTemplateProcessor::run()
@@ -135,7 +152,10 @@ void FHTemplateProcessor::run()
     m_logOutput << baseIndent << "Start generating map (seed=" << m_map.m_seed << ") " << m_map.m_tileMap.m_width << "x" << m_map.m_tileMap.m_height
                 << " " << (m_map.m_tileMap.m_depth == 2 ? "+U" : "no U") << "\n";
 
-    m_tileContainer.init(m_map.m_tileMap.m_width, m_map.m_tileMap.m_height, m_map.m_tileMap.m_depth);
+    if (m_preparedShared)
+        m_tileContainer = m_prepared->m_tileContainer;
+    else
+        m_tileContainer.init(m_map.m_tileMap.m_width, m_map.m_tileMap.m_height, m_map.m_tileMap.m_depth);
 
     for (const auto& [key, rngZone] : m_map.m_template.m_zones) {
         if (rngZone.m_player == nullptr || !rngZone.m_player->isPlayable)
@@ -242,6 +262,14 @@ void FHTemplateProcessor::run()
         tileZone.m_roadTypes[RoadLevel::NoRoad]       = FHRoadType::None;
     }
 
+    Stage resumedStage = Stage::Invalid;
+    if (!m_resumeFrom.empty()) {
+        resumedStage = loadCheckpoint(m_resumeFrom);
+        m_logOutput << baseIndent << "resumed from checkpoint: " << Mernel::path2string(m_resumeFrom) << ", skipping stages up to " << stageToString(resumedStage) << "\n";
+    }
+    if (!m_checkpointDir.empty() && !Mernel::std_fs::exists(m_checkpointDir))
+        Mernel::std_fs::create_directories(m_checkpointDir);
+
     Mernel::ProfilerContext                profileContext;
     Mernel::ProfilerDefaultContextSwitcher switcher(profileContext);
 
@@ -258,14 +286,28 @@ void FHTemplateProcessor::run()
                          Stage::Obstacles,
                          Stage::Guards,
                          Stage::PlayerInfo }) {
+        if (stage <= resumedStage)
+            continue;
+
         m_currentStage = stage;
 
         Mernel::ScopeTimer timer;
         m_logOutput << baseIndent << "Start stage: " << stageToString(m_currentStage) << "\n";
-        runCurrentStage();
+        try {
+            // root scope of the stage, so profiler data below sums up to the stage time.
+            Mernel::ProfilerScope stageScope(stageToString(m_currentStage));
+            runCurrentStage();
+        }
+        catch (...) {
+            // failed runs still show how far they got.
+            m_stats.m_stageTimesUS.push_back({ stageToString(m_currentStage), timer.elapsedUS() });
+            m_stats.m_failedStage = stageToString(m_currentStage);
+            throw;
+        }
         {
             auto profilerStr = profileContext.printToStr();
             profileContext.clearAll();
+            m_stats.m_stageProfiles[stageToString(m_currentStage)] = profilerStr;
             std::string profilerStr2;
             for (size_t i = 0; i < profilerStr.size(); ++i) {
                 char c = profilerStr[i];
@@ -277,7 +319,15 @@ void FHTemplateProcessor::run()
                 m_logOutput << baseIndent << "Profiler data:\n"
                             << m_indent << profilerStr2;
         }
-        m_logOutput << baseIndent << "End stage: " << stageToString(m_currentStage) << " (" << timer.elapsedUS() << " us.)\n";
+        const int64_t stageTime = timer.elapsedUS();
+        m_stats.m_stageTimesUS.push_back({ stageToString(m_currentStage), stageTime });
+        m_logOutput << baseIndent << "End stage: " << stageToString(m_currentStage) << " (" << stageTime << " us.)\n";
+
+        if (!m_checkpointDir.empty()) {
+            const Mernel::std_path checkpointPath = m_checkpointDir / Mernel::string2path(std::string(stageToString(m_currentStage)) + ".fhrmgstate");
+            saveCheckpoint(checkpointPath);
+            m_logOutput << baseIndent << "checkpoint saved: " << Mernel::path2string(checkpointPath) << "\n";
+        }
 
         if (m_currentStage == m_stopAfter) {
             m_logOutput << baseIndent << "stopping further generation, as 'stopAfter' was provided.\n";
@@ -285,6 +335,18 @@ void FHTemplateProcessor::run()
         }
     }
 
+    for (const auto& tileZone : m_tileZones) {
+        auto& zoneStats                   = m_stats.m_zones[tileZone.m_id];
+        zoneStats.m_relativeSizeRequested = tileZone.m_rngZoneSettings.m_relativeSizeAvg;
+        zoneStats.m_relativeSize          = tileZone.m_relativeArea;
+        zoneStats.m_targetArea            = tileZone.m_absoluteArea;
+        zoneStats.m_placedArea            = tileZone.getPlacedArea();
+        for (const auto& [roadType, region] : tileZone.m_roads.m_byLevel) {
+            if (!region.empty())
+                zoneStats.m_roadLength[roadType] = region.size();
+        }
+    }
+
     placeTerrainZones();
     placeDebugInfo();
 }
@@ -358,7 +420,7 @@ void FHTemplateProcessor::runZoneTilesInitial()
     auto checkUnzoned = [this]() {
         bool result = true;
         for (auto& tileZone : m_tileZones) {
-            for (auto* cell : tileZone.m_area.m_innerArea) {
+            for (auto* cell : tileZone.m_area.getInnerArea()) {
                 if (cell->m_zone != &tileZone) {
                     auto zoneStr = cell->m_zone ? std::to_string(cell->m_zone->m_index) : std::string("NULL");
                     m_logOutput << m_indent << "Invalid zone cell:" << cell->toPrintableString()
@@ -382,7 +444,7 @@ void FHTemplateProcessor::runZoneTilesInitial()
 
     MapTileRegion placed;
     for (auto& tileZone : m_tileZones) {
-        placed.insert(tileZone.m_area.m_innerArea);
+        placed.insert(tileZone.m_area.getInnerArea());
     }
 
     for (auto* cell : m_tileContainer.m_all) {
@@ -392,7 +454,7 @@ void FHTemplateProcessor::runZoneTilesInitial()
     }
 
     for (auto& tileZone : m_tileZones) {
-        tileZone.m_centroid = tileZone.m_area.m_innerArea.makeCentroid(true);
+        tileZone.m_centroid = tileZone.m_area.getInnerArea().makeCentroid(true);
     }
 }
 
@@ -449,12 +511,12 @@ void FHTemplateProcessor::runTownsPlacement()
                 townTilePos.m_x -= x;
                 townTilePos.m_y -= y;
                 if (m_tileContainer.m_tileIndex.contains(townTilePos))
-                    townArea.m_innerArea.insert(m_tileContainer.m_tileIndex[townTilePos]);
+                    townArea.insertInner(m_tileContainer.m_tileIndex[townTilePos]);
             }
         }
         townArea.makeEdgeFromInnerArea();
-        tileZone.m_unpassableArea.insert(townArea.m_innerArea);
-        tileZone.m_innerAreaTownsBorders.insert(townArea.m_innerArea);
+        tileZone.m_unpassableArea.insert(townArea.getInnerArea());
+        tileZone.m_innerAreaTownsBorders.insert(townArea.getInnerArea());
         tileZone.m_innerAreaTownsBorders.insert(townArea.m_outsideEdge);
         tileZone.m_roadPotentialArea.insert(townArea.m_outsideEdge);
     };
@@ -481,7 +543,7 @@ void FHTemplateProcessor::runTownsPlacement()
 
             auto                    connectionTile = tileZone.m_namedTiles.at(town.m_closeToConnection);
             std::vector<MapTilePtr> tilesInRadius;
-            for (auto* zoneTile : tileZone.m_innerAreaUsable.m_innerArea) {
+            for (auto* zoneTile : tileZone.m_innerAreaUsable.getInnerArea()) {
                 auto distance = posDistance(connectionTile, zoneTile);
                 if (distance < radius - 1 || distance > radius + 1)
                     continue;
@@ -498,7 +560,7 @@ void FHTemplateProcessor::runTownsPlacement()
             if (!townPositions[0])
                 townPositions[0] = tileZone.m_centroid;
         } else {
-            auto&                      area = tileZone.m_innerAreaUsable.m_innerArea;
+            auto&                      area = tileZone.m_innerAreaUsable.getInnerArea();
             KMeansSegmentationSettings settings;
             const size_t               K = towns.size();
             {
@@ -572,11 +634,11 @@ void FHTemplateProcessor::runTownsPlacement()
 
         {
             MapTileRegionWithEdge areaTowns;
-            areaTowns.m_innerArea = tileZone.m_innerAreaTownsBorders;
+            areaTowns.setInnerArea(tileZone.m_innerAreaTownsBorders);
             areaTowns.makeEdgeFromInnerArea();
             tileZone.m_innerAreaTownsBorders.insert(areaTowns.m_outsideEdge);
         }
-        tileZone.m_innerAreaUsable.m_innerArea.erase(tileZone.m_unpassableArea);
+        tileZone.m_innerAreaUsable.eraseInner(tileZone.m_unpassableArea);
         tileZone.m_innerAreaUsable.makeEdgeFromInnerArea();
     }
 }
@@ -673,6 +735,7 @@ void FHTemplateProcessor::runRewards()
 
             auto distributionResult = distributionResultCopy;
 
+            m_stats.m_zones[tileZone.m_id].m_rewardAttempts = i;
             if (objectDistributor.makeInitialDistribution(distributionResult, zoneObjectGeneration)) {
                 objectDistributor.doPlaceDistribution(distributionResult);
                 distributionResultCopy = distributionResult;
@@ -712,6 +775,21 @@ void FHTemplateProcessor::runRewards()
             tileZone.m_needPlaceObstacles = needBeBlocked;
         }
 
+        {
+            const size_t generated       = distributionResultCopy.m_allOriginalIds.size();
+            const size_t placed          = distributionResultCopy.m_placedIds.size();
+            auto&        zoneStats       = m_stats.m_zones[tileZone.m_id];
+            zoneStats.m_generatedObjects = generated;
+            zoneStats.m_unplacedObjects  = generated > placed ? generated - placed : 0;
+            zoneStats.m_rewardScore.clear();
+            for (const auto& object : distributionResultCopy.m_allObjects) {
+                if (!object.m_absPos)
+                    continue;
+                for (const auto& [attr, value] : object.m_object->getScore())
+                    zoneStats.m_rewardScore[attr] += value;
+            }
+        }
+
         for (auto& guard : distributionResultCopy.m_guards) {
             guard.m_zone     = &tileZone;
             guard.m_joinable = true;
@@ -757,7 +835,7 @@ void FHTemplateProcessor::runCorrectObjectTerrains()
 
 void FHTemplateProcessor::runObstacles()
 {
-    ObstacleHelper obstacleHelper(m_map, m_tileZones, m_tileContainer, m_rng, m_database, m_logOutput);
+    ObstacleHelper obstacleHelper(m_map, m_tileZones, m_tileContainer, m_rng, m_prepared->m_obstacleIndex, m_logOutput);
     obstacleHelper.placeObstacles(3);
 
     for (auto& tileZone : m_tileZones) {
@@ -776,70 +854,32 @@ void FHTemplateProcessor::runGuards()
     const auto& diffSett = m_map.m_template.m_userSettings.m_difficulty;
     m_userMultiplyGuard  = m_rng->genMinMax(diffSett.m_minGuardsPercent, diffSett.m_maxGuardsPercent);
 
-    auto makeCandidates = [this](int64_t value) {
-        std::map<int, int> unitLevelScore;
-
-        for (Core::LibraryUnitConstPtr unit : m_guardUnits) {
-            auto possibleCount = getPossibleCount(unit, value);
-            if (possibleCount < 5)
-                continue;
-            if (possibleCount < 10 && unit->level < 50)
-                continue;
-
-            int score = 0;
-            if (possibleCount < 10)
-                score = 1;
-            else if (possibleCount < 25)
-                score = 2;
-            else if (possibleCount < 35)
-                score = 5;
-            else if (possibleCount < 50)
-                score = 3;
-            else if (possibleCount < 100)
-                score = 2;
-            else
-                score = 1;
-            unitLevelScore[unit->level / 10] += score;
-        }
-        auto      it                = std::max_element(unitLevelScore.begin(), unitLevelScore.end(), [](auto l, auto r) { return l.second < r.second; });
-        const int optimalGuardLevel = it->first;
-
-        std::vector<Core::LibraryUnitConstPtr> result;
-        for (Core::LibraryUnitConstPtr unit : m_guardUnits) {
-            auto possibleCount = getPossibleCount(unit, value);
-            if (possibleCount < 5)
-                continue;
-            if (possibleCount < 10 && unit->level < 50)
-                continue;
-            const int levelDiff = (unit->level / 10) - optimalGuardLevel;
-            if (levelDiff < -1 || levelDiff > 2)
-                continue;
-
-            if (unit->level < 80 && possibleCount >= 100)
-                continue;
-            result.push_back(unit);
-        }
-
-        return result;
-    };
+    // seed-independent part of guard values for all guards at once; dispersion is added in generation order.
+    std::vector<int64_t> guardValues(m_guards.size());
+    std::vector<int64_t> zonePercents(m_guards.size(), 100);
+    for (size_t i = 0; i < m_guards.size(); ++i) {
+        guardValues[i] = m_guards[i].m_value;
+        if (m_guards[i].m_zone)
+            zonePercents[i] = m_guards[i].m_zone->m_rngZoneSettings.m_zoneGuardPercent;
+    }
+    for (size_t i = 0; i < guardValues.size(); ++i)
+        guardValues[i] = guardValues[i] * m_userMultiplyGuard / 100 * zonePercents[i] / 100;
 
     std::map<std::string, size_t> nameIndex;
 
-    for (auto& guard : m_guards) {
-        int64_t value = guard.m_value;
-        if (value == 0)
+    for (size_t guardIndex = 0; guardIndex < m_guards.size(); ++guardIndex) {
+        auto& guard = m_guards[guardIndex];
+        if (guard.m_value == 0)
             continue;
 
-        value = value * m_userMultiplyGuard / 100;
-
+        int64_t value = guardValues[guardIndex];
         if (guard.m_zone) {
             const int64_t dispersionPercent = m_rng->genDispersed(0, guard.m_zone->m_rngZoneSettings.m_zoneGuardDispersion);
 
-            value = value * guard.m_zone->m_rngZoneSettings.m_zoneGuardPercent / 100;
             value += value * dispersionPercent / 100;
         }
 
-        std::vector<Core::LibraryUnitConstPtr> candidates = makeCandidates(value);
+        std::vector<Core::LibraryUnitConstPtr> candidates = m_prepared->m_guardUnits.makeCandidates(value);
 
         if (candidates.empty()) { // value is so low, nobody can guard so low value at least in group of 5
             continue;
@@ -856,6 +896,8 @@ void FHTemplateProcessor::runGuards()
         fhMonster.m_score        = guard.m_score;
         fhMonster.m_generationId = guard.m_generationId;
 
+        m_stats.m_guardValues.push_back(value);
+
         if (upgraded) {
             auto upCount = getPossibleCount(unit->upgrades[0], value);
             // let's say upgraded stack is 1/4 of stacks. Then recalc count taking an account 1/4 of value is upped.
@@ -945,12 +987,12 @@ void FHTemplateProcessor::placeTerrainZones()
     m_terrainPlaced = true;
 
     for (auto& tileZone : m_tileZones) {
-        for (auto* cell : tileZone.m_area.m_innerArea) {
-            auto& tile       = m_map.m_tileMap.get(cell->m_pos);
+        for (auto* cell : tileZone.m_area.getInnerArea()) {
+            auto tile        = m_map.m_tileMap.get(cell->m_pos);
             tile.m_terrainId = tileZone.m_terrain;
         }
     }
-    m_map.m_tileMap.determineViewRotation(m_database);
+    m_map.m_tileMap.determineViewRotation(m_database, m_threads);
     m_map.m_tileMap.makeRecommendedRotation();
     m_map.m_tileMap.makeRngView(m_rng, m_map.m_template.m_roughTilePercentage);
 }
@@ -1092,7 +1134,7 @@ void FHTemplateProcessor::placeDebugInfo()
 
 Core::LibraryFactionConstPtr FHTemplateProcessor::getRandomFaction(bool rewardOnly)
 {
-    auto& factions = rewardOnly ? m_rewardFactions : m_playableFactions;
+    auto& factions = rewardOnly ? m_prepared->m_rewardFactions : m_prepared->m_playableFactions;
     auto  result   = factions[m_rng->genSmall(factions.size() - 1)];
     return result;
 }
@@ -1101,7 +1143,7 @@ Core::LibraryFactionConstPtr FHTemplateProcessor::getRandomPlayableFaction(const
 {
     std::vector<Core::LibraryFactionConstPtr> factions;
     auto                                      excluded = getExcludedFactions(excludedZoneIds);
-    for (auto* faction : m_playableFactions)
+    for (auto* faction : m_prepared->m_playableFactions)
         if (!excluded.contains(faction))
             factions.push_back(faction);
 
@@ -1136,24 +1178,7 @@ Core::LibraryHeroConstPtr FHTemplateProcessor::getRandomHero(Core::LibraryFactio
 
 int FHTemplateProcessor::getPossibleCount(Core::LibraryUnitConstPtr unit, int64_t value) const
 {
-    auto possibleCount = value / unit->value;
-    if (possibleCount <= 1)
-        return possibleCount;
-    int64_t unitValue = unit->value;
-    int64_t coef1     = 100;
-    int64_t coef100   = 0;
-    if (possibleCount >= 100) {
-        coef1   = 0;
-        coef100 = 100;
-    } else {
-        coef1   = 100 - possibleCount + 1;
-        coef100 = possibleCount - 1;
-    }
-
-    unitValue = (coef1 * unit->guardMult1 + coef100 * unit->guardMult100) * unitValue / 10000;
-
-    possibleCount = value / unitValue;
-    return possibleCount;
+    return GuardUnitTable::getPossibleCount(unit, value);
 }
 
 std::set<Core::LibraryFactionConstPtr> FHTemplateProcessor::getExcludedFactions(const std::set<std::string>& zoneIds) const
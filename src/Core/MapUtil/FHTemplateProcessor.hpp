@@ -9,10 +9,14 @@
 #include "IRandomGenerator.hpp"
 
 #include "FHMap.hpp"
+#include "FHPreparedTemplate.hpp"
+#include "FHTemplateStats.hpp"
 
 #include "RmgUtil/MapGuard.hpp"
 #include "RmgUtil/TileZone.hpp"
 
+#include "MernelPlatform/FsUtils.hpp"
+
 #include "MapUtilExport.hpp"
 
 #include <stdexcept>
@@ -22,14 +26,18 @@ namespace FreeHeroes {
 
 class MAPUTIL_EXPORT FHTemplateProcessor {
 public:
-    FHTemplateProcessor(FHMap&                  map,
-                        Core::IRandomGenerator* rng,
-                        std::ostream&           logOutput,
-                        const std::string&      stopAfterStage,
-                        const std::string&      debugStage,
-                        const std::string&      tileZoneFilter,
-                        int                     stopAfterHeat,
-                        bool                    extraLogs);
+    FHTemplateProcessor(FHMap&                     map,
+                        Core::IRandomGenerator*    rng,
+                        std::ostream&              logOutput,
+                        const std::string&         stopAfterStage,
+                        const std::string&         debugStage,
+                        const std::string&         tileZoneFilter,
+                        int                        stopAfterHeat,
+                        bool                       extraLogs,
+                        const Mernel::std_path&    checkpointDir,
+                        const Mernel::std_path&    resumeFrom,
+                        FHPreparedTemplateConstPtr prepared = nullptr, // made for this run if not provided
+                        size_t                     threads = 0);       // for tile view detection; 0 - chosen by hardware
 
     enum class Stage
     {
@@ -48,10 +56,14 @@ public:
         Guards,
         PlayerInfo,
     };
-    static std::string stageToString(Stage stage);
+    static const char* stageToString(Stage stage);
+
+    using RunStats = FHTemplateRunStats;
 
     void run();
 
+    const RunStats& getStats() const { return m_stats; }
+
 private:
     void runCurrentStage();
     void runZoneCenterPlacement();
@@ -71,6 +83,10 @@ private:
     void placeTerrainZones();
     void placeDebugInfo();
 
+    // binary snapshot of all intermediate generation state; defined in FHTemplateProcessorCheckpoint.cpp
+    void  saveCheckpoint(const Mernel::std_path& path) const;
+    Stage loadCheckpoint(const Mernel::std_path& path);
+
     Core::LibraryFactionConstPtr           getRandomFaction(bool rewardOnly);
     Core::LibraryFactionConstPtr           getRandomPlayableFaction(const std::set<std::string>& excludedZoneIds);
     Core::LibraryHeroConstPtr              getRandomHero(Core::LibraryFactionConstPtr faction);
@@ -106,6 +122,11 @@ private:
     const std::string                m_tileZoneFilter;
     const int                        m_stopAfterHeat;
     const bool                       m_extraLogging;
+    const Mernel::std_path           m_checkpointDir;
+    const Mernel::std_path           m_resumeFrom;
+    const bool                       m_preparedShared; // shared template tiles are copied, otherwise they are built in place
+    const FHPreparedTemplateConstPtr m_prepared;
+    const size_t                     m_threads;
 
 private:
     MapTileContainer       m_tileContainer;
@@ -117,16 +138,14 @@ private:
 
     std::string m_indent;
 
-    std::vector<Core::LibraryFactionConstPtr> m_playableFactions;
-    std::vector<Core::LibraryFactionConstPtr> m_rewardFactions;
-    std::vector<Core::LibraryUnitConstPtr>    m_guardUnits;
-
     MapGuardList m_guards;
     int64_t      m_userMultiplyGuard = 100;
 
     std::map<Core::LibraryPlayerConstPtr, PlayerInfo, CmpPlayers> m_playerInfo;
 
     std::set<Core::LibraryHeroConstPtr> m_heroPool;
+
+    RunStats m_stats;
 };
 
 }
@@ -0,0 +1,459 @@
+/*
+ * Copyright (C) 2023 Smirnov Vladimir / mapron1@gmail.com
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file for details.
+ */
+#include "FHTemplateProcessor.hpp"
+
+#include "MernelPlatform/ByteOrderStream.hpp"
+#include "MernelPlatform/FileIOUtils.hpp"
+#include "MernelPlatform/FileFormatJson.hpp"
+
+#include "LibraryFaction.hpp"
+#include "LibraryHero.hpp"
+#include "LibraryPlayer.hpp"
+#include "LibraryTerrain.hpp"
+
+#include <stdexcept>
+
+namespace FreeHeroes {
+using namespace Mernel;
+
+namespace {
+constexpr const std::string_view g_signature{ "FHRMGCP" };
+constexpr const uint32_t         g_version = 1;
+constexpr const uint32_t         g_noTile  = uint32_t(-1);
+constexpr const int32_t          g_noZone  = -1;
+
+// Tiles are stored as linear indices; container is always rebuilt from map size, so indices are stable.
+class CheckpointWriter {
+public:
+    CheckpointWriter(ByteOrderDataStreamWriter& stream, const MapTileContainer& container)
+        : m_stream(stream)
+        , m_container(container)
+    {}
+
+    void writeTile(MapTileConstPtr tile)
+    {
+        if (!tile) {
+            m_stream << g_noTile;
+            return;
+        }
+        const FHPos& pos = tile->m_pos;
+        m_stream << static_cast<uint32_t>((pos.m_z * m_container.m_height + pos.m_y) * m_container.m_width + pos.m_x);
+    }
+
+    void writeRegion(const MapTileRegion& region)
+    {
+        m_stream.writeSize(region.size());
+        for (auto* tile : region)
+            writeTile(tile);
+    }
+
+    void writeRegionWithEdge(const MapTileRegionWithEdge& region)
+    {
+        writeRegion(region.getInnerArea());
+        writeRegion(region.m_innerEdge);
+        writeRegion(region.m_outsideEdge);
+    }
+
+    template<class T, T invalid>
+    void writeMapping(const RegionMapping<T, invalid>& mapping)
+    {
+        m_stream.writeSize(mapping.m_byLevel.size());
+        for (const auto& [level, region] : mapping.m_byLevel) {
+            m_stream << static_cast<int32_t>(level);
+            writeRegion(region);
+        }
+    }
+
+    template<class T>
+    void writeId(const T* record)
+    {
+        m_stream << (record ? record->id : std::string());
+    }
+
+    ByteOrderDataStreamWriter& m_stream;
+    const MapTileContainer&    m_container;
+};
+
+class CheckpointReader {
+public:
+    CheckpointReader(ByteOrderDataStreamReader& stream, const MapTileContainer& container)
+        : m_stream(stream)
+        , m_container(container)
+    {}
+
+    MapTilePtr readTile()
+    {
+        uint32_t index = 0;
+        m_stream >> index;
+        if (index == g_noTile)
+            return nullptr;
+        if (index >= m_container.m_all.size())
+            throw std::runtime_error("Checkpoint contains tile index out of map bounds: " + std::to_string(index));
+        return m_container.m_all[index];
+    }
+
+    MapTileRegion readRegion()
+    {
+        MapTilePtrSortedList list;
+        list.resize(m_stream.readSize());
+        for (auto& tile : list)
+            tile = readTile();
+        return MapTileRegion(std::move(list));
+    }
+
+    void readRegionWithEdge(MapTileRegionWithEdge& region)
+    {
+        region.setInnerArea(readRegion());
+        region.m_innerEdge   = readRegion();
+        region.m_outsideEdge = readRegion();
+    }
+
+    template<class T, T invalid>
+    void readMapping(RegionMapping<T, invalid>& mapping)
+    {
+        mapping = {};
+
+        const size_t levels = m_stream.readSize();
+        for (size_t i = 0; i < levels; ++i) {
+            const T       level  = static_cast<T>(m_stream.readScalar<int32_t>());
+            MapTileRegion region = readRegion();
+            for (auto* tile : region)
+                mapping.m_tileLevels[tile] = level;
+            mapping.m_all.insert(region);
+            mapping.m_byLevel[level] = std::move(region);
+        }
+    }
+
+    template<class Container>
+    auto readId(const Container& container)
+    {
+        std::string id;
+        m_stream >> id;
+        decltype(container->find(id)) record = nullptr;
+        if (id.empty())
+            return record;
+        record = container->find(id);
+        if (!record)
+            throw std::runtime_error("Checkpoint refers to unknown library id: " + id);
+        return record;
+    }
+
+    ByteOrderDataStreamReader& m_stream;
+    const MapTileContainer&    m_container;
+};
+
+}
+
+void FHTemplateProcessor::saveCheckpoint(const Mernel::std_path& path) const
+{
+    ByteArrayHolder           holder;
+    ByteOrderBuffer           bobuffer(holder);
+    ByteOrderDataStreamWriter stream(bobuffer, ByteOrderDataStream::s_littleEndian);
+    CheckpointWriter          writer(stream, m_tileContainer);
+
+    stream.writeBlock(g_signature.data(), g_signature.size());
+    stream << g_version << static_cast<int32_t>(m_currentStage);
+    stream << m_map.m_seed << m_tileContainer.m_width << m_tileContainer.m_height << m_tileContainer.m_depth;
+
+    stream << m_rng->serialize();
+    stream << m_userMultiplyGuard << m_terrainPlaced;
+
+    stream.writeSize(m_heroPool.size());
+    for (auto* hero : m_heroPool)
+        writer.writeId(hero);
+
+    stream.writeSize(m_playerInfo.size());
+    for (const auto& [player, info] : m_playerInfo) {
+        writer.writeId(player);
+        writer.writeId(info.m_faction);
+        stream << info.m_hasMainTown << static_cast<uint64_t>(info.m_mainTownMapIndex) << info.m_team;
+        writer.writeId(info.m_startingHero);
+        writer.writeId(info.m_extraHero);
+        stream << static_cast<int32_t>(info.m_startingHeroGen) << static_cast<int32_t>(info.m_extraHeroGen);
+    }
+
+    // stages only put roads into the tile map; terrain is placed after the last stage.
+    std::vector<uint8_t> roads(m_map.m_tileMap.m_roadTypes.size());
+    for (size_t i = 0; i < roads.size(); ++i)
+        roads[i] = static_cast<uint8_t>(m_map.m_tileMap.m_roadTypes[i]);
+    stream << roads;
+
+    {
+        FHMap partial{ .m_database = m_database };
+        partial.m_players         = m_map.m_players;
+        partial.m_wanderingHeroes = m_map.m_wanderingHeroes;
+        partial.m_towns           = m_map.m_towns;
+        partial.m_objects         = m_map.m_objects;
+        partial.m_debugTiles      = m_map.m_debugTiles;
+
+        PropertyTree json;
+        partial.toJson(json);
+        stream << writeJsonToBuffer(json);
+    }
+
+    stream.writeSize(m_tileZones.size());
+    for (const auto& tileZone : m_tileZones) {
+        stream << tileZone.m_id;
+        writer.writeId(tileZone.m_terrain);
+        writer.writeId(tileZone.m_mainTownFaction);
+        writer.writeId(tileZone.m_rewardsFaction);
+        writer.writeId(tileZone.m_dwellFaction);
+        writer.writeId(tileZone.m_player);
+        writer.writeTile(tileZone.m_startTile);
+        writer.writeTile(tileZone.m_centroid);
+
+        writer.writeRegionWithEdge(tileZone.m_area);
+        writer.writeRegionWithEdge(tileZone.m_innerAreaUsable);
+        writer.writeRegion(tileZone.m_innerAreaTownsBorders);
+
+        stream.writeSize(tileZone.m_innerAreaSegments.size());
+        for (const auto& seg : tileZone.m_innerAreaSegments) {
+            writer.writeRegionWithEdge(seg);
+            stream << static_cast<uint64_t>(seg.m_index);
+        }
+        writer.writeRegion(tileZone.m_innerAreaSegmentsUnited);
+
+        writer.writeRegion(tileZone.m_roadIgnoredNodes);
+        writer.writeRegion(tileZone.m_roadPotentialArea);
+        writer.writeMapping(tileZone.m_roads);
+        writer.writeMapping(tileZone.m_nodes);
+        stream.writeSize(tileZone.m_roadTypes.size());
+        for (const auto& [level, type] : tileZone.m_roadTypes)
+            stream << static_cast<int32_t>(level) << static_cast<int32_t>(type);
+
+        for (const MapTileRegion* region : { &tileZone.m_midTownNodes,
+                                             &tileZone.m_midExitNodes,
+                                             &tileZone.m_protectionBorder,
+                                             &tileZone.m_unpassableArea,
+                                             &tileZone.m_needPlaceObstacles,
+                                             &tileZone.m_needPlaceObstaclesTentative,
+                                             &tileZone.m_rewardTilesSpacing,
+                                             &tileZone.m_rewardTilesFailure })
+            writer.writeRegion(*region);
+
+        writer.writeMapping(tileZone.m_heatForSegments);
+        writer.writeMapping(tileZone.m_heatForRoads);
+        writer.writeMapping(tileZone.m_heatForAll);
+        writer.writeMapping(tileZone.m_distances);
+
+        stream.writeSize(tileZone.m_namedTiles.size());
+        for (const auto& [name, tile] : tileZone.m_namedTiles) {
+            stream << name;
+            writer.writeTile(tile);
+        }
+
+        stream << tileZone.m_relativeArea << tileZone.m_absoluteArea << tileZone.m_absoluteRadius;
+    }
+
+    stream.writeSize(m_guards.size());
+    for (const auto& guard : m_guards) {
+        stream << guard.m_value << guard.m_id << guard.m_mirrorFromId;
+        writer.writeTile(guard.m_pos);
+        stream << (guard.m_zone ? static_cast<int32_t>(guard.m_zone->m_index) : g_noZone);
+        stream.writeSize(guard.m_score.size());
+        for (const auto& [attr, value] : guard.m_score)
+            stream << static_cast<int32_t>(attr) << value;
+        stream << guard.m_generationId << guard.m_joinable;
+    }
+
+    std::vector<int32_t> tileZoneIndex;
+    tileZoneIndex.reserve(m_tileContainer.m_all.size());
+    for (auto* tile : m_tileContainer.m_all)
+        tileZoneIndex.push_back(tile->m_zone ? static_cast<int32_t>(tile->m_zone->m_index) : g_noZone);
+    stream << tileZoneIndex;
+
+    writeFileFromHolder(path, holder);
+}
+
+FHTemplateProcessor::Stage FHTemplateProcessor::loadCheckpoint(const Mernel::std_path& path)
+{
+    ByteArrayHolder           holder = readFileIntoHolder(path);
+    ByteOrderBuffer           bobuffer(holder);
+    ByteOrderDataStreamReader stream(bobuffer, ByteOrderDataStream::s_littleEndian);
+    CheckpointReader          reader(stream, m_tileContainer);
+
+    {
+        std::string str;
+        str.resize(g_signature.size());
+        stream.readBlock(str.data(), g_signature.size());
+        if (str != g_signature)
+            throw std::runtime_error("Invalid generation checkpoint provided: " + path2string(path));
+    }
+    if (stream.readScalar<uint32_t>() != g_version)
+        throw std::runtime_error("Unsupported generation checkpoint version: " + path2string(path));
+
+    const Stage stage = static_cast<Stage>(stream.readScalar<int32_t>());
+    if (stage <= Stage::Invalid || stage > Stage::PlayerInfo)
+        throw std::runtime_error("Invalid stage stored in generation checkpoint: " + path2string(path));
+
+    {
+        uint64_t seed   = 0;
+        int      width  = 0;
+        int      height = 0;
+        int      depth  = 0;
+        stream >> seed >> width >> height >> depth;
+        if (seed != m_map.m_seed)
+            throw std::runtime_error("Checkpoint was made for seed=" + std::to_string(seed) + ", current seed=" + std::to_string(m_map.m_seed));
+        if (width != m_tileContainer.m_width || height != m_tileContainer.m_height || depth != m_tileContainer.m_depth)
+            throw std::runtime_error("Checkpoint was made for different map size");
+    }
+
+    {
+        std::vector<uint8_t> rngState;
+        stream >> rngState;
+        m_rng->deserialize(rngState);
+    }
+    stream >> m_userMultiplyGuard >> m_terrainPlaced;
+
+    m_heroPool.clear();
+    for (size_t i = 0, size = stream.readSize(); i < size; ++i)
+        m_heroPool.insert(reader.readId(m_database->heroes()));
+
+    m_playerInfo.clear();
+    for (size_t i = 0, size = stream.readSize(); i < size; ++i) {
+        auto  player            = reader.readId(m_database->players());
+        auto& info              = m_playerInfo[player];
+        info.m_faction          = reader.readId(m_database->factions());
+        info.m_hasMainTown      = stream.readScalar<bool>();
+        info.m_mainTownMapIndex = static_cast<size_t>(stream.readScalar<uint64_t>());
+        info.m_team             = stream.readScalar<int>();
+        info.m_startingHero     = reader.readId(m_database->heroes());
+        info.m_extraHero        = reader.readId(m_database->heroes());
+        info.m_startingHeroGen  = static_cast<HeroGeneration>(stream.readScalar<int32_t>());
+        info.m_extraHeroGen     = static_cast<HeroGeneration>(stream.readScalar<int32_t>());
+    }
+
+    {
+        std::vector<uint8_t> roads;
+        stream >> roads;
+        if (roads.size() != m_map.m_tileMap.m_roadTypes.size())
+            throw std::runtime_error("Checkpoint tile map size mismatch");
+        for (size_t i = 0; i < roads.size(); ++i)
+            m_map.m_tileMap.m_roadTypes[i] = static_cast<FHRoadType>(roads[i]);
+    }
+
+    {
+        std::string buffer;
+        stream >> buffer;
+        FHMap partial{ .m_database = m_database };
+        partial.fromJson(readJsonFromBuffer(buffer));
+        m_map.m_players         = std::move(partial.m_players);
+        m_map.m_wanderingHeroes = std::move(partial.m_wanderingHeroes);
+        m_map.m_towns           = std::move(partial.m_towns);
+        m_map.m_objects         = std::move(partial.m_objects);
+        m_map.m_debugTiles      = std::move(partial.m_debugTiles);
+    }
+
+    if (stream.readSize() != m_tileZones.size())
+        throw std::runtime_error("Checkpoint zone count does not match the template");
+
+    // zone settings are intentionally left as loaded from the current template, so late stages can be tuned.
+    for (auto& tileZone : m_tileZones) {
+        std::string id;
+        stream >> id;
+        if (id != tileZone.m_id)
+            throw std::runtime_error("Checkpoint zone '" + id + "' does not match template zone '" + tileZone.m_id + "'");
+
+        tileZone.m_terrain         = reader.readId(m_database->terrains());
+        tileZone.m_mainTownFaction = reader.readId(m_database->factions());
+        tileZone.m_rewardsFaction  = reader.readId(m_database->factions());
+        tileZone.m_dwellFaction    = reader.readId(m_database->factions());
+        tileZone.m_player          = reader.readId(m_database->players());
+        tileZone.m_startTile       = reader.readTile();
+        tileZone.m_centroid        = reader.readTile();
+
+        reader.readRegionWithEdge(tileZone.m_area);
+        reader.readRegionWithEdge(tileZone.m_innerAreaUsable);
+        tileZone.m_innerAreaTownsBorders = reader.readRegion();
+
+        tileZone.m_innerAreaSegments.resize(stream.readSize());
+        for (auto& seg : tileZone.m_innerAreaSegments) {
+            reader.readRegionWithEdge(seg);
+            seg.m_index = static_cast<size_t>(stream.readScalar<uint64_t>());
+        }
+        tileZone.m_innerAreaSegmentsUnited = reader.readRegion();
+
+        tileZone.m_roadIgnoredNodes  = reader.readRegion();
+        tileZone.m_roadPotentialArea = reader.readRegion();
+        reader.readMapping(tileZone.m_roads);
+        reader.readMapping(tileZone.m_nodes);
+        tileZone.m_roadTypes.clear();
+        for (size_t i = 0, size = stream.readSize(); i < size; ++i) {
+            const auto level = static_cast<RoadLevel>(stream.readScalar<int32_t>());
+            const auto type  = static_cast<FHRoadType>(stream.readScalar<int32_t>());
+
+            tileZone.m_roadTypes[level] = type;
+        }
+
+        for (MapTileRegion* region : { &tileZone.m_midTownNodes,
+                                       &tileZone.m_midExitNodes,
+                                       &tileZone.m_protectionBorder,
+                                       &tileZone.m_unpassableArea,
+                                       &tileZone.m_needPlaceObstacles,
+                                       &tileZone.m_needPlaceObstaclesTentative,
+                                       &tileZone.m_rewardTilesSpacing,
+                                       &tileZone.m_rewardTilesFailure })
+            *region = reader.readRegion();
+
+        reader.readMapping(tileZone.m_heatForSegments);
+        reader.readMapping(tileZone.m_heatForRoads);
+        reader.readMapping(tileZone.m_heatForAll);
+        reader.readMapping(tileZone.m_distances);
+
+        tileZone.m_namedTiles.clear();
+        for (size_t i = 0, size = stream.readSize(); i < size; ++i) {
+            std::string name;
+            stream >> name;
+            tileZone.m_namedTiles[name] = reader.readTile();
+        }
+
+        stream >> tileZone.m_relativeArea >> tileZone.m_absoluteArea >> tileZone.m_absoluteRadius;
+    }
+
+    auto readZone = [this](int32_t index) -> TileZone* {
+        if (index == g_noZone)
+            return nullptr;
+        if (index < 0 || static_cast<size_t>(index) >= m_tileZones.size())
+            throw std::runtime_error("Checkpoint contains invalid zone index: " + std::to_string(index));
+        return &m_tileZones[index];
+    };
+
+    m_guards.clear();
+    m_guards.resize(stream.readSize());
+    for (auto& guard : m_guards) {
+        stream >> guard.m_value >> guard.m_id >> guard.m_mirrorFromId;
+        guard.m_pos  = reader.readTile();
+        guard.m_zone = readZone(stream.readScalar<int32_t>());
+        for (size_t i = 0, size = stream.readSize(); i < size; ++i) {
+            const auto attr = static_cast<Core::ScoreAttr>(stream.readScalar<int32_t>());
+            stream >> guard.m_score[attr];
+        }
+        stream >> guard.m_generationId >> guard.m_joinable;
+    }
+
+    {
+        std::vector<int32_t> tileZoneIndex;
+        stream >> tileZoneIndex;
+        if (tileZoneIndex.size() != m_tileContainer.m_all.size())
+            throw std::runtime_error("Checkpoint tile zone index size mismatch");
+        for (size_t i = 0; i < tileZoneIndex.size(); ++i) {
+            auto* tile            = m_tileContainer.m_all[i];
+            tile->m_zone          = readZone(tileZoneIndex[i]);
+            tile->m_segmentMedium = nullptr;
+        }
+    }
+    for (auto& tileZone : m_tileZones) {
+        for (auto& seg : tileZone.m_innerAreaSegments) {
+            for (auto* tile : seg.getInnerArea())
+                tile->m_segmentMedium = &seg;
+        }
+    }
+
+    m_currentStage = stage;
+    return stage;
+}
+
+}
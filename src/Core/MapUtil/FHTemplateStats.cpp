@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2023 Smirnov Vladimir / mapron1@gmail.com
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file for details.
+ */
+#include "FHTemplateStats.hpp"
+
+#include "FHTileMapReflection.hpp"
+#include "LibraryReflection.hpp"
+
+#include <algorithm>
+
+namespace FreeHeroes {
+using namespace Mernel;
+
+namespace {
+
+template<class Enum>
+std::string enumToStr(Enum value)
+{
+    auto str = Reflection::EnumTraits::enumToString(value);
+    return std::string(str.begin(), str.end());
+}
+
+// nearest-rank percentile of sorted samples.
+template<class T>
+const T& percentile(const std::vector<T>& sorted, int percent)
+{
+    const size_t rank = (sorted.size() * percent + 99) / 100;
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+}
+
+std::vector<std::pair<std::string, int64_t>> FHTemplateRunStats::makeMetrics() const
+{
+    std::vector<std::pair<std::string, int64_t>> result;
+    for (const auto& [stage, time] : m_stageTimesUS)
+        result.push_back({ "stage." + stage + ".us", time });
+
+    for (const auto& [zoneId, zone] : m_zones) {
+        const std::string prefix = "zone." + zoneId + ".";
+        result.push_back({ prefix + "placedArea", zone.m_placedArea });
+        if (zone.m_targetArea)
+            result.push_back({ prefix + "areaDeficitPercent", (zone.m_targetArea - zone.m_placedArea) * 100 / zone.m_targetArea });
+        result.push_back({ prefix + "unplacedObjects", zone.m_unplacedObjects });
+        result.push_back({ prefix + "rewardAttempts", zone.m_rewardAttempts });
+        for (const auto& [attr, value] : zone.m_rewardScore)
+            result.push_back({ prefix + "reward." + enumToStr(attr), value });
+        for (const auto& [roadType, length] : zone.m_roadLength)
+            result.push_back({ prefix + "road." + enumToStr(roadType), length });
+    }
+
+    int64_t guardTotal = 0;
+    for (int64_t value : m_guardValues)
+        guardTotal += value;
+    result.push_back({ "guards.count", static_cast<int64_t>(m_guardValues.size()) });
+    result.push_back({ "guards.total", guardTotal });
+    return result;
+}
+
+void FHTemplateRunStats::toJson(Mernel::PropertyTree& data) const
+{
+    data.convertToMap();
+    PropertyTree& stages = data["stagesUS"];
+    stages.convertToMap();
+    for (const auto& [stage, time] : m_stageTimesUS)
+        stages[stage] = PropertyTreeScalar(time);
+    if (!m_failedStage.empty())
+        data["failedStage"] = PropertyTreeScalar(m_failedStage);
+
+    PropertyTree& profiles = data["stageProfiles"];
+    profiles.convertToMap();
+    for (const auto& [stage, profile] : m_stageProfiles)
+        profiles[stage] = PropertyTreeScalar(profile);
+
+    PropertyTree& zones = data["zones"];
+    zones.convertToMap();
+    for (const auto& [zoneId, zone] : m_zones) {
+        PropertyTree& zoneJson            = zones[zoneId];
+        zoneJson["relativeSizeRequested"] = PropertyTreeScalar(zone.m_relativeSizeRequested);
+        zoneJson["relativeSize"]          = PropertyTreeScalar(zone.m_relativeSize);
+        zoneJson["targetArea"]            = PropertyTreeScalar(zone.m_targetArea);
+        zoneJson["placedArea"]            = PropertyTreeScalar(zone.m_placedArea);
+        zoneJson["generatedObjects"]      = PropertyTreeScalar(zone.m_generatedObjects);
+        zoneJson["unplacedObjects"]       = PropertyTreeScalar(zone.m_unplacedObjects);
+        zoneJson["rewardAttempts"]        = PropertyTreeScalar(zone.m_rewardAttempts);
+
+        PropertyTree& reward = zoneJson["reward"];
+        reward.convertToMap();
+        for (const auto& [attr, value] : zone.m_rewardScore)
+            reward[enumToStr(attr)] = PropertyTreeScalar(value);
+
+        PropertyTree& roads = zoneJson["roads"];
+        roads.convertToMap();
+        for (const auto& [roadType, length] : zone.m_roadLength)
+            roads[enumToStr(roadType)] = PropertyTreeScalar(length);
+    }
+
+    PropertyTree& guards = data["guards"];
+    guards.convertToList();
+    for (int64_t value : m_guardValues)
+        guards.append(PropertyTreeScalar(value));
+}
+
+void FHTemplateStatsAggregator::addRun(uint64_t seed, const FHTemplateRunStats& stats)
+{
+    m_runs++;
+    for (const auto& [metric, value] : stats.makeMetrics())
+        addSample(metric, value, seed);
+
+    // each guard is a separate sample of strength distribution.
+    for (int64_t value : stats.m_guardValues)
+        addSample("guards.value", value, seed);
+}
+
+void FHTemplateStatsAggregator::addFailure(uint64_t seed, const std::string& error)
+{
+    m_runs++;
+    Failure& failure = m_failures[error];
+    failure.m_count++;
+    if (failure.m_seeds.size() < s_maxOutliers)
+        failure.m_seeds.push_back(seed);
+}
+
+void FHTemplateStatsAggregator::addSample(const std::string& metric, int64_t value, uint64_t seed)
+{
+    Metric& state = m_metrics[metric];
+    state.m_min   = state.m_count ? std::min(state.m_min, value) : value;
+    state.m_max   = state.m_count ? std::max(state.m_max, value) : value;
+    state.m_sum += value;
+    state.m_count++;
+
+    const Sample sample{ value, seed };
+    // reservoir sampling (algorithm R), keeps uniform subset of all samples.
+    if (state.m_reservoir.size() < s_reservoirSize) {
+        state.m_reservoir.push_back(sample);
+    } else {
+        m_reservoirState ^= m_reservoirState << 13;
+        m_reservoirState ^= m_reservoirState >> 7;
+        m_reservoirState ^= m_reservoirState << 17;
+        const uint64_t index = m_reservoirState % static_cast<uint64_t>(state.m_count);
+        if (index < s_reservoirSize)
+            state.m_reservoir[index] = sample;
+    }
+
+    auto lessValue    = [](const Sample& l, const Sample& r) { return l.m_value < r.m_value; };
+    auto greaterValue = [](const Sample& l, const Sample& r) { return l.m_value > r.m_value; };
+    auto keepExtreme  = [&sample](std::vector<Sample>& heap, auto&& cmp) {
+        if (heap.size() < s_maxOutliers) {
+            heap.push_back(sample);
+            std::push_heap(heap.begin(), heap.end(), cmp);
+        } else if (cmp(sample, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), cmp);
+            heap.back() = sample;
+            std::push_heap(heap.begin(), heap.end(), cmp);
+        }
+    };
+    keepExtreme(state.m_lowest, lessValue);
+    keepExtreme(state.m_highest, greaterValue);
+}
+
+void FHTemplateStatsAggregator::toJson(Mernel::PropertyTree& data) const
+{
+    data.convertToMap();
+    data["runs"] = PropertyTreeScalar(static_cast<int64_t>(m_runs));
+
+    int64_t       failuresCount = 0;
+    PropertyTree& failures      = data["failures"];
+    failures.convertToList();
+    for (const auto& [error, failure] : m_failures) {
+        failuresCount += failure.m_count;
+        PropertyTree row;
+        row["error"] = PropertyTreeScalar(error);
+        row["count"] = PropertyTreeScalar(failure.m_count);
+        PropertyTree& seedsJson = row["seeds"];
+        seedsJson.convertToList();
+        for (uint64_t seed : failure.m_seeds)
+            seedsJson.append(PropertyTreeScalar(static_cast<int64_t>(seed)));
+        failures.append(std::move(row));
+    }
+    data["failed"] = PropertyTreeScalar(failuresCount);
+
+    PropertyTree& metrics = data["metrics"];
+    metrics.convertToMap();
+    for (const auto& [metric, state] : m_metrics) {
+        std::vector<int64_t> sorted;
+        sorted.reserve(state.m_reservoir.size());
+        for (const auto& sample : state.m_reservoir)
+            sorted.push_back(sample.m_value);
+        std::sort(sorted.begin(), sorted.end());
+
+        const int64_t q1  = percentile(sorted, 25);
+        const int64_t q3  = percentile(sorted, 75);
+        const int64_t iqr = q3 - q1;
+
+        PropertyTree& row = metrics[metric];
+        row["count"]      = PropertyTreeScalar(state.m_count);
+        row["min"]        = PropertyTreeScalar(state.m_min);
+        row["max"]        = PropertyTreeScalar(state.m_max);
+        row["mean"]       = PropertyTreeScalar(static_cast<double>(state.m_sum) / state.m_count);
+        row["p5"]         = PropertyTreeScalar(percentile(sorted, 5));
+        row["p25"]        = PropertyTreeScalar(q1);
+        row["p50"]        = PropertyTreeScalar(percentile(sorted, 50));
+        row["p75"]        = PropertyTreeScalar(q3);
+        row["p95"]        = PropertyTreeScalar(percentile(sorted, 95));
+        row["p99"]        = PropertyTreeScalar(percentile(sorted, 99));
+
+        // Tukey far-out fences; most extreme samples first.
+        std::vector<Sample> candidates = state.m_lowest;
+        candidates.insert(candidates.end(), state.m_highest.cbegin(), state.m_highest.cend());
+        std::erase_if(candidates, [q1, q3, iqr](const Sample& sample) { return sample.m_value >= q1 - 3 * iqr && sample.m_value <= q3 + 3 * iqr; });
+        std::sort(candidates.begin(), candidates.end(), [q1, q3](const Sample& l, const Sample& r) {
+            auto distance = [q1, q3](int64_t value) { return value < q1 ? q1 - value : value - q3; };
+            return std::pair(distance(l.m_value), l.m_seed) > std::pair(distance(r.m_value), r.m_seed);
+        });
+        candidates.erase(std::unique(candidates.begin(), candidates.end(), [](const Sample& l, const Sample& r) { return l.m_value == r.m_value && l.m_seed == r.m_seed; }), candidates.end());
+
+        PropertyTree& outliers = row["outliers"];
+        outliers.convertToList();
+        for (size_t i = 0; i < candidates.size() && i < s_maxOutliers; ++i) {
+            PropertyTree outlier;
+            outlier["seed"]  = PropertyTreeScalar(static_cast<int64_t>(candidates[i].m_seed));
+            outlier["value"] = PropertyTreeScalar(candidates[i].m_value);
+            outliers.append(std::move(outlier));
+        }
+    }
+}
+
+}
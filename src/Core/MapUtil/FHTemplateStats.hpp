@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2023 Smirnov Vladimir / mapron1@gmail.com
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file for details.
+ */
+#pragma once
+
+#include "MernelPlatform/PropertyTree.hpp"
+
+#include "FHPos.hpp"
+#include "MapScore.hpp"
+
+#include "MapUtilExport.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace FreeHeroes {
+
+// Metrics of one template generation run.
+struct MAPUTIL_EXPORT FHTemplateRunStats {
+    struct Zone {
+        int64_t m_relativeSizeRequested = 0; // m_relativeSizeAvg from template
+        int64_t m_relativeSize          = 0; // value after dispersion
+        int64_t m_targetArea            = 0;
+        int64_t m_placedArea            = 0;
+        int64_t m_generatedObjects      = 0;
+        int64_t m_unplacedObjects       = 0;
+        int64_t m_rewardAttempts        = 0;
+
+        Core::MapScore                m_rewardScore; // sum of placed objects score
+        std::map<FHRoadType, int64_t> m_roadLength;
+    };
+
+    std::vector<std::pair<std::string, int64_t>> m_stageTimesUS; // includes failed stage
+    std::map<std::string, Zone>                  m_zones;
+    std::vector<int64_t>                         m_guardValues;
+    std::string                                  m_failedStage;   // stage which has thrown, empty for successful run
+    std::map<std::string, std::string>           m_stageProfiles; // stage => ProfilerContext output
+
+    // flat "group.name.metric" => value list, used for aggregation.
+    std::vector<std::pair<std::string, int64_t>> makeMetrics() const;
+
+    void toJson(Mernel::PropertyTree& data) const;
+};
+
+// Collects metrics of many runs and summarises them with percentiles and outliers.
+// Memory per metric is bounded: count/min/max/sum are exact, percentiles come from a fixed size reservoir
+// (exact while number of samples does not exceed it), outliers are searched among kept lowest and highest samples.
+class MAPUTIL_EXPORT FHTemplateStatsAggregator {
+public:
+    static constexpr size_t s_reservoirSize = 4096;
+    static constexpr size_t s_maxOutliers   = 20;
+
+    void addRun(uint64_t seed, const FHTemplateRunStats& stats);
+    void addFailure(uint64_t seed, const std::string& error);
+    void addSample(const std::string& metric, int64_t value, uint64_t seed);
+
+    void toJson(Mernel::PropertyTree& data) const;
+
+private:
+    struct Sample {
+        int64_t  m_value = 0;
+        uint64_t m_seed  = 0;
+    };
+
+    struct Metric {
+        int64_t m_count = 0;
+        int64_t m_min   = 0;
+        int64_t m_max   = 0;
+        int64_t m_sum   = 0;
+
+        std::vector<Sample> m_reservoir;
+        std::vector<Sample> m_lowest;  // max-heap by value, s_maxOutliers smallest samples
+        std::vector<Sample> m_highest; // min-heap by value, s_maxOutliers largest samples
+    };
+
+    struct Failure {
+        int64_t               m_count = 0;
+        std::vector<uint64_t> m_seeds; // first s_maxOutliers only
+    };
+
+    std::map<std::string, Metric>  m_metrics;
+    std::map<std::string, Failure> m_failures; // error message => seeds
+    size_t                         m_runs           = 0;
+    uint64_t                       m_reservoirState = 0x9E3779B97F4A7C15ULL; // fixed, so report depends on input only
+};
+
+}
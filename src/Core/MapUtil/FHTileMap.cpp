@@ -10,9 +10,13 @@
 
 #include "MernelPlatform/Logger.hpp"
 
+#include "ParallelChunks.hpp"
+
 #include <array>
 #include <functional>
 #include <fstream>
+#include <limits>
+#include <span>
 #include <cassert>
 
 namespace FreeHeroes {
@@ -65,66 +69,9 @@ struct TileNeightbours {
 
     TileInfo T2, L2, R2, B2;
 
-    bool m_coastal = false;
-
     bool m_flippedHor  = false;
     bool m_flippedVert = false;
 
-    void read(Core::LibraryTerrainConstPtr dirtTerrain,
-              Core::LibraryTerrainConstPtr sandTerrain,
-              Core::LibraryTerrainConstPtr waterTerrain,
-              const FHTileMap&             map,
-              const FHTileMap::Tile&       tileXX,
-              const FHPos&                 pos)
-    {
-        TL.set(tileXX.TL);
-        TR.set(tileXX.TR);
-        BL.set(tileXX.BL);
-        BR.set(tileXX.BR);
-
-        auto* terrTL = map.getNeighbour(pos, -1, -1).m_terrainId;
-        auto* terrTC = map.getNeighbour(pos, +0, -1).m_terrainId;
-        auto* terrTR = map.getNeighbour(pos, +1, -1).m_terrainId;
-        auto* terrCL = map.getNeighbour(pos, -1, +0).m_terrainId;
-        auto* terrCR = map.getNeighbour(pos, +1, +0).m_terrainId;
-        auto* terrBL = map.getNeighbour(pos, -1, +1).m_terrainId;
-        auto* terrBC = map.getNeighbour(pos, +0, +1).m_terrainId;
-        auto* terrBR = map.getNeighbour(pos, +1, +1).m_terrainId;
-
-        auto* terrT2 = map.getNeighbour(pos, +0, -2).m_terrainId;
-        auto* terrL2 = map.getNeighbour(pos, -2, +0).m_terrainId;
-        auto* terrR2 = map.getNeighbour(pos, +2, +0).m_terrainId;
-        auto* terrB2 = map.getNeighbour(pos, +0, +2).m_terrainId;
-
-        TL.EQ = terrTL == tileXX.m_terrainId;
-        TR.EQ = terrTR == tileXX.m_terrainId;
-        BL.EQ = terrBL == tileXX.m_terrainId;
-        BR.EQ = terrBR == tileXX.m_terrainId;
-
-        TC.EQ = terrTC == tileXX.m_terrainId;
-        CL.EQ = terrCL == tileXX.m_terrainId;
-        CR.EQ = terrCR == tileXX.m_terrainId;
-        BC.EQ = terrBC == tileXX.m_terrainId;
-
-        T2.EQ = terrT2 == tileXX.m_terrainId;
-        L2.EQ = terrL2 == tileXX.m_terrainId;
-        R2.EQ = terrR2 == tileXX.m_terrainId;
-        B2.EQ = terrB2 == tileXX.m_terrainId;
-
-        {
-            const bool waterNeighbour = false
-                                        || terrTL == waterTerrain
-                                        || terrTC == waterTerrain
-                                        || terrTR == waterTerrain
-                                        || terrCL == waterTerrain
-                                        || terrCR == waterTerrain
-                                        || terrBL == waterTerrain
-                                        || terrBC == waterTerrain
-                                        || terrBR == waterTerrain;
-            m_coastal = tileXX.m_terrainId != waterTerrain && waterNeighbour;
-        }
-    }
-
     TileNeightbours flipped(bool vertical, bool horizontal)
     {
         if (!vertical && !horizontal)
@@ -439,9 +386,287 @@ const std::vector<PatternMatcher> g_matchers{
         },
     },
 };
+
+struct PatternMatch {
+    BorderClass m_class    = BorderClass::Invalid;
+    BorderType  m_type     = BorderType::Invalid;
+    bool        m_flipHor  = false;
+    bool        m_flipVert = false;
+};
+
+// Every possible terrain neighbourhood resolved through g_matchers once; matches are kept in the order they are applied.
+// Key bits: 0-7 - TL, TR, BL, BR subtiles; 8-15 - terrain equality of TL, TR, BL, BR, T2, L2, R2, B2; 16 - tile is dirt.
+class TerrainPatternTable {
+public:
+    static constexpr uint32_t s_keyCount = 1U << 17;
+
+    static const TerrainPatternTable& get()
+    {
+        static const TerrainPatternTable table;
+        return table;
+    }
+
+    static uint32_t makeKey(const FHTileMap::TileViewState& tile, uint32_t eqMask, bool isDirt)
+    {
+        const uint32_t subtiles = static_cast<uint32_t>(tile.TL)
+                                  | static_cast<uint32_t>(tile.TR) << 2
+                                  | static_cast<uint32_t>(tile.BL) << 4
+                                  | static_cast<uint32_t>(tile.BR) << 6;
+        return subtiles | eqMask << 8 | uint32_t(isDirt) << 16;
+    }
+
+    std::span<const PatternMatch> find(uint32_t key) const
+    {
+        return { m_matches.data() + m_offsets[key], m_matches.data() + m_offsets[key + 1] };
+    }
+
+private:
+    TerrainPatternTable()
+    {
+        m_offsets.reserve(s_keyCount + 1);
+        for (uint32_t key = 0; key < s_keyCount; ++key) {
+            m_offsets.push_back(static_cast<uint32_t>(m_matches.size()));
+            const std::array<FHTileMap::SubtileType, 4> subtiles{
+                static_cast<FHTileMap::SubtileType>(key & 3U),
+                static_cast<FHTileMap::SubtileType>(key >> 2 & 3U),
+                static_cast<FHTileMap::SubtileType>(key >> 4 & 3U),
+                static_cast<FHTileMap::SubtileType>(key >> 6 & 3U),
+            };
+            if (std::find(subtiles.cbegin(), subtiles.cend(), FHTileMap::SubtileType::Invalid) != subtiles.cend())
+                continue;
+
+            TileNeightbours tilen;
+            tilen.TL.set(subtiles[0]);
+            tilen.TR.set(subtiles[1]);
+            tilen.BL.set(subtiles[2]);
+            tilen.BR.set(subtiles[3]);
+            tilen.TL.EQ = key & (1U << 8);
+            tilen.TR.EQ = key & (1U << 9);
+            tilen.BL.EQ = key & (1U << 10);
+            tilen.BR.EQ = key & (1U << 11);
+            tilen.T2.EQ = key & (1U << 12);
+            tilen.L2.EQ = key & (1U << 13);
+            tilen.R2.EQ = key & (1U << 14);
+            tilen.B2.EQ = key & (1U << 15);
+            const bool isDirt = key & (1U << 16);
+
+            const std::array<TileNeightbours, 4> flipConfigs{
+                { tilen, tilen.flipped(true, false), tilen.flipped(false, true), tilen.flipped(true, true) }
+            };
+            for (const TileNeightbours& t : flipConfigs) {
+                for (const auto& matcher : g_matchers) {
+                    if (!matcher.m_doFlipHor && t.m_flippedHor)
+                        continue;
+                    if (!matcher.m_doFlipVert && t.m_flippedVert)
+                        continue;
+                    if (isDirt && !matcher.m_useOnDirt)
+                        continue;
+
+                    if (matcher.m_f(t, false))
+                        m_matches.push_back({ matcher.m_class, matcher.m_type, t.m_flippedHor, t.m_flippedVert });
+                    if (matcher.m_class == BorderClass::NormalDirt && matcher.m_f(t, true))
+                        m_matches.push_back({ BorderClass::NormalSand, matcher.m_type, t.m_flippedHor, t.m_flippedVert });
+                }
+            }
+        }
+        m_offsets.push_back(static_cast<uint32_t>(m_matches.size()));
+    }
+
+    std::vector<uint32_t>     m_offsets;
+    std::vector<PatternMatch> m_matches;
+};
+
+// view range and recommended flip for a road or river tile.
+struct LineViewRule {
+    uint8_t m_viewMin  = 9;
+    uint8_t m_viewMax  = 10;
+    bool    m_flipHor  = false;
+    bool    m_flipVert = false;
+};
+using LineViewRules = std::array<LineViewRule, 256>;
+
+// bit of the 8-neighbour byte: TL, T, TR, L, R, BL, B, BR.
+constexpr int neighbourBit(int dx, int dy)
+{
+    const int index = (dy + 1) * 3 + (dx + 1);
+    return index < 4 ? index : index - 1;
+}
+
+// same rule chain for every flip, first match wins; input is 'neighbour continues the line' per 8-neighbour byte.
+LineViewRules makeLineViewRules(int orderCount, auto&& matchRule)
+{
+    LineViewRules rules;
+    for (int mask = 0; mask < 256; ++mask) {
+        auto e = [mask](int dx, int dy) -> bool { return mask & (1 << neighbourBit(dx, dy)); };
+        [&rules, &e, &matchRule, mask, orderCount]() {
+            for (int order = 0; order < orderCount; ++order) {
+                for (int flipHor = 0; flipHor <= 1; ++flipHor) {
+                    for (int flipVert = 0; flipVert <= 1; ++flipVert) {
+                        /* TL  T  TR
+                         *  L  X   R
+                         * BL  B  BR
+                         */
+                        const int sx = flipHor ? -1 : +1;
+                        const int sy = flipVert ? -1 : +1;
+
+                        LineViewRule rule{ .m_flipHor = bool(flipHor), .m_flipVert = bool(flipVert) };
+                        if (matchRule(rule, order, e(sx, 0), e(-sx, 0), e(0, -sy), e(0, sy), e(sx, -sy), e(-sx, sy))) {
+                            rules[mask] = rule;
+                            return;
+                        }
+                    }
+                }
+            }
+        }();
+    }
+    return rules;
+}
+
+const LineViewRules g_roadRules = makeLineViewRules(3, [](LineViewRule& rule, int order, bool eR, bool eL, bool eT, bool eB, bool eTR, bool eBL) {
+    auto setView = [&rule](uint8_t min, uint8_t max) {
+        rule.m_viewMin = min;
+        rule.m_viewMax = max;
+    };
+
+    if (false) {
+    } else if (order == 0 && eR && !eL && !eT && eB && (eTR || eBL)) {
+        setView(2, 5);
+    } else if (order == 1 && eR && eL && eT && eB) {
+        setView(16, 16);
+    } else if (order == 1 && eR && eL && !eT && eB) {
+        setView(8, 9);
+    } else if (order == 1 && eR && !eL && eT && eB) {
+        setView(6, 7);
+    } else if (order == 1 && !eR && !eL && eT && eB) {
+        setView(10, 11);
+    } else if (order == 1 && eR && eL && !eT && !eB) {
+        setView(12, 13);
+    } else if (order == 1 && eR && !eL && !eT && eB) {
+        setView(0, 1);
+    } else if (order == 2 && !eR && !eL && !eT && eB) {
+        setView(14, 14);
+    } else if (order == 2 && eR && !eL && !eT && !eB) {
+        setView(15, 15);
+    } else if (order == 2 && !eR && !eL && !eT && !eB) {
+        setView(14, 14);
+        rule.m_flipHor  = false;
+        rule.m_flipVert = true;
+    } else {
+        return false;
+    }
+    return true;
+});
+
+const LineViewRules g_riverRules = makeLineViewRules(2, [](LineViewRule& rule, int order, bool eR, bool eL, bool eT, bool eB, bool, bool) {
+    auto setView = [&rule](uint8_t min, uint8_t max) {
+        rule.m_viewMin = min;
+        rule.m_viewMax = max;
+    };
+
+    if (false) {
+    } else if (order == 0 && eR && eL && eT && eB) {
+        setView(4, 4);
+    } else if (order == 0 && eR && eL && !eT && eB) {
+        setView(5, 6);
+    } else if (order == 0 && eR && !eL && eT && eB) {
+        setView(7, 8);
+    } else if (order == 0 && !eR && !eL && eT && eB) {
+        setView(9, 10);
+    } else if (order == 0 && eR && eL && !eT && !eB) {
+        setView(11, 12);
+    } else if (order == 0 && eR && !eL && !eT && eB) {
+        setView(0, 3);
+    } else if (order == 1 && !eR && !eL && !eT && eB) {
+        setView(9, 10);
+    } else if (order == 1 && !eR && !eL && eT && !eB) {
+        setView(9, 10);
+    } else if (order == 1 && eR && !eL && !eT && !eB) {
+        setView(11, 12);
+    } else if (order == 1 && !eR && eL && !eT && !eB) {
+        setView(11, 12);
+    } else {
+        return false;
+    }
+    return true;
+});
+
+// Copy of one tile property with 'margin' extra tiles around every level, so neighbour lookup is a plain offset.
+template<class T>
+struct PaddedGrid {
+    int            m_margin = 0;
+    int            m_width  = 0;
+    int            m_height = 0;
+    std::vector<T> m_values;
+
+    PaddedGrid(const FHTileMap& map, int margin, auto&& getter)
+        : m_margin(margin)
+        , m_width(map.m_width + 2 * margin)
+        , m_height(map.m_height + 2 * margin)
+    {
+        m_values.reserve(static_cast<size_t>(m_width) * m_height * map.m_depth);
+        for (int z = 0; z < map.m_depth; ++z) {
+            for (int y = -margin; y < map.m_height + margin; ++y) {
+                for (int x = -margin; x < map.m_width + margin; ++x)
+                    m_values.push_back(getter(x, y, z));
+            }
+        }
+    }
+
+    const T* row(int y, int z) const
+    {
+        return m_values.data() + (static_cast<size_t>(z) * m_height + y + m_margin) * m_width + m_margin;
+    }
+};
+
+// Calls f(y, z) for every map row; rows are split into contiguous chunks processed on separate threads.
+void forEachRowParallel(const FHTileMap& map, size_t threads, auto&& f)
+{
+    constexpr int s_minTilesPerChunk = 4096;
+
+    const size_t rows   = map.m_height * map.m_depth;
+    const size_t chunks = getParallelChunks(rows, s_minTilesPerChunk / std::max(map.m_width, 1), threads);
+    forEachChunkParallel(rows, chunks, chunks, [&map, &f](size_t, size_t begin, size_t end) {
+        for (size_t row = begin; row < end; ++row)
+            f(static_cast<int>(row % map.m_height), static_cast<int>(row / map.m_height));
+    });
 }
 
-bool FHTileMap::Tile::setViewBorderSpecial(Core::LibraryTerrain::BorderType borderType)
+// lineId(tile index) is 0 for tiles without a road/river; neighbour continues the line when its id is the same.
+void determineLineViewRotation(FHTileMap& map, size_t threads, const LineViewRules& rules, FHTileMap::TileViewRange FHTileMap::TileViewState::*view, auto&& lineId)
+{
+    const PaddedGrid<uint8_t> grid(map, 1, [&map, &lineId](int x, int y, int z) -> uint8_t {
+        return map.inBounds(x, y) ? lineId(map.index(x, y, z)) : 0;
+    });
+    const int stride = grid.m_width;
+
+    forEachRowParallel(map, threads, [&map, &grid, &rules, view, stride](int y, int z) {
+        const uint8_t* ids = grid.row(y, z);
+        for (int x = 0; x < map.m_width; ++x) {
+            const uint8_t* center = ids + x;
+            if (!*center)
+                continue;
+
+            uint32_t mask = 0;
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    if ((dx || dy) && center[dy * stride + dx] == *center)
+                        mask |= 1U << neighbourBit(dx, dy);
+                }
+            }
+            const LineViewRule& rule = rules[mask];
+            auto&               tv   = map.m_viewStates[map.index(x, y, z)].*view;
+
+            tv.m_viewMin             = rule.m_viewMin;
+            tv.m_viewMax             = rule.m_viewMax;
+            tv.m_recommendedFlipHor  = rule.m_flipHor;
+            tv.m_recommendedFlipVert = rule.m_flipVert;
+        }
+    });
+}
+
+}
+
+bool FHTileMap::TileViewState::setViewBorderSpecial(Core::LibraryTerrain::BorderType borderType)
 {
     auto& pp = m_terrainId->presentationParams;
 
@@ -454,7 +679,7 @@ bool FHTileMap::Tile::setViewBorderSpecial(Core::LibraryTerrain::BorderType bord
     return true;
 }
 
-bool FHTileMap::Tile::setViewBorderMixed(Core::LibraryTerrain::BorderType borderType)
+bool FHTileMap::TileViewState::setViewBorderMixed(Core::LibraryTerrain::BorderType borderType)
 {
     auto& pp = m_terrainId->presentationParams;
 
@@ -467,7 +692,7 @@ bool FHTileMap::Tile::setViewBorderMixed(Core::LibraryTerrain::BorderType border
     return true;
 }
 
-bool FHTileMap::Tile::setViewBorderSandOrDirt(Core::LibraryTerrain::BorderType borderType, bool sandBorder)
+bool FHTileMap::TileViewState::setViewBorderSandOrDirt(Core::LibraryTerrain::BorderType borderType, bool sandBorder)
 {
     auto& pp = m_terrainId->presentationParams;
 
@@ -499,7 +724,7 @@ bool FHTileMap::Tile::setViewBorderSandOrDirt(Core::LibraryTerrain::BorderType b
     return true;
 }
 
-bool FHTileMap::Tile::setViewCenter()
+bool FHTileMap::TileViewState::setViewCenter()
 {
     if (m_terrainId) {
         auto& pp         = m_terrainId->presentationParams;
@@ -511,7 +736,7 @@ bool FHTileMap::Tile::setViewCenter()
     return true;
 }
 
-bool FHTileMap::Tile::setView(Core::LibraryTerrain::BorderClass bc, Core::LibraryTerrain::BorderType borderType)
+bool FHTileMap::TileViewState::setView(Core::LibraryTerrain::BorderClass bc, Core::LibraryTerrain::BorderType borderType)
 {
     switch (bc) {
         case Core::LibraryTerrain::BorderClass::NormalDirt:
@@ -531,7 +756,7 @@ bool FHTileMap::Tile::setView(Core::LibraryTerrain::BorderClass bc, Core::Librar
     }
 }
 
-void FHTileMap::Tile::updateMinMax()
+void FHTileMap::TileViewState::updateMinMax()
 {
     m_terrainView.m_viewMin = static_cast<uint8_t>(m_tileOffset);
     const int clearCount    = m_tileCountClear > 0 ? m_tileCountClear : m_tileCount;
@@ -541,338 +766,131 @@ void FHTileMap::Tile::updateMinMax()
 
 void FHTileMap::determineTerrainViewRotation(Core::LibraryTerrainConstPtr dirtTerrain,
                                              Core::LibraryTerrainConstPtr sandTerrain,
-                                             Core::LibraryTerrainConstPtr waterTerrain)
+                                             Core::LibraryTerrainConstPtr waterTerrain,
+                                             size_t                       threads)
 {
-    //std::ofstream ofs("E:/debug.txt");
-    //int           row = 0;
-
-    eachPosTile([](const FHPos& pos, FHTileMap::Tile& XX, size_t) {
-        XX.TL = SubtileType::Invalid;
-        XX.TR = SubtileType::Invalid;
-        XX.BL = SubtileType::Invalid;
-        XX.BR = SubtileType::Invalid;
-    });
+    const TerrainPatternTable& patternTable = TerrainPatternTable::get();
 
-    eachPosTile([this,
-                 dirtTerrain,
-                 sandTerrain](const FHPos& pos, FHTileMap::Tile& XX, size_t) {
-        auto makest = [this,
-                       dirtTerrain,
-                       sandTerrain](const FHPos&     pos,
-                                    FHTileMap::Tile& tileXX,
-                                    SubtileType&     sub,
-                                    int              dx,
-                                    int              dy) {
-            // fo sand, it contains only 4 native 'sand' subtiles.
-            if (tileXX.m_terrainId == sandTerrain) {
-                sub = SubtileType::Native;
-                return;
+    // margin of 2 with clamped values, so T2/L2/R2/B2 are in range for every tile.
+    const PaddedGrid<Core::LibraryTerrainConstPtr> grid(*this, 2, [this](int x, int y, int z) {
+        return m_terrains[m_terrainIndexes[index(correctX(x), correctY(y), z)]];
+    });
+    const int stride = grid.m_width;
+
+    // equality bits of pattern key: TL, TR, BL, BR, T2, L2, R2, B2
+    static constexpr std::array<std::pair<int, int>, 8> s_eqOffsets{ { { -1, -1 }, { +1, -1 }, { -1, +1 }, { +1, +1 }, { 0, -2 }, { -2, 0 }, { +2, 0 }, { 0, +2 } } };
+
+    // x coordinate and pattern key of tiles which need a warning, for every row.
+    std::vector<std::vector<std::pair<int, uint32_t>>> warnings(m_height * m_depth);
+
+    m_viewStates.resize(totalSize());
+
+    forEachRowParallel(*this, threads, [this, &patternTable, &grid, &warnings, stride, dirtTerrain, sandTerrain, waterTerrain](int y, int z) {
+        const Core::LibraryTerrainConstPtr* terrains = grid.row(y, z);
+        for (int x = 0; x < m_width; ++x) {
+            const Core::LibraryTerrainConstPtr* center    = terrains + x;
+            const size_t                        tileIndex = index(x, y, z);
+            TileViewState&                      XX        = m_viewStates[tileIndex];
+            XX.m_terrainId                                = *center;
+
+            auto terrainAt = [center, stride](int dx, int dy) { return center[dy * stride + dx]; };
+
+            auto makest = [&XX, &terrainAt, dirtTerrain, sandTerrain](int dx, int dy) {
+                // fo sand, it contains only 4 native 'sand' subtiles.
+                if (XX.m_terrainId == sandTerrain)
+                    return SubtileType::Native;
+
+                const auto* terrDX  = terrainAt(dx, 0);
+                const auto* terrDY  = terrainAt(0, dy);
+                const auto* terrDXY = terrainAt(dx, dy);
+
+                const bool allEq = terrDX == XX.m_terrainId && terrDY == XX.m_terrainId && terrDXY == XX.m_terrainId;
+                if (allEq)
+                    return SubtileType::Native;
+
+                const bool anySand = terrDX->tileBase == Core::LibraryTerrain::TileBase::Sand
+                                     || terrDY->tileBase == Core::LibraryTerrain::TileBase::Sand
+                                     || terrDXY->tileBase == Core::LibraryTerrain::TileBase::Sand;
+                if (anySand)
+                    return SubtileType::Sand;
+                if (XX.m_terrainId->tileBase == Core::LibraryTerrain::TileBase::Sand)
+                    return SubtileType::Sand;
+
+                // dirt can contain mix of native 'dirt' and sand tiles.
+                if (XX.m_terrainId == dirtTerrain)
+                    return SubtileType::Native;
+                return SubtileType::Dirt;
+            };
+            XX.TL = makest(-1, -1);
+            XX.TR = makest(+1, -1);
+            XX.BL = makest(-1, +1);
+            XX.BR = makest(+1, +1);
+
+            bool waterNeighbour = false;
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx)
+                    waterNeighbour = waterNeighbour || ((dx || dy) && terrainAt(dx, dy) == waterTerrain);
             }
+            m_coastal[tileIndex] = XX.m_terrainId != waterTerrain && waterNeighbour;
 
-            const FHTileMap::Tile& tileDX  = getNeighbour(pos, dx, 0);
-            const FHTileMap::Tile& tileDY  = getNeighbour(pos, 0, dy);
-            const FHTileMap::Tile& tileDXY = getNeighbour(pos, dx, dy);
-
-            const bool eqDX  = tileDX.m_terrainId == tileXX.m_terrainId;
-            const bool eqDY  = tileDY.m_terrainId == tileXX.m_terrainId;
-            const bool eqDXY = tileDXY.m_terrainId == tileXX.m_terrainId;
-
-            const bool allEq = eqDX && eqDY && eqDXY;
-            if (allEq) {
-                sub = SubtileType::Native;
-                return;
+            if (XX.m_terrainId == sandTerrain) {
+                XX.setViewCenter();
+                continue;
             }
 
-            const bool sandDX  = tileDX.m_terrainId->tileBase == Core::LibraryTerrain::TileBase::Sand;
-            const bool sandDY  = tileDY.m_terrainId->tileBase == Core::LibraryTerrain::TileBase::Sand;
-            const bool sandDXY = tileDXY.m_terrainId->tileBase == Core::LibraryTerrain::TileBase::Sand;
-
-            const bool anySand = sandDX || sandDY || sandDXY;
-            if (anySand) {
-                sub = SubtileType::Sand;
-                return;
-            }
-            if (tileXX.m_terrainId->tileBase == Core::LibraryTerrain::TileBase::Sand) {
-                sub = SubtileType::Sand;
-                return;
+            uint32_t eqMask = 0;
+            for (size_t i = 0; i < s_eqOffsets.size(); ++i) {
+                if (terrainAt(s_eqOffsets[i].first, s_eqOffsets[i].second) == XX.m_terrainId)
+                    eqMask |= 1U << i;
             }
-
-            // dirt can contain mix of native 'dirt' and sand tiles.
-            if (tileXX.m_terrainId == dirtTerrain) {
-                sub = SubtileType::Native;
-                return;
+            const uint32_t key     = TerrainPatternTable::makeKey(XX, eqMask, XX.m_terrainId == dirtTerrain);
+            const auto     matches = patternTable.find(key);
+            for (const PatternMatch& match : matches) {
+                XX.m_terrainView.m_recommendedFlipHor  = match.m_flipHor;
+                XX.m_terrainView.m_recommendedFlipVert = match.m_flipVert;
+                XX.setView(match.m_class, match.m_type);
             }
-            sub = SubtileType::Dirt;
-        };
-        makest(pos, XX, XX.TL, -1, -1);
-        makest(pos, XX, XX.TR, +1, -1);
-        makest(pos, XX, XX.BL, -1, +1);
-        makest(pos, XX, XX.BR, +1, +1);
-    });
-
-    eachPosTile([](const FHPos& pos, FHTileMap::Tile& XX, size_t) {
-        assert(XX.TL != SubtileType::Invalid);
-        assert(XX.TR != SubtileType::Invalid);
-        assert(XX.BL != SubtileType::Invalid);
-        assert(XX.BR != SubtileType::Invalid);
-    });
-
-    eachPosTile([this,
-                 dirtTerrain,
-                 sandTerrain,
-                 //&ofs,
-                 //&row,
-                 waterTerrain](const FHPos& pos, FHTileMap::Tile& XX, size_t) {
-        TileNeightbours tilen;
-        tilen.read(dirtTerrain,
-                   sandTerrain,
-                   waterTerrain,
-                   *this,
-                   XX,
-                   pos);
-        XX.m_coastal = tilen.m_coastal;
-
-        /*
-        if (1) {
-            if (row != pos.m_y)
-                ofs << '\n';
-
-            row = pos.m_y;
-            ofs << tilen.debugString() << '\t';
-        }*/
-
-        if (XX.m_terrainId == sandTerrain) {
-            XX.setViewCenter();
-            return;
-        }
-
-        std::array<TileNeightbours, 4> flipConfigs{
-            { tilen, tilen.flipped(true, false), tilen.flipped(false, true), tilen.flipped(true, true) }
-        };
-
-        [[maybe_unused]] const bool isCorrected = [&flipConfigs, &XX, dirtTerrain, pos]() {
-            std::vector<int> matchedBts;
-            for (const TileNeightbours& t : flipConfigs) {
-                for (const auto& matcher : g_matchers) {
-                    if (!matcher.m_doFlipHor && t.m_flippedHor)
-                        continue;
-                    if (!matcher.m_doFlipVert && t.m_flippedVert)
-                        continue;
-                    if (XX.m_terrainId == dirtTerrain && !matcher.m_useOnDirt) {
-                        continue;
-                    }
-
-                    if (matcher.m_f(t, false)) {
-                        XX.m_terrainView.m_recommendedFlipHor  = t.m_flippedHor;
-                        XX.m_terrainView.m_recommendedFlipVert = t.m_flippedVert;
-                        XX.setView(matcher.m_class, matcher.m_type);
-                        matchedBts.push_back(static_cast<int>(matcher.m_type));
-                    }
-                    if (matcher.m_class == BorderClass::NormalDirt && matcher.m_f(t, true)) {
-                        XX.m_terrainView.m_recommendedFlipHor  = t.m_flippedHor;
-                        XX.m_terrainView.m_recommendedFlipVert = t.m_flippedVert;
-                        XX.setView(BorderClass::NormalSand, matcher.m_type);
-                        matchedBts.push_back(static_cast<int>(matcher.m_type));
-                    }
-                }
-            }
-            if (matchedBts.size() == 0) {
+            if (matches.empty())
                 XX.setViewCenter();
-                Logger(Logger::Warning) << "failed to detect pattern at (" << pos.m_x << ',' << pos.m_y << ',' << pos.m_z << ")";
-                return false;
-            }
-            if (matchedBts.size() > 1) {
-                Logger(Logger::Warning) << "correctTerrainTypes: found [" << matchedBts.size() << "] patterns at (" << pos.m_x << ',' << pos.m_y << ',' << pos.m_z << "): " << matchedBts;
-            }
-
-            return true;
-        }();
-    });
-}
-
-void FHTileMap::determineRoadViewRotation()
-{
-    // true = pattern found
-    auto correctTile = [this](const FHPos& pos, bool flipHor, bool flipVert, int order) -> bool {
-        /* TL  T  TR
-         *  L  X   R
-         * BL  B  BR
-         */
-        const Tile def;
-        // const auto& TL = getNeighbour(pos, flipHor ? +1 : -1, flipVert ? +1 : -1);
-        const auto& T  = getNeighbour(pos, flipHor ? +0 : +0, flipVert ? +1 : -1, def);
-        const auto& TR = getNeighbour(pos, flipHor ? -1 : +1, flipVert ? +1 : -1, def);
-        const auto& L  = getNeighbour(pos, flipHor ? +1 : -1, flipVert ? +0 : +0, def);
-        auto&       X  = get(pos);
-        const auto& R  = getNeighbour(pos, flipHor ? -1 : +1, flipVert ? +0 : +0, def);
-        const auto& BL = getNeighbour(pos, flipHor ? +1 : -1, flipVert ? -1 : +1, def);
-        const auto& B  = getNeighbour(pos, flipHor ? +0 : +0, flipVert ? -1 : +1, def);
-        // const auto& BR = getNeighbour(pos, flipHor ? -1 : +1, flipVert ? -1 : +1);
-
-        const auto eR  = (X.m_roadType == FHRoadType::None) == (R.m_roadType == FHRoadType::None);
-        const auto eL  = (X.m_roadType == FHRoadType::None) == (L.m_roadType == FHRoadType::None);
-        const auto eT  = (X.m_roadType == FHRoadType::None) == (T.m_roadType == FHRoadType::None);
-        const auto eB  = (X.m_roadType == FHRoadType::None) == (B.m_roadType == FHRoadType::None);
-        const auto eTR = (X.m_roadType == FHRoadType::None) == (TR.m_roadType == FHRoadType::None);
-        const auto eBL = (X.m_roadType == FHRoadType::None) == (BL.m_roadType == FHRoadType::None);
-
-        auto setView = [&X, flipHor, flipVert](uint8_t min, uint8_t max) {
-            X.m_roadView.m_viewMin             = min;
-            X.m_roadView.m_viewMax             = max;
-            X.m_roadView.m_recommendedFlipHor  = flipHor;
-            X.m_roadView.m_recommendedFlipVert = flipVert;
-        };
-
-        if (false) {
-        } else if (order == 0 && eR && !eL && !eT && eB && (eTR || eBL)) {
-            setView(2, 5);
-        } else if (order == 1 && eR && eL && eT && eB) {
-            setView(16, 16);
-        } else if (order == 1 && eR && eL && !eT && eB) {
-            setView(8, 9);
-        } else if (order == 1 && eR && !eL && eT && eB) {
-            setView(6, 7);
-        } else if (order == 1 && !eR && !eL && eT && eB) {
-            setView(10, 11);
-        } else if (order == 1 && eR && eL && !eT && !eB) {
-            setView(12, 13);
-        } else if (order == 1 && eR && !eL && !eT && eB) {
-            setView(0, 1);
-        } else if (order == 2 && !eR && !eL && !eT && eB) {
-            setView(14, 14);
-        } else if (order == 2 && eR && !eL && !eT && !eB) {
-            setView(15, 15);
-        } else if (order == 2 && !eR && !eL && !eT && !eB) {
-            setView(14, 14);
-            X.m_roadView.m_recommendedFlipHor  = false;
-            X.m_roadView.m_recommendedFlipVert = true;
-        } else {
-            return false;
+            if (matches.size() != 1)
+                warnings[z * m_height + y].push_back({ x, key });
         }
-        return true;
-    };
+    });
 
-    for (int z = 0; z < m_depth; ++z) {
-        for (int y = 0; y < m_height; ++y) {
-            for (int x = 0; x < m_width; ++x) {
-                const FHPos pos{ x, y, z };
-                auto&       X = get(pos);
-                if (X.m_roadType == FHRoadType::None)
-                    continue;
-
-                const bool tileCorrected = [&correctTile, &pos]() {
-                    for (int order = 0; order <= 2; ++order) {
-                        for (int flipHor = 0; flipHor <= 1; ++flipHor) {
-                            for (int flipVert = 0; flipVert <= 1; ++flipVert) {
-                                if (correctTile(pos, flipHor, flipVert, order))
-                                    return true;
-                            }
-                        }
-                    }
-                    return false;
-                }();
-                if (tileCorrected)
-                    continue;
-
-                X.m_roadView.m_viewMin             = 9;
-                X.m_roadView.m_viewMax             = 10;
-                X.m_roadView.m_recommendedFlipHor  = false;
-                X.m_roadView.m_recommendedFlipVert = false;
+    // logged after all rows are done to keep the order stable.
+    for (int row = 0; row < m_height * m_depth; ++row) {
+        for (const auto& [x, key] : warnings[row]) {
+            const FHPos pos{ x, row % m_height, row / m_height };
+            const auto  matches = patternTable.find(key);
+            if (matches.empty()) {
+                Logger(Logger::Warning) << "failed to detect pattern at (" << pos.m_x << ',' << pos.m_y << ',' << pos.m_z << ")";
+                continue;
             }
+            std::vector<int> matchedBts;
+            for (const PatternMatch& match : matches)
+                matchedBts.push_back(static_cast<int>(match.m_type));
+            Logger(Logger::Warning) << "correctTerrainTypes: found [" << matchedBts.size() << "] patterns at (" << pos.m_x << ',' << pos.m_y << ',' << pos.m_z << "): " << matchedBts;
         }
     }
 }
 
-void FHTileMap::determineRiverViewRotation()
+void FHTileMap::determineRoadViewRotation(size_t threads)
 {
-    // true = pattern found
-    auto correctTile = [this](const FHPos& pos, bool flipHor, bool flipVert, int order) -> bool {
-        /* TL  T  TR
-         *  L  X   R
-         * BL  B  BR
-         */
-        const Tile def;
-        //const auto& TL = getNeighbour(pos, flipHor ? +1 : -1, flipVert ? +1 : -1);
-        const auto& T = getNeighbour(pos, flipHor ? +0 : +0, flipVert ? +1 : -1, def);
-        // const auto& TR = getNeighbour(pos, flipHor ? -1 : +1, flipVert ? +1 : -1);
-        const auto& L = getNeighbour(pos, flipHor ? +1 : -1, flipVert ? +0 : +0, def);
-        auto&       X = get(pos);
-        const auto& R = getNeighbour(pos, flipHor ? -1 : +1, flipVert ? +0 : +0, def);
-        //const auto& BL = getNeighbour(pos, flipHor ? +1 : -1, flipVert ? -1 : +1);
-        const auto& B = getNeighbour(pos, flipHor ? +0 : +0, flipVert ? -1 : +1, def);
-        //const auto& BR = getNeighbour(pos, flipHor ? -1 : +1, flipVert ? -1 : +1);
-
-        const auto eR = X.m_riverType == R.m_riverType;
-        const auto eL = X.m_riverType == L.m_riverType;
-        const auto eT = X.m_riverType == T.m_riverType;
-        const auto eB = X.m_riverType == B.m_riverType;
-
-        auto setView = [&X, flipHor, flipVert](uint8_t min, uint8_t max) {
-            X.m_riverView.m_viewMin             = min;
-            X.m_riverView.m_viewMax             = max;
-            X.m_riverView.m_recommendedFlipHor  = flipHor;
-            X.m_riverView.m_recommendedFlipVert = flipVert;
-        };
-
-        if (false) {
-        } else if (order == 0 && eR && eL && eT && eB) {
-            setView(4, 4);
-        } else if (order == 0 && eR && eL && !eT && eB) {
-            setView(5, 6);
-        } else if (order == 0 && eR && !eL && eT && eB) {
-            setView(7, 8);
-        } else if (order == 0 && !eR && !eL && eT && eB) {
-            setView(9, 10);
-        } else if (order == 0 && eR && eL && !eT && !eB) {
-            setView(11, 12);
-        } else if (order == 0 && eR && !eL && !eT && eB) {
-            setView(0, 3);
-        } else if (order == 1 && !eR && !eL && !eT && eB) {
-            setView(9, 10);
-        } else if (order == 1 && !eR && !eL && eT && !eB) {
-            setView(9, 10);
-        } else if (order == 1 && eR && !eL && !eT && !eB) {
-            setView(11, 12);
-        } else if (order == 1 && !eR && eL && !eT && !eB) {
-            setView(11, 12);
-        } else {
-            return false;
-        }
-        return true;
-    };
+    m_viewStates.resize(totalSize());
+    determineLineViewRotation(*this, threads, g_roadRules, &TileViewState::m_roadView, [this](size_t index) -> uint8_t {
+        return m_roadTypes[index] != FHRoadType::None;
+    });
+}
 
-    for (int z = 0; z < m_depth; ++z) {
-        for (int y = 0; y < m_height; ++y) {
-            for (int x = 0; x < m_width; ++x) {
-                const FHPos pos{ x, y, z };
-                auto&       X = get(pos);
-                if (X.m_riverType == FHRiverType::None)
-                    continue;
-
-                const bool tileCorrected = [&correctTile, &pos]() {
-                    for (int order = 0; order <= 1; ++order) {
-                        for (int flipHor = 0; flipHor <= 1; ++flipHor) {
-                            for (int flipVert = 0; flipVert <= 1; ++flipVert) {
-                                if (correctTile(pos, flipHor, flipVert, order))
-                                    return true;
-                            }
-                        }
-                    }
-                    return false;
-                }();
-                if (tileCorrected)
-                    continue;
-
-                X.m_riverView.m_viewMin             = 9;
-                X.m_riverView.m_viewMax             = 10;
-                X.m_riverView.m_recommendedFlipHor  = false;
-                X.m_riverView.m_recommendedFlipVert = false;
-            }
-        }
-    }
+void FHTileMap::determineRiverViewRotation(size_t threads)
+{
+    m_viewStates.resize(totalSize());
+    determineLineViewRotation(*this, threads, g_riverRules, &TileViewState::m_riverView, [this](size_t index) -> uint8_t {
+        return static_cast<uint8_t>(m_riverTypes[index]);
+    });
 }
 
-void FHTileMap::determineViewRotation(const Core::IGameDatabase* database)
+void FHTileMap::determineViewRotation(const Core::IGameDatabase* database, size_t threads)
 {
     const auto* dirtTerrain  = database->terrains()->find(std::string(Core::LibraryTerrain::s_terrainDirt));
     const auto* sandTerrain  = database->terrains()->find(std::string(Core::LibraryTerrain::s_terrainSand));
@@ -887,43 +905,63 @@ void FHTileMap::determineViewRotation(const Core::IGameDatabase* database)
     if (!valid)
         throw std::runtime_error("some terrain tiles are missing");
 
-    determineTerrainViewRotation(dirtTerrain, sandTerrain, waterTerrain);
-    determineRoadViewRotation();
-    determineRiverViewRotation();
+    determineTerrainViewRotation(dirtTerrain, sandTerrain, waterTerrain, threads);
+    determineRoadViewRotation(threads);
+    determineRiverViewRotation(threads);
 }
 
 void FHTileMap::makeRecommendedRotation()
 {
-    this->eachPosTile([](const FHPos&, FHTileMap::Tile& tile, size_t) {
-        tile.m_terrainView.makeRecommendedRotation();
-        tile.m_roadView.makeRecommendedRotation();
-        tile.m_riverView.makeRecommendedRotation();
-    });
+    m_viewStates.resize(totalSize());
+    for (size_t i = 0; i < m_viewStates.size(); ++i) {
+        m_viewStates[i].m_terrainView.makeRecommendedRotation(m_terrainViews[i]);
+        m_viewStates[i].m_roadView.makeRecommendedRotation(m_roadViews[i]);
+        m_viewStates[i].m_riverView.makeRecommendedRotation(m_riverViews[i]);
+    }
 }
 
 void FHTileMap::makeRngView(Core::IRandomGenerator* rng, int roughTileChancePercent)
 {
-    this->eachPosTile([rng, roughTileChancePercent](const FHPos&, FHTileMap::Tile& tile, size_t) {
-        tile.m_terrainView.makeRngView(rng, roughTileChancePercent, true);
-        tile.m_roadView.makeRngView(rng, roughTileChancePercent, false);
-        tile.m_riverView.makeRngView(rng, roughTileChancePercent, false);
-    });
+    m_viewStates.resize(totalSize());
+    for (size_t i = 0; i < m_viewStates.size(); ++i) {
+        m_viewStates[i].m_terrainView.makeRngView(m_terrainViews[i], rng, roughTileChancePercent, true);
+        m_viewStates[i].m_roadView.makeRngView(m_roadViews[i], rng, roughTileChancePercent, false);
+        m_viewStates[i].m_riverView.makeRngView(m_riverViews[i], rng, roughTileChancePercent, false);
+    }
+    // view detection is done, final views are all that is kept.
+    m_viewStates = {};
+}
+
+uint8_t FHTileMap::makeTerrainIndex(Core::LibraryTerrainConstPtr terrain)
+{
+    for (size_t i = 0; i < m_terrains.size(); ++i) {
+        if (m_terrains[i] == terrain)
+            return static_cast<uint8_t>(i);
+    }
+    if (m_terrains.size() > std::numeric_limits<uint8_t>::max())
+        throw std::runtime_error("Too many different terrains in tile map");
+    m_terrains.push_back(terrain);
+    return static_cast<uint8_t>(m_terrains.size() - 1);
 }
 
 void FHPackedTileMap::unpackToMap(FHTileMap& map) const
 {
     if (m_tileTerrianIndexes.empty())
         return;
-    map.eachPosTile([this](const FHPos& pos, FHTileMap::Tile& tile, size_t i) {
-        tile.m_terrainId              = m_terrains[m_tileTerrianIndexes[i]];
-        tile.m_terrainView.m_view     = m_tileViews[i];
-        tile.m_terrainView.m_flipHor  = m_terrainFlipHor[i];
-        tile.m_terrainView.m_flipVert = m_terrainFlipVert[i];
-        tile.m_coastal                = m_coastal[i];
-    });
+    std::vector<uint8_t> mapTerrainIndexes;
+    for (auto* terrain : m_terrains)
+        mapTerrainIndexes.push_back(map.makeTerrainIndex(terrain));
+
+    for (size_t i = 0; i < m_tileTerrianIndexes.size(); ++i) {
+        map.m_terrainIndexes[i]          = mapTerrainIndexes[m_tileTerrianIndexes[i]];
+        map.m_terrainViews[i].m_view     = m_tileViews[i];
+        map.m_terrainViews[i].m_flipHor  = m_terrainFlipHor[i];
+        map.m_terrainViews[i].m_flipVert = m_terrainFlipVert[i];
+        map.m_coastal[i]                 = m_coastal[i];
+    }
     for (auto& road : m_roads) {
         for (size_t i = 0; i < road.m_tiles.size(); ++i) {
-            auto& tile                 = map.get(road.m_tiles[i]);
+            auto tile                  = map.get(road.m_tiles[i]);
             tile.m_roadType            = road.m_type;
             tile.m_roadView.m_view     = road.m_views[i];
             tile.m_roadView.m_flipHor  = road.m_flipHor[i];
@@ -932,7 +970,7 @@ void FHPackedTileMap::unpackToMap(FHTileMap& map) const
     }
     for (auto& river : m_rivers) {
         for (size_t i = 0; i < river.m_tiles.size(); ++i) {
-            auto& tile                  = map.get(river.m_tiles[i]);
+            auto tile                   = map.get(river.m_tiles[i]);
             tile.m_riverType            = river.m_type;
             tile.m_riverView.m_view     = river.m_views[i];
             tile.m_riverView.m_flipHor  = river.m_flipHor[i];
@@ -940,7 +978,6 @@ void FHPackedTileMap::unpackToMap(FHTileMap& map) const
         }
     }
 }
-
 void FHPackedTileMap::packFromMap(const FHTileMap& map)
 {
     size_t tilesSize = map.totalSize();
@@ -960,16 +997,18 @@ void FHPackedTileMap::packFromMap(const FHTileMap& map)
     m_rivers[2].m_type = FHRiverType::Mud;
     m_rivers[3].m_type = FHRiverType::Lava;
 
-    auto makeTerrainIndex = [this](Core::LibraryTerrainConstPtr terrain) -> uint8_t {
-        for (size_t i = 0; i < m_terrains.size(); ++i) {
-            if (m_terrains[i] == terrain)
-                return static_cast<uint8_t>(i);
+    // packed terrains go in order of first appearance, map ones may not.
+    std::vector<int> packedTerrainIndexes(map.m_terrains.size(), -1);
+    auto             makeTerrainIndex = [this, &map, &packedTerrainIndexes](uint8_t mapIndex) -> uint8_t {
+        int& packedIndex = packedTerrainIndexes[mapIndex];
+        if (packedIndex < 0) {
+            packedIndex = static_cast<int>(m_terrains.size());
+            m_terrains.push_back(map.m_terrains[mapIndex]);
         }
-        m_terrains.push_back(terrain);
-        return static_cast<uint8_t>(m_terrains.size() - 1);
+        return static_cast<uint8_t>(packedIndex);
     };
-    map.eachPosTile([&makeTerrainIndex, this](const FHPos& pos, const FHTileMap::Tile& tile, size_t i) {
-        m_tileTerrianIndexes[i] = makeTerrainIndex(tile.m_terrainId);
+    map.eachPosTile([&makeTerrainIndex, &map, this](const FHPos& pos, const FHTileMap::Tile& tile, size_t i) {
+        m_tileTerrianIndexes[i] = makeTerrainIndex(map.m_terrainIndexes[i]);
         m_tileViews[i]          = tile.m_terrainView.m_view;
         m_terrainFlipHor[i]     = tile.m_terrainView.m_flipHor;
         m_terrainFlipVert[i]    = tile.m_terrainView.m_flipVert;
@@ -991,10 +1030,10 @@ void FHPackedTileMap::packFromMap(const FHTileMap& map)
     });
 }
 
-void FHTileMap::TileView::makeRngView(Core::IRandomGenerator* rng, int roughTileChancePercent, bool useMid)
+void FHTileMap::TileViewRange::makeRngView(TileView& view, Core::IRandomGenerator* rng, int roughTileChancePercent, bool useMid) const
 {
     if (m_viewMin == m_viewMax) {
-        m_view = m_viewMin;
+        view.m_view = m_viewMin;
         return;
     }
     auto rngView = [&rng](uint8_t min, uint8_t max) -> uint8_t {
@@ -1006,11 +1045,11 @@ void FHTileMap::TileView::makeRngView(Core::IRandomGenerator* rng, int roughTile
     };
     if (useMid && m_viewMid != m_viewMax) {
         if (rng->genSmall(100) >= roughTileChancePercent) {
-            m_view = rngView(m_viewMin, m_viewMid);
+            view.m_view = rngView(m_viewMin, m_viewMid);
             return;
         }
     }
-    m_view = rngView(m_viewMin, m_viewMax);
+    view.m_view = rngView(m_viewMin, m_viewMax);
 }
 
 }
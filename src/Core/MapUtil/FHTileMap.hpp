@@ -7,8 +7,10 @@
 
 #include "LibraryTerrain.hpp"
 
+#include <algorithm>
 #include <optional>
 #include <cmath>
+#include <vector>
 
 #include "MapUtilExport.hpp"
 
@@ -32,39 +34,102 @@ struct MAPUTIL_EXPORT FHTileMap {
 
     struct TileView {
         uint8_t m_view     = 0;
-        uint8_t m_viewMin  = 0;
-        uint8_t m_viewMid  = 0; // for center tiles - margin between 'clear' and 'rough' style.
-        uint8_t m_viewMax  = 0;
         bool    m_flipHor  = false;
         bool    m_flipVert = false;
+    };
+
+    // copy of all data of one tile.
+    struct Tile {
+        Core::LibraryTerrainConstPtr m_terrainId = nullptr;
+        FHRiverType                  m_riverType = FHRiverType::None;
+        FHRoadType                   m_roadType  = FHRoadType::None;
+
+        TileView m_terrainView;
+        TileView m_roadView;
+        TileView m_riverView;
+
+        bool m_coastal = false;
+    };
+
+    // terrain is stored as index into m_terrains; this behaves as a terrain pointer.
+    class TerrainRef {
+    public:
+        TerrainRef(FHTileMap& map, size_t index)
+            : m_map(map)
+            , m_index(index)
+        {}
+
+        TerrainRef& operator=(Core::LibraryTerrainConstPtr terrain)
+        {
+            m_map.m_terrainIndexes[m_index] = m_map.makeTerrainIndex(terrain);
+            return *this;
+        }
+        TerrainRef& operator=(const TerrainRef& other) { return *this = static_cast<Core::LibraryTerrainConstPtr>(other); }
+
+        operator Core::LibraryTerrainConstPtr() const { return m_map.m_terrains[m_map.m_terrainIndexes[m_index]]; }
+        Core::LibraryTerrainConstPtr operator->() const { return *this; }
+
+    private:
+        FHTileMap&   m_map;
+        const size_t m_index;
+    };
+
+    // mutable access to one tile in the layers below, fields are named same as in Tile.
+    struct TileRef {
+        TerrainRef   m_terrainId;
+        FHRiverType& m_riverType;
+        FHRoadType&  m_roadType;
+
+        TileView& m_terrainView;
+        TileView& m_roadView;
+        TileView& m_riverView;
+
+        uint8_t& m_coastal;
+
+        operator Tile() const
+        {
+            return Tile{
+                .m_terrainId   = m_terrainId,
+                .m_riverType   = m_riverType,
+                .m_roadType    = m_roadType,
+                .m_terrainView = m_terrainView,
+                .m_roadView    = m_roadView,
+                .m_riverView   = m_riverView,
+                .m_coastal     = static_cast<bool>(m_coastal),
+            };
+        }
+    };
+
+    // view range and flip found by determineViewRotation(), used by makeRecommendedRotation() and makeRngView().
+    struct TileViewRange {
+        uint8_t m_viewMin = 0;
+        uint8_t m_viewMid = 0; // for center tiles - margin between 'clear' and 'rough' style.
+        uint8_t m_viewMax = 0;
 
         bool m_recommendedFlipHor  = false;
         bool m_recommendedFlipVert = false;
 
-        void makeRecommendedRotation()
+        void makeRecommendedRotation(TileView& view) const
         {
-            m_flipHor  = m_recommendedFlipHor;
-            m_flipVert = m_recommendedFlipVert;
+            view.m_flipHor  = m_recommendedFlipHor;
+            view.m_flipVert = m_recommendedFlipVert;
         }
 
-        void makeRngView(Core::IRandomGenerator* rng, int roughTileChancePercent, bool useMid = false);
+        void makeRngView(TileView& view, Core::IRandomGenerator* rng, int roughTileChancePercent, bool useMid = false) const;
     };
 
-    struct Tile {
+    // intermediate per-tile state of view detection.
+    struct TileViewState {
         Core::LibraryTerrainConstPtr m_terrainId = nullptr;
-        FHRiverType                  m_riverType = FHRiverType::None;
-        FHRoadType                   m_roadType  = FHRoadType::None;
 
         SubtileType TL = SubtileType::Invalid;
         SubtileType TR = SubtileType::Invalid;
         SubtileType BL = SubtileType::Invalid;
         SubtileType BR = SubtileType::Invalid;
 
-        TileView m_terrainView;
-        TileView m_roadView;
-        TileView m_riverView;
-
-        bool m_coastal = false;
+        TileViewRange m_terrainView;
+        TileViewRange m_roadView;
+        TileViewRange m_riverView;
 
         int m_tileOffset     = 0;
         int m_tileCount      = 0;
@@ -82,26 +147,63 @@ struct MAPUTIL_EXPORT FHTileMap {
     int32_t m_height = 0;
     int32_t m_depth  = 0; // no underground => depth==1; has underground => depth==2
 
-    std::vector<Tile> m_tiles;
+    // tile data is kept in layers (one vector per field), all indexed by index(x, y, z).
+    std::vector<Core::LibraryTerrainConstPtr> m_terrains{ nullptr }; // distinct terrains; index 0 is 'no terrain'
+    std::vector<uint8_t>                      m_terrainIndexes;
+    std::vector<FHRiverType>                  m_riverTypes;
+    std::vector<FHRoadType>                   m_roadTypes;
+    std::vector<TileView>                     m_terrainViews;
+    std::vector<TileView>                     m_roadViews;
+    std::vector<TileView>                     m_riverViews;
+    std::vector<uint8_t>                      m_coastal;
+
+    // only exists from determineViewRotation() to makeRngView().
+    std::vector<TileViewState> m_viewStates;
+
+    size_t index(int x, int y, int z) const
+    {
+        return (static_cast<size_t>(z) * m_height + y) * m_width + x;
+    }
 
-    Tile& get(int x, int y, int z)
+    Tile getByIndex(size_t index) const
     {
-        const int zOffset = m_width * m_height * z;
-        const int yOffset = m_width * y;
-        return m_tiles[zOffset + yOffset + x];
+        return Tile{
+            .m_terrainId   = m_terrains[m_terrainIndexes[index]],
+            .m_riverType   = m_riverTypes[index],
+            .m_roadType    = m_roadTypes[index],
+            .m_terrainView = m_terrainViews[index],
+            .m_roadView    = m_roadViews[index],
+            .m_riverView   = m_riverViews[index],
+            .m_coastal     = static_cast<bool>(m_coastal[index]),
+        };
     }
-    const Tile& get(int x, int y, int z) const
+    TileRef getByIndex(size_t index)
     {
-        const int zOffset = m_width * m_height * z;
-        const int yOffset = m_width * y;
-        return m_tiles[zOffset + yOffset + x];
+        return TileRef{
+            .m_terrainId   = TerrainRef(*this, index),
+            .m_riverType   = m_riverTypes[index],
+            .m_roadType    = m_roadTypes[index],
+            .m_terrainView = m_terrainViews[index],
+            .m_roadView    = m_roadViews[index],
+            .m_riverView   = m_riverViews[index],
+            .m_coastal     = m_coastal[index],
+        };
     }
 
-    Tile& getNeighbour(int x, int dx, int y, int dy, int z)
+    TileRef get(int x, int y, int z)
+    {
+        return getByIndex(index(x, y, z));
+    }
+    Tile get(int x, int y, int z) const
+    {
+        return getByIndex(index(x, y, z));
+    }
+
+    TileRef getNeighbour(int x, int dx, int y, int dy, int z)
     {
         return get(correctX(x + dx), correctY(y + dy), z);
     }
-    const Tile& getNeighbour(int x, int dx, int y, int dy, int z) const
+    Tile getNeighbour(int x, int dx, int y, int dy, int z) const
     {
         return get(correctX(x + dx), correctY(y + dy), z);
     }
@@ -119,23 +221,23 @@ struct MAPUTIL_EXPORT FHTileMap {
         return x >= 0 && x < m_width && y >= 0 && y < m_height;
     }
 
-    Tile& get(const FHPos& pos)
+    TileRef get(const FHPos& pos)
     {
         return get(pos.m_x, pos.m_y, pos.m_z);
     }
-    const Tile& get(const FHPos& pos) const
+    Tile get(const FHPos& pos) const
     {
         return get(pos.m_x, pos.m_y, pos.m_z);
     }
-    Tile& getNeighbour(const FHPos& pos, int dx, int dy)
+    TileRef getNeighbour(const FHPos& pos, int dx, int dy)
     {
         return getNeighbour(pos.m_x, dx, pos.m_y, dy, pos.m_z);
     }
-    const Tile& getNeighbour(const FHPos& pos, int dx, int dy) const
+    Tile getNeighbour(const FHPos& pos, int dx, int dy) const
     {
         return getNeighbour(pos.m_x, dx, pos.m_y, dy, pos.m_z);
     }
-    const Tile& getNeighbour(const FHPos& pos, int dx, int dy, const Tile& def) const
+    Tile getNeighbour(const FHPos& pos, int dx, int dy, const Tile& def) const
     {
         return inBounds(pos.m_x + dx, pos.m_y + dy) ? getNeighbour(pos.m_x, dx, pos.m_y, dy, pos.m_z) : def;
     }
@@ -146,17 +248,29 @@ struct MAPUTIL_EXPORT FHTileMap {
 
     void updateSize()
     {
-        m_tiles.resize(totalSize());
+        const size_t size = totalSize();
+        m_terrainIndexes.resize(size);
+        m_riverTypes.resize(size, FHRiverType::None);
+        m_roadTypes.resize(size, FHRoadType::None);
+        m_terrainViews.resize(size);
+        m_roadViews.resize(size);
+        m_riverViews.resize(size);
+        m_coastal.resize(size);
     }
 
+    // index in m_terrains, terrain is added if it is new.
+    uint8_t makeTerrainIndex(Core::LibraryTerrainConstPtr terrain);
+
+    // threads == 0 - chosen by map size and hardware; batch tools pass 1 as they run several maps at once.
     void determineTerrainViewRotation(Core::LibraryTerrainConstPtr dirtTerrain,
                                       Core::LibraryTerrainConstPtr sandTerrain,
-                                      Core::LibraryTerrainConstPtr waterTerrain);
+                                      Core::LibraryTerrainConstPtr waterTerrain,
+                                      size_t                       threads = 0);
 
-    void determineRoadViewRotation();
-    void determineRiverViewRotation();
+    void determineRoadViewRotation(size_t threads = 0);
+    void determineRiverViewRotation(size_t threads = 0);
 
-    void determineViewRotation(const Core::IGameDatabase* database);
+    void determineViewRotation(const Core::IGameDatabase* database, size_t threads = 0);
 
     void makeRecommendedRotation();
     void makeRngView(Core::IRandomGenerator* rng, int roughTileChancePercent);
@@ -168,7 +282,7 @@ struct MAPUTIL_EXPORT FHTileMap {
             for (int y = 0; y < m_height; ++y) {
                 for (int x = 0; x < m_width; ++x) {
                     const FHPos pos{ x, y, z };
-                    f(pos, get(x, y, z), offset);
+                    f(pos, getByIndex(offset), offset);
                     offset++;
                 }
             }
@@ -182,7 +296,7 @@ struct MAPUTIL_EXPORT FHTileMap {
             for (int y = 0; y < m_height; ++y) {
                 for (int x = 0; x < m_width; ++x) {
                     const FHPos pos{ x, y, z };
-                    f(pos, get(x, y, z), offset);
+                    f(pos, getByIndex(offset), offset);
                     offset++;
                 }
             }
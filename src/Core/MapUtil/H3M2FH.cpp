@@ -5,6 +5,8 @@
  */
 #include "H3M2FH.hpp"
 
+#include "ParallelChunks.hpp"
+
 #include "LibraryDwelling.hpp"
 #include "LibraryFaction.hpp"
 #include "LibraryHero.hpp"
@@ -68,8 +70,9 @@ FHPos posFromH3M(H3Pos pos, int xoffset = 0)
 
 }
 
-H3M2FHConverter::H3M2FHConverter(const Core::IGameDatabase* database)
+H3M2FHConverter::H3M2FHConverter(const Core::IGameDatabase* database, size_t threads)
     : m_database(database)
+    , m_threads(threads)
 {
     m_factionsContainer = database->factions();
 
@@ -90,6 +93,8 @@ H3M2FHConverter::H3M2FHConverter(const Core::IGameDatabase* database)
             continue;
         m_spellScrollsIds[(uint32_t) art->scrollSpell->legacyId] = art;
     }
+    for (auto* spell : m_spellIds)
+        m_spellScrollArtifactIds.push_back(spell ? database->artifacts()->find("sod.artifact." + spell->id) : nullptr); // @todo: constaint for prefix?
 
     auto players = database->players()->legacyOrderedRecords();
     for (int i = 0; i < (int) players.size(); i++)
@@ -249,10 +254,136 @@ void H3M2FHConverter::convertMap(const H3Map& src, FHMap& dest) const
         objectDefsCorrected.push_back(fhDefCorrected);
     }
 
-    for (int index = 0; const Object& obj : src.m_objects) {
+    // objects do not depend on each other, so contiguous ranges are converted on separate threads;
+    // chunks are appended in source order, so the result is the same as for sequential conversion.
+    const ObjectsContext context{
+        .m_objectDefs          = dest.m_objectDefs,
+        .m_objectDefsCorrected = objectDefsCorrected,
+        .m_mainTowns           = mainTowns,
+        .m_mainHeroes          = mainHeroes,
+    };
+    {
+        constexpr size_t s_minObjectsPerChunk = 256;
+
+        const size_t objectCount = src.m_objects.size();
+        const size_t chunks      = getParallelChunks(objectCount, s_minObjectsPerChunk, m_threads);
+
+        std::vector<ObjectsChunk> results(chunks);
+        forEachChunkParallel(objectCount, chunks, chunks, [this, &src, &context, &results](size_t chunk, size_t begin, size_t end) {
+            convertObjects(src, context, begin, end, results[chunk]);
+        });
+
+        auto appendMoved = [](auto& to, auto& from) {
+            to.insert(to.end(), std::make_move_iterator(from.begin()), std::make_move_iterator(from.end()));
+        };
+        auto destContainers = dest.m_objects.getAllContainers();
+        for (ObjectsChunk& chunk : results) {
+            auto chunkContainers = chunk.m_objects.getAllContainers();
+            FHMap::Objects::visit(destContainers, [&chunkContainers, &appendMoved](auto& container) {
+                appendMoved(container, std::get<decltype(container)>(chunkContainers));
+            });
+            appendMoved(dest.m_wanderingHeroes, chunk.m_wanderingHeroes);
+            appendMoved(dest.m_towns, chunk.m_towns);
+        }
+    }
+
+    for (int index = 0; auto& allowedFlag : src.m_allowedHeroes) {
+        const auto& heroId = m_heroIds[index++];
+        dest.m_disabledHeroes.setDisabled(dest.m_isWaterMap, heroId, !allowedFlag);
+    }
+
+    for (int index = 0; auto& allowedFlag : src.m_allowedArtifacts) {
+        const auto& artId = m_artifactIds[index++];
+        dest.m_disabledArtifacts.setDisabled(dest.m_isWaterMap, artId, !allowedFlag);
+    }
+
+    for (int index = 0; auto& allowedFlag : src.m_allowedSpells) {
+        const auto& spellId = m_spellIds[index++];
+        dest.m_disabledSpells.setDisabled(dest.m_isWaterMap, spellId, !allowedFlag);
+    }
+    for (int index = 0; auto& allowedFlag : src.m_allowedSecSkills) {
+        const auto& secSkillId = m_secSkillIds[index++];
+        dest.m_disabledSkills.setDisabled(dest.m_isWaterMap, secSkillId, !allowedFlag);
+    }
+    for (uint8_t heroId : src.m_placeholderHeroes) {
+        dest.m_placeholderHeroes.push_back(m_heroIds[heroId]);
+    }
+    for (auto& srcHero : src.m_disposedHeroes) {
+        FHDisposedHero destHero;
+        destHero.m_players  = convertPlayerList(srcHero.m_players);
+        destHero.m_heroId   = m_heroIds.at(srcHero.m_heroId);
+        destHero.m_portrait = srcHero.m_portrait == 0xffU ? -1 : srcHero.m_portrait;
+        destHero.m_name     = srcHero.m_name;
+
+        dest.m_disposedHeroes.push_back(std::move(destHero));
+    }
+
+    for (int index = 0; auto& customHero : src.m_customHeroData) {
+        const auto& heroId = m_heroIds[index++];
+        if (!customHero.m_enabled)
+            continue;
+        FHHeroData destHero;
+        destHero.m_army.hero     = Core::AdventureHero(heroId);
+        destHero.m_hasExp        = customHero.m_hasExp;
+        destHero.m_hasCustomBio  = customHero.m_hasCustomBio;
+        destHero.m_hasSecSkills  = customHero.m_hasSkills;
+        destHero.m_hasPrimSkills = customHero.m_primSkillSet.m_hasCustomPrimSkills;
+        destHero.m_hasSpells     = customHero.m_spellSet.m_hasCustomSpells;
+        destHero.m_hasArts       = customHero.m_artSet.m_hasArts;
+        destHero.m_sex           = customHero.m_sex == 0xFFU ? -1 : static_cast<int>(customHero.m_sex);
+
+        if (destHero.m_hasSecSkills) {
+            auto& skillList = destHero.m_army.hero.secondarySkills;
+            skillList.clear();
+            for (auto& sk : customHero.m_skills) {
+                const auto* secSkillId = m_secSkillIds[sk.m_id];
+                skillList.push_back({ secSkillId, sk.m_level - 1 });
+            }
+        }
+        if (destHero.m_hasPrimSkills) {
+            auto& prim                                              = customHero.m_primSkillSet.m_primSkills;
+            destHero.m_army.hero.currentBasePrimary.ad.asTuple()    = std::tie(prim[0], prim[1]);
+            destHero.m_army.hero.currentBasePrimary.magic.asTuple() = std::tie(prim[2], prim[3]);
+        }
+        if (destHero.m_hasSpells) {
+            destHero.m_army.hero.spellbook.clear();
+            for (size_t spellId = 0; spellId < customHero.m_spellSet.m_spells.size(); ++spellId) {
+                if (customHero.m_spellSet.m_spells[spellId])
+                    destHero.m_army.hero.spellbook.insert(m_spellIds[spellId]);
+            }
+        }
+        if (destHero.m_hasArts) {
+            convertHeroArtifacts(customHero.m_artSet, destHero.m_army.hero);
+        }
+        if (destHero.m_hasCustomBio) {
+            destHero.m_bio = customHero.m_bio;
+        }
+
+        if (destHero.m_hasExp)
+            destHero.m_army.hero.experience = customHero.m_exp;
+        dest.m_customHeroes.push_back(std::move(destHero));
+    }
+    for (auto& event : src.m_globalEvents) {
+        dest.m_globalEvents.push_back(convertEvent(event));
+    }
+    for (auto& data : src.m_customHeroDataExt) {
+        dest.m_customHeroDataExt.push_back({ data.m_unknown1, data.m_unknown2 });
+    }
+
+    convertTileMap(src, dest);
+    assert(dest.m_tileMap.m_width > 0);
+    assert(dest.m_tileMap.m_width == dest.m_tileMap.m_height);
+}
+
+void H3M2FHConverter::convertObjects(const H3Map& src, const ObjectsContext& context, size_t begin, size_t end, ObjectsChunk& dest) const
+{
+    for (size_t objectIndex = begin; objectIndex < end; ++objectIndex) {
+        const int     index = static_cast<int>(objectIndex);
+        const Object& obj   = src.m_objects[objectIndex];
+
         const IMapObject*             impl            = obj.m_impl.get();
-        const Core::LibraryObjectDef& objDefEmbedded  = dest.m_objectDefs[obj.m_defnum];
-        const Core::LibraryObjectDef& objDefCorrected = objectDefsCorrected[obj.m_defnum];
+        const Core::LibraryObjectDef& objDefEmbedded  = context.m_objectDefs[obj.m_defnum];
+        const Core::LibraryObjectDef& objDefCorrected = context.m_objectDefsCorrected[obj.m_defnum];
 
         Core::LibraryObjectDefConstPtr objDefDatabase = objDefEmbedded.substituteFor;
 
@@ -345,7 +476,7 @@ void H3M2FHConverter::convertMap(const H3Map& src, FHMap& dest) const
                     auto combinedMask   = Core::LibraryObjectDef::makeCombinedMask(blockMapPlanar, visitMapPlanar);
                     fhhero.m_pos.m_x    = fhhero.m_pos.m_x + combinedMask.m_visitable.begin()->m_x;
                 }
-                fhhero.m_isMain           = mainHeroes.contains(playerId) && mainHeroes[playerId] == hero->m_subID;
+                fhhero.m_isMain           = context.m_mainHeroes.contains(playerId) && context.m_mainHeroes.at(playerId) == hero->m_subID;
                 fhhero.m_questIdentifier  = hero->m_questIdentifier;
                 fhhero.m_unknown1         = hero->m_unknown1;
                 fhhero.m_unknown2         = hero->m_unknown2;
@@ -620,9 +751,7 @@ void H3M2FHConverter::convertMap(const H3Map& src, FHMap& dest) const
 
                 art.m_messageWithBattle = convertMessage(artifact->m_message);
                 if (type == MapObjectType::SPELL_SCROLL) {
-                    const auto* spell = m_spellIds.at(artifact->m_spellId);
-                    assert(spell);
-                    art.m_id = m_database->artifacts()->find("sod.artifact." + spell->id); // @todo: constaint for prefix?
+                    art.m_id = m_spellScrollArtifactIds.at(artifact->m_spellId);
                     assert(art.m_id);
                 } else {
                     assert(objDefCorrected.subId != 0);
@@ -715,7 +844,7 @@ void H3M2FHConverter::convertMap(const H3Map& src, FHMap& dest) const
                 fhtown.m_obligatorySpells = town->m_obligatorySpells;
                 fhtown.m_possibleSpells   = town->m_possibleSpells;
 
-                if (mainTowns.contains(playerId) && mainTowns.at(playerId) == fhtown.m_pos)
+                if (context.m_mainTowns.contains(playerId) && context.m_mainTowns.at(playerId) == fhtown.m_pos)
                     fhtown.m_isMain = true;
                 if (fhtown.m_hasCustomBuildings) {
                     for (size_t i = 0; i < town->m_builtBuildings.size(); ++i) {
@@ -1029,96 +1158,7 @@ void H3M2FHConverter::convertMap(const H3Map& src, FHMap& dest) const
                 }
             } break;
         }
-
-        index++;
-    }
-
-    for (int index = 0; auto& allowedFlag : src.m_allowedHeroes) {
-        const auto& heroId = m_heroIds[index++];
-        dest.m_disabledHeroes.setDisabled(dest.m_isWaterMap, heroId, !allowedFlag);
-    }
-
-    for (int index = 0; auto& allowedFlag : src.m_allowedArtifacts) {
-        const auto& artId = m_artifactIds[index++];
-        dest.m_disabledArtifacts.setDisabled(dest.m_isWaterMap, artId, !allowedFlag);
-    }
-
-    for (int index = 0; auto& allowedFlag : src.m_allowedSpells) {
-        const auto& spellId = m_spellIds[index++];
-        dest.m_disabledSpells.setDisabled(dest.m_isWaterMap, spellId, !allowedFlag);
-    }
-    for (int index = 0; auto& allowedFlag : src.m_allowedSecSkills) {
-        const auto& secSkillId = m_secSkillIds[index++];
-        dest.m_disabledSkills.setDisabled(dest.m_isWaterMap, secSkillId, !allowedFlag);
-    }
-    for (uint8_t heroId : src.m_placeholderHeroes) {
-        dest.m_placeholderHeroes.push_back(m_heroIds[heroId]);
-    }
-    for (auto& srcHero : src.m_disposedHeroes) {
-        FHDisposedHero destHero;
-        destHero.m_players  = convertPlayerList(srcHero.m_players);
-        destHero.m_heroId   = m_heroIds.at(srcHero.m_heroId);
-        destHero.m_portrait = srcHero.m_portrait == 0xffU ? -1 : srcHero.m_portrait;
-        destHero.m_name     = srcHero.m_name;
-
-        dest.m_disposedHeroes.push_back(std::move(destHero));
-    }
-
-    for (int index = 0; auto& customHero : src.m_customHeroData) {
-        const auto& heroId = m_heroIds[index++];
-        if (!customHero.m_enabled)
-            continue;
-        FHHeroData destHero;
-        destHero.m_army.hero     = Core::AdventureHero(heroId);
-        destHero.m_hasExp        = customHero.m_hasExp;
-        destHero.m_hasCustomBio  = customHero.m_hasCustomBio;
-        destHero.m_hasSecSkills  = customHero.m_hasSkills;
-        destHero.m_hasPrimSkills = customHero.m_primSkillSet.m_hasCustomPrimSkills;
-        destHero.m_hasSpells     = customHero.m_spellSet.m_hasCustomSpells;
-        destHero.m_hasArts       = customHero.m_artSet.m_hasArts;
-        destHero.m_sex           = customHero.m_sex == 0xFFU ? -1 : static_cast<int>(customHero.m_sex);
-
-        if (destHero.m_hasSecSkills) {
-            auto& skillList = destHero.m_army.hero.secondarySkills;
-            skillList.clear();
-            for (auto& sk : customHero.m_skills) {
-                const auto* secSkillId = m_secSkillIds[sk.m_id];
-                skillList.push_back({ secSkillId, sk.m_level - 1 });
-            }
-        }
-        if (destHero.m_hasPrimSkills) {
-            auto& prim                                              = customHero.m_primSkillSet.m_primSkills;
-            destHero.m_army.hero.currentBasePrimary.ad.asTuple()    = std::tie(prim[0], prim[1]);
-            destHero.m_army.hero.currentBasePrimary.magic.asTuple() = std::tie(prim[2], prim[3]);
-        }
-        if (destHero.m_hasSpells) {
-            destHero.m_army.hero.spellbook.clear();
-            for (size_t spellId = 0; spellId < customHero.m_spellSet.m_spells.size(); ++spellId) {
-                if (customHero.m_spellSet.m_spells[spellId])
-                    destHero.m_army.hero.spellbook.insert(m_spellIds[spellId]);
-            }
-        }
-        if (destHero.m_hasArts) {
-            convertHeroArtifacts(customHero.m_artSet, destHero.m_army.hero);
-        }
-        if (destHero.m_hasCustomBio) {
-            destHero.m_bio = customHero.m_bio;
-        }
-
-        if (destHero.m_hasExp)
-            destHero.m_army.hero.experience = customHero.m_exp;
-        dest.m_customHeroes.push_back(std::move(destHero));
-    }
-    for (auto& event : src.m_globalEvents) {
-        dest.m_globalEvents.push_back(convertEvent(event));
     }
-    for (auto& data : src.m_customHeroDataExt) {
-        dest.m_customHeroDataExt.push_back({ data.m_unknown1, data.m_unknown2 });
-    }
-
-    convertTileMap(src, dest);
-    assert(dest.m_tileMap.m_width > 0);
-    assert(dest.m_tileMap.m_width == dest.m_tileMap.m_height);
 }
 
 Core::ResourceAmount H3M2FHConverter::convertResources(const std::vector<uint32_t>& resourceAmount) const
@@ -1446,7 +1486,7 @@ std::vector<Core::LibraryPlayerConstPtr> H3M2FHConverter::convertPlayerList(cons
 void H3M2FHConverter::convertTileMap(const H3Map& src, FHMap& dest) const
 {
     dest.m_tileMap.updateSize();
-    dest.m_tileMap.eachPosTile([&src, this](const FHPos& tilePos, FHTileMap::Tile& destTile, size_t) {
+    dest.m_tileMap.eachPosTile([&src, this](const FHPos& tilePos, FHTileMap::TileRef destTile, size_t) {
         const auto& tile              = src.m_tiles.get(tilePos.m_x, tilePos.m_y, tilePos.m_z);
         destTile.m_terrainId          = m_terrainIds[tile.m_terType];
         destTile.m_terrainView.m_view = tile.m_terView;
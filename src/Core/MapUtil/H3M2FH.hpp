@@ -10,15 +10,32 @@
 
 #include "IGameDatabase.hpp"
 
+#include "MapUtilExport.hpp"
+
 namespace FreeHeroes {
 
-class H3M2FHConverter {
+class MAPUTIL_EXPORT H3M2FHConverter {
 public:
-    H3M2FHConverter(const Core::IGameDatabase* database);
+    // threads for object conversion; 0 - chosen by hardware.
+    H3M2FHConverter(const Core::IGameDatabase* database, size_t threads = 0);
 
     void convertMap(const H3Map& src, FHMap& dest) const;
 
 private:
+    struct ObjectsContext {
+        const std::vector<Core::LibraryObjectDef>&            m_objectDefs;
+        const std::vector<Core::LibraryObjectDef>&            m_objectDefsCorrected;
+        const std::map<Core::LibraryPlayerConstPtr, FHPos>&   m_mainTowns;
+        const std::map<Core::LibraryPlayerConstPtr, uint8_t>& m_mainHeroes;
+    };
+    // converted objects of contiguous range of H3Map::m_objects.
+    struct ObjectsChunk {
+        FHMap::Objects      m_objects;
+        std::vector<FHHero> m_wanderingHeroes;
+        std::vector<FHTown> m_towns;
+    };
+    void convertObjects(const H3Map& src, const ObjectsContext& context, size_t begin, size_t end, ObjectsChunk& dest) const;
+
     Core::ResourceAmount             convertResources(const std::vector<uint32_t>& resourceAmount) const;
     Core::HeroPrimaryParams          convertPrim(const std::vector<uint8_t>& arr) const;
     std::vector<Core::UnitWithCount> convertStacks(const std::vector<StackBasicDescriptor>& stacks) const;
@@ -43,6 +60,7 @@ private:
 
 private:
     const Core::IGameDatabase* const m_database;
+    const size_t                     m_threads;
 
     Core::IGameDatabase::LibraryFactionContainerPtr m_factionsContainer;
 
@@ -64,6 +82,7 @@ private:
     std::vector<Core::LibraryUnitConstPtr>           m_unitIds;
 
     std::map<uint32_t, Core::LibraryArtifactConstPtr> m_spellScrollsIds;
+    std::vector<Core::LibraryArtifactConstPtr>        m_spellScrollArtifactIds; // SPELL_SCROLL object artifact, same order as m_spellIds
 };
 
 }
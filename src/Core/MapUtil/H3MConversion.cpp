@@ -10,9 +10,9 @@
 
 namespace FreeHeroes {
 
-void convertH3M2FH(const H3Map& src, FHMap& dest)
+void convertH3M2FH(const H3Map& src, FHMap& dest, size_t threads)
 {
-    H3M2FHConverter converter(dest.m_database);
+    H3M2FHConverter converter(dest.m_database, threads);
     converter.convertMap(src, dest);
 }
 
@@ -11,7 +11,7 @@ namespace FreeHeroes {
 
 struct FHMap;
 struct H3Map;
-void convertH3M2FH(const H3Map& src, FHMap& dest);
+void convertH3M2FH(const H3Map& src, FHMap& dest, size_t threads = 0);
 void convertFH2H3M(const FHMap& src, H3Map& dest);
 
 }
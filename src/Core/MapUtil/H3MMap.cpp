@@ -295,7 +295,7 @@ void H3Map::prepareArrays()
     }
 }
 
-void H3Map::readBinary(ByteOrderDataStreamReader& stream)
+void H3Map::readBinary(ByteOrderDataStreamReader& stream, ReadScope scope)
 {
     *this = {};
     {
@@ -401,6 +401,8 @@ void H3Map::readBinary(ByteOrderDataStreamReader& stream)
         for (PlayerInfo& playerInfo : m_players)
             stream >> playerInfo.m_team;
     }
+    if (scope == ReadScope::Header)
+        return;
 
     auto readBitsSized = [&stream](std::vector<uint8_t>& bitArray, bool sized, bool invert) {
         if (sized) {
@@ -483,6 +485,19 @@ void H3Map::readBinary(ByteOrderDataStreamReader& stream)
     }
     streamTrace(stream, "After tiles");
 
+    m_objectsOffset = stream.getBuffer().getOffsetRead();
+    if (scope == ReadScope::Tiles)
+        return;
+
+    readBinaryObjects(stream);
+}
+
+void H3Map::readBinaryObjects(ByteOrderDataStreamReader& stream)
+{
+    stream.setUserData(m_features.get());
+    m_objectDefs.clear();
+    m_objects.clear();
+    m_globalEvents.clear();
     {
         uint32_t count = 0;
         stream >> count;
@@ -9,6 +9,8 @@
 #include "MernelPlatform/PropertyTree.hpp"
 #include "H3MObjects.hpp"
 
+#include "MapUtilExport.hpp"
+
 #include <set>
 
 namespace FreeHeroes {
@@ -258,7 +260,7 @@ struct CustomHeroDataExt {
 };
 
 struct FHMap;
-struct H3Map {
+struct MAPUTIL_EXPORT H3Map {
     MapFormat m_format = MapFormat::Invalid;
     struct HotaVersion {
         uint32_t m_ver1 = 3;
@@ -381,12 +383,23 @@ struct H3Map {
     // we will save offsets in file for that, to perform byte equality check as close as possible.
     std::set<size_t> m_ignoredOffsets;
 
+    // how far readBinary goes; objects can be read later from m_objectsOffset with readBinaryObjects.
+    enum class ReadScope
+    {
+        Header, // format, name, size, players, victory/loss conditions and teams
+        Tiles,  // everything before object templates
+        Full,
+    };
+    size_t m_objectsOffset = 0;
+
     H3Map();
 
     void updateFeatures();
     void prepareArrays();
 
-    void readBinary(ByteOrderDataStreamReader& stream);
+    void readBinary(ByteOrderDataStreamReader& stream) { readBinary(stream, ReadScope::Full); }
+    void readBinary(ByteOrderDataStreamReader& stream, ReadScope scope);
+    void readBinaryObjects(ByteOrderDataStreamReader& stream);
     void writeBinary(ByteOrderDataStreamWriter& stream) const;
     void toJson(PropertyTree& data) const;
     void fromJson(const PropertyTree& data);
@@ -172,7 +172,7 @@ MapFormatFeatures::MapFormatFeatures(MapFormat format, int hotaVer1)
     m_mapHotaUnknown1 = format >= MapFormat::HOTA1;
 }
 
-std::unique_ptr<IMapObject> IMapObject::Create(MapObjectType type, uint32_t subid)
+std::shared_ptr<IMapObject> IMapObject::Create(MapObjectType type, uint32_t subid)
 {
     using Beh     = MapVisitableWithReward::Behaviour;
     using BehList = MapVisitableWithReward::BehaviourList;
@@ -180,13 +180,13 @@ std::unique_ptr<IMapObject> IMapObject::Create(MapObjectType type, uint32_t subi
     switch (type) {
         case MapObjectType::EVENT:
         {
-            return std::make_unique<MapEvent>();
+            return std::make_shared<MapEvent>();
         }
         case MapObjectType::HERO:
         case MapObjectType::RANDOM_HERO:
         case MapObjectType::PRISON:
         {
-            return std::make_unique<MapHero>();
+            return std::make_shared<MapHero>();
         }
         case MapObjectType::MONSTER:
         case MapObjectType::RANDOM_MONSTER:
@@ -198,29 +198,29 @@ std::unique_ptr<IMapObject> IMapObject::Create(MapObjectType type, uint32_t subi
         case MapObjectType::RANDOM_MONSTER_L6:
         case MapObjectType::RANDOM_MONSTER_L7:
         {
-            return std::make_unique<MapMonster>();
+            return std::make_shared<MapMonster>();
         }
         case MapObjectType::OCEAN_BOTTLE:
         case MapObjectType::SIGN:
         {
-            return std::make_unique<MapSignBottle>();
+            return std::make_shared<MapSignBottle>();
         }
         case MapObjectType::SEER_HUT:
         {
-            return std::make_unique<MapSeerHut>();
+            return std::make_shared<MapSeerHut>();
         }
         case MapObjectType::WITCH_HUT:
         {
-            return std::make_unique<MapWitchHut>();
+            return std::make_shared<MapWitchHut>();
         }
         case MapObjectType::SCHOLAR:
         {
-            return std::make_unique<MapScholar>();
+            return std::make_shared<MapScholar>();
         }
         case MapObjectType::GARRISON:
         case MapObjectType::GARRISON2:
         {
-            return std::make_unique<MapGarison>();
+            return std::make_shared<MapGarison>();
         }
         case MapObjectType::ARTIFACT:
         case MapObjectType::RANDOM_ART:
@@ -230,24 +230,24 @@ std::unique_ptr<IMapObject> IMapObject::Create(MapObjectType type, uint32_t subi
         case MapObjectType::RANDOM_RELIC_ART:
         case MapObjectType::SPELL_SCROLL:
         {
-            return std::make_unique<MapArtifact>(type == MapObjectType::SPELL_SCROLL);
+            return std::make_shared<MapArtifact>(type == MapObjectType::SPELL_SCROLL);
         }
         case MapObjectType::RANDOM_RESOURCE:
         case MapObjectType::RESOURCE:
         {
-            return std::make_unique<MapResource>();
+            return std::make_shared<MapResource>();
         }
         case MapObjectType::RANDOM_TOWN:
         case MapObjectType::TOWN:
         {
-            return std::make_unique<MapTown>();
+            return std::make_shared<MapTown>();
         }
         case MapObjectType::MINE:
         case MapObjectType::ABANDONED_MINE:
         {
             if (subid >= 7)
-                return std::make_unique<MapAbandonedMine>();
-            return std::make_unique<MapObjectWithOwner>();
+                return std::make_shared<MapAbandonedMine>();
+            return std::make_shared<MapObjectWithOwner>();
         }
         case MapObjectType::CREATURE_GENERATOR1:
         case MapObjectType::CREATURE_GENERATOR2:
@@ -256,25 +256,25 @@ std::unique_ptr<IMapObject> IMapObject::Create(MapObjectType type, uint32_t subi
         case MapObjectType::SHIPYARD:
         case MapObjectType::LIGHTHOUSE:
         {
-            return std::make_unique<MapObjectWithOwner>();
+            return std::make_shared<MapObjectWithOwner>();
         }
         case MapObjectType::SHRINE_OF_MAGIC_INCANTATION:
         case MapObjectType::SHRINE_OF_MAGIC_GESTURE:
         case MapObjectType::SHRINE_OF_MAGIC_THOUGHT:
         {
-            return std::make_unique<MapShrine>();
+            return std::make_shared<MapShrine>();
         }
         case MapObjectType::PANDORAS_BOX:
         {
-            return std::make_unique<MapPandora>();
+            return std::make_shared<MapPandora>();
         }
         case MapObjectType::GRAIL:
         {
-            return std::make_unique<MapGrail>();
+            return std::make_shared<MapGrail>();
         }
         case MapObjectType::QUEST_GUARD:
         {
-            return std::make_unique<MapQuestGuard>();
+            return std::make_shared<MapQuestGuard>();
         }
         case MapObjectType::RANDOM_DWELLING:         //same as castle + level range  216
         case MapObjectType::RANDOM_DWELLING_LVL:     //same as castle, fixed level   217
@@ -282,12 +282,12 @@ std::unique_ptr<IMapObject> IMapObject::Create(MapObjectType type, uint32_t subi
         {
             bool hasFaction = type == MapObjectType::RANDOM_DWELLING || type == MapObjectType::RANDOM_DWELLING_LVL;
             bool hasLevel   = type == MapObjectType::RANDOM_DWELLING || type == MapObjectType::RANDOM_DWELLING_FACTION;
-            return std::make_unique<MapDwelling>(hasFaction, hasLevel);
+            return std::make_shared<MapDwelling>(hasFaction, hasLevel);
         }
 
         case MapObjectType::HERO_PLACEHOLDER:
         {
-            return std::make_unique<MapHeroPlaceholder>();
+            return std::make_shared<MapHeroPlaceholder>();
         }
         case MapObjectType::CREATURE_BANK:
         case MapObjectType::DERELICT_SHIP:
@@ -295,92 +295,92 @@ std::unique_ptr<IMapObject> IMapObject::Create(MapObjectType type, uint32_t subi
         case MapObjectType::CRYPT:
         case MapObjectType::SHIPWRECK:
         {
-            return std::make_unique<MapObjectCreatureBank>();
+            return std::make_shared<MapObjectCreatureBank>();
         }
         case MapObjectType::BORDER_GATE:
         {
             if (subid == 1000)
-                return std::make_unique<MapQuestGuard>();
+                return std::make_shared<MapQuestGuard>();
             if (subid == 1001)
-                return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact, Beh::Resource1 });
-            return std::make_unique<MapObjectSimple>();
+                return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact, Beh::Resource1 });
+            return std::make_shared<MapObjectSimple>();
         }
         case MapObjectType::BLACK_MARKET:
         {
-            return std::make_unique<MapVisitableWithReward>(BehList{ Beh::ArtifactsSale });
+            return std::make_shared<MapVisitableWithReward>(BehList{ Beh::ArtifactsSale });
         }
         case MapObjectType::UNIVERSITY:
         {
-            return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::SecondarySkills });
+            return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::SecondarySkills });
         }
         case MapObjectType::TREASURE_CHEST:
         {
-            return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact });
+            return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact });
         }
         case MapObjectType::SEA_CHEST:
         {
-            return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact });
+            return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact });
         }
         case MapObjectType::TREE_OF_KNOWLEDGE:
         {
-            return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::ArtifactStub });
+            return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::ArtifactStub });
         }
         case MapObjectType::FLOTSAM:
         {
-            return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact });
+            return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact });
         }
         case MapObjectType::LEAN_TO:
         {
-            return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::ArtifactStub, Beh::Resource1 });
+            return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::ArtifactStub, Beh::Resource1 });
         }
         case MapObjectType::CAMPFIRE:
         {
-            return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::ArtifactStub, Beh::Resource1, Beh::Resource2 });
+            return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::ArtifactStub, Beh::Resource1, Beh::Resource2 });
         }
         case MapObjectType::HOTA_VISITABLE_2:
         {
             if (subid == (uint32_t) MapObjectType::HOTA_VISITABLE_2_ANCIENT_LAMP)
-                return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact, Beh::UnitCount });
+                return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact, Beh::UnitCount });
             if (subid == (uint32_t) MapObjectType::HOTA_VISITABLE_2_WATER_BARREL)
-                return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact, Beh::Resource1 });
+                return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact, Beh::Resource1 });
             if (subid == (uint32_t) MapObjectType::HOTA_VISITABLE_2_JETSAM)
-                return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact });
+                return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact });
             if (subid == (uint32_t) MapObjectType::HOTA_VISITABLE_2_MANA_VIAL)
-                return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact });
+                return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact });
 
             assert(!"Should not happen");
-            return std::make_unique<MapObjectSimple>();
+            return std::make_shared<MapObjectSimple>();
         }
         case MapObjectType::HOTA_VISITABLE_3:
         {
             if (subid == (uint32_t) MapObjectType::HOTA_VISITABLE_3_WATER_ACADEMY)
-                return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::SecondarySkills });
+                return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::SecondarySkills });
 
-            return std::make_unique<MapObjectSimple>();
+            return std::make_shared<MapObjectSimple>();
         }
         case MapObjectType::CORPSE:
         {
-            return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact });
+            return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact });
         }
         case MapObjectType::WAGON:
         {
-            return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact, Beh::Resource1 });
+            return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact, Beh::Resource1 });
         }
         case MapObjectType::SHIPWRECK_SURVIVOR:
         {
-            return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact });
+            return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact });
         }
         case MapObjectType::WARRIORS_TOMB:
         {
-            return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact });
+            return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Artifact });
         }
         case MapObjectType::PYRAMID:
         {
-            return std::make_unique<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Spell });
+            return std::make_shared<MapVisitableWithReward>(BehList{ Beh::Option, Beh::Spell });
         }
         default:
         {
-            return std::make_unique<MapObjectSimple>();
+            return std::make_shared<MapObjectSimple>();
         }
     }
 }
@@ -9,6 +9,7 @@
 #include "MernelPlatform/PropertyTree.hpp"
 
 #include <algorithm>
+#include <memory>
 
 namespace FreeHeroes {
 using ByteOrderDataStreamReader = Mernel::ByteOrderDataStreamReader;
@@ -392,7 +393,7 @@ struct IMapObject {
     virtual void toJson(PropertyTree& data) const                     = 0;
     virtual void fromJson(const PropertyTree& data)                   = 0;
 
-    static std::unique_ptr<IMapObject> Create(MapObjectType type, uint32_t subid);
+    static std::shared_ptr<IMapObject> Create(MapObjectType type, uint32_t subid);
 };
 
 struct StackBasicDescriptor {
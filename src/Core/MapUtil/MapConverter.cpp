@@ -35,6 +35,8 @@ ENUM_REFLECTION_STRINGIFY(
     SaveH3MRaw,
     LoadH3M,
     SaveH3M,
+    LoadH3MHeader,
+    LoadH3MTiles,
     ConvertH3MToJson,
     ConvertJsonToH3M,
     H3MRoundTripJson,
@@ -68,6 +70,8 @@ ENUM_REFLECTION_STRINGIFY(
     SaveFHTpl,
     LoadFH,
     SaveFH,
+    LoadFHBinary,
+    SaveFHBinary,
     LoadFolder,
     SaveFolder,
 
@@ -116,6 +120,12 @@ MapConverter::MapConverter(std::ostream&                        logOutput,
 {
 }
 
+void MapConverter::preloadDatabases(const Core::IGameDatabaseContainer* databaseContainer)
+{
+    for (auto version : { Core::GameVersion::SOD, Core::GameVersion::HOTA, Core::GameVersion::HOTA_FACTORY })
+        (void) databaseContainer->getDatabase(version);
+}
+
 void MapConverter::run(Task task, int recurse) noexcept(false)
 {
     try {
@@ -157,6 +167,19 @@ void MapConverter::run(Task task, int recurse) noexcept(false)
                 setOutput(m_outputs.m_h3m.m_binary);
                 runMember(writeBinaryBufferData);
             } break;
+            case Task::LoadH3MHeader:
+            case Task::LoadH3MTiles:
+            {
+                setInput(m_inputs.m_h3m.m_binary);
+                runMember(readBinaryBufferData);
+
+                runMember(detectCompression);
+                runMember(uncompressRaw);
+                if (task == Task::LoadH3MHeader)
+                    runMember(binaryDeserializeH3MHeader);
+                else
+                    runMember(binaryDeserializeH3MTiles);
+            } break;
             case Task::LoadH3M:
             {
                 run(Task::LoadH3MRaw, recurse + 1);
@@ -518,6 +541,27 @@ void MapConverter::run(Task task, int recurse) noexcept(false)
                 setOutput(m_outputs.m_fhMap);
                 runMember(writeJsonFromProperty);
             } break;
+            case Task::LoadFHBinary:
+            {
+                setInput(m_inputs.m_fhMap);
+                runMember(readBinaryBufferData);
+
+                runMember(detectCompression);
+                runMember(uncompressRaw);
+                runMember(binaryDeserializeProperty);
+
+                runMember(propertyDeserializeFH);
+            } break;
+            case Task::SaveFHBinary:
+            {
+                runMember(propertySerializeFH);
+                runMember(binarySerializeProperty);
+
+                m_mainFile.m_compressionMethod = CompressionMethod::Gzip;
+                runMember(compressRaw);
+                setOutput(m_outputs.m_fhMap);
+                runMember(writeBinaryBufferData);
+            } break;
             case Task::LoadFolder:
             {
                 setInput(m_inputs.m_folder);
@@ -575,7 +619,8 @@ void MapConverter::run(Task task, int recurse) noexcept(false)
 
                 runMember(generateFHMapFromFHTpl);
 
-                run(Task::SaveFH, recurse + 1);
+                if (m_templateSettings.m_saveResult)
+                    run(Task::SaveFH, recurse + 1);
             } break;
 
             // utilities
@@ -664,6 +709,16 @@ void MapConverter::writeJsonFromProperty()
     m_mainFile.writeJsonFromProperty();
 }
 
+void MapConverter::binaryDeserializeProperty()
+{
+    m_mainFile.readBinaryToPropertyFromBuffer();
+}
+
+void MapConverter::binarySerializeProperty()
+{
+    m_mainFile.writeBinaryFromPropertyToBuffer();
+}
+
 void MapConverter::detectCompression()
 {
     m_mainFile.detectCompression();
@@ -691,6 +746,21 @@ void MapConverter::compressRawParts()
 }
 
 void MapConverter::binaryDeserializeH3M()
+{
+    binaryDeserializeH3M(H3Map::ReadScope::Full);
+}
+
+void MapConverter::binaryDeserializeH3MHeader()
+{
+    binaryDeserializeH3M(H3Map::ReadScope::Header);
+}
+
+void MapConverter::binaryDeserializeH3MTiles()
+{
+    binaryDeserializeH3M(H3Map::ReadScope::Tiles);
+}
+
+void MapConverter::binaryDeserializeH3M(H3Map::ReadScope scope)
 {
     if (m_mainFile.m_rawState != RawState::Uncompressed)
         throw std::runtime_error("Buffer needs to be in Uncompressed state.");
@@ -699,7 +769,7 @@ void MapConverter::binaryDeserializeH3M()
     ByteOrderDataStreamReader reader(bobuffer, ByteOrderDataStream::s_littleEndian);
 
     try {
-        reader >> m_mapH3M;
+        m_mapH3M.readBinary(reader, scope);
         m_ignoredOffsets = m_mapH3M.m_ignoredOffsets;
     }
     catch (std::exception& ex) {
@@ -881,7 +951,7 @@ void MapConverter::convertH3MtoFH()
         version = Core::GameVersion::HOTA_FACTORY;
 
     m_mapFH.m_database = m_databaseContainer->getDatabase(version);
-    convertH3M2FH(m_mapH3M, m_mapFH);
+    convertH3M2FH(m_mapH3M, m_mapFH, m_settings.m_threads);
 }
 
 void MapConverter::convertFHtoH3SVG()
@@ -929,6 +999,10 @@ void MapConverter::generateFHMapFromFHTpl()
 
     rng->setSeed(m_mapFH.m_seed);
 
+    FHPreparedTemplateConstPtr prepared;
+    if (m_templateSettings.m_preparedCache)
+        prepared = m_templateSettings.m_preparedCache->get(m_mapFH.m_database, m_mapFH.m_tileMap.m_width, m_mapFH.m_tileMap.m_height, m_mapFH.m_tileMap.m_depth);
+
     FHTemplateProcessor converter(m_mapFH,
                                   rng.get(),
                                   m_logOutput,
@@ -936,8 +1010,19 @@ void MapConverter::generateFHMapFromFHTpl()
                                   m_templateSettings.m_showDebugStage,
                                   m_templateSettings.m_tileFilter,
                                   m_templateSettings.m_stopAfterHeat,
-                                  m_templateSettings.m_extraLogging);
-    converter.run();
+                                  m_templateSettings.m_extraLogging,
+                                  m_templateSettings.m_checkpointDir,
+                                  m_templateSettings.m_resumeFrom,
+                                  prepared,
+                                  m_settings.m_threads);
+    try {
+        converter.run();
+    }
+    catch (...) {
+        m_templateStats = converter.getStats();
+        throw;
+    }
+    m_templateStats = converter.getStats();
 }
 
 void MapConverter::checkBinaryInputOutputEquality()
@@ -15,6 +15,7 @@
 #include "H3Template.hpp"
 
 #include "MapConverterFile.hpp"
+#include "FHTemplateProcessor.hpp"
 
 #include "MapUtilExport.hpp"
 
@@ -57,6 +58,7 @@ public:
         PathsSet m_outputs;
         bool     m_dumpUncompressedBuffers = false;
         bool     m_dumpBinaryDataJson      = false;
+        size_t   m_threads                 = 0; // for work inside one map; 0 - chosen by hardware, batch tools use 1
     };
 
     struct TemplateSettings {
@@ -67,6 +69,11 @@ public:
         std::string      m_showDebugStage;
         std::string      m_tileFilter;
         int              m_stopAfterHeat = 1000;
+        Mernel::std_path m_checkpointDir; // save generation state after each stage
+        Mernel::std_path m_resumeFrom;    // skip stages already stored in checkpoint
+        bool             m_saveResult = true; // GenerateFHMap writes fhMap output
+
+        std::shared_ptr<FHPreparedTemplateCache> m_preparedCache; // seed-independent data, shared between runs
     };
 
     enum class Task
@@ -78,6 +85,8 @@ public:
         SaveH3MRaw,
         LoadH3M,
         SaveH3M,
+        LoadH3MHeader, // only m_mapH3M header and players, no FH conversion
+        LoadH3MTiles,  // m_mapH3M without objects, they can be read later from m_objectsOffset
         ConvertH3MToJson,
         ConvertJsonToH3M,
         H3MRoundTripJson,
@@ -111,6 +120,8 @@ public:
         SaveFHTpl,
         LoadFH,
         SaveFH,
+        LoadFHBinary, // same as LoadFH, but from compact .fhmapb instead of json
+        SaveFHBinary,
         LoadFolder,
         SaveFolder,
 
@@ -139,6 +150,9 @@ public:
     void setSettings(Settings settings) { m_settings = std::move(settings); }
     void setTemplateSettings(TemplateSettings settings) { m_templateSettings = std::move(settings); }
 
+    // database container loads lazily and is not thread-safe, so call this before converters run on several threads.
+    static void preloadDatabases(const Core::IGameDatabaseContainer* databaseContainer);
+
     void run(Task command, int recurse = 0) noexcept(false);
 
 public: // todo:
@@ -150,6 +164,8 @@ public: // todo:
     MapConverterFile   m_mainFile;
     MapConverterFolder m_folder;
 
+    FHTemplateProcessor::RunStats m_templateStats;
+
 private:
     using MemberProc = void (MapConverter::*)(void);
     void run(MemberProc member, const char* descr, int recurse) noexcept(false);
@@ -167,6 +183,10 @@ private:
     void readJsonToProperty();
     void writeJsonFromProperty();
 
+    // binary property I/O
+    void binaryDeserializeProperty();
+    void binarySerializeProperty();
+
     // Compression tasks
     void detectCompression();
     void uncompressRaw();
@@ -176,6 +196,8 @@ private:
 
     // Primitive tasks
     void binaryDeserializeH3M();
+    void binaryDeserializeH3MHeader();
+    void binaryDeserializeH3MTiles();
     void binarySerializeH3M();
     void propertySerializeH3M();
     void propertyDeserializeH3M();
@@ -200,6 +222,8 @@ private:
     void propertySerializeFHTpl();
     void propertyDeserializeFHTpl();
 
+    void binaryDeserializeH3M(H3Map::ReadScope scope);
+
     void convertFHtoH3M();
     void convertH3MtoFH();
     void convertFHtoH3SVG();
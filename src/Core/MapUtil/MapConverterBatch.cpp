@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2024 Smirnov Vladimir / mapron1@gmail.com
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file for details.
+ */
+#include "MapConverterBatch.hpp"
+
+#include "MernelExecution/ParallelExecutor.hpp"
+#include "MernelExecution/TaskQueue.hpp"
+
+#include <mutex>
+#include <ostream>
+#include <sstream>
+
+namespace FreeHeroes {
+
+MapConverterBatch::MapConverterBatch(std::ostream&                        logOutput,
+                                     const Core::IGameDatabaseContainer*  databaseContainer,
+                                     const Core::IRandomGeneratorFactory* rngFactory)
+    : m_logOutput(logOutput)
+    , m_databaseContainer(databaseContainer)
+    , m_rngFactory(rngFactory)
+{
+}
+
+std::vector<MapConverterBatch::Result> MapConverterBatch::run(const std::vector<MapConverter::Settings>& batch, const std::vector<MapConverter::Task>& tasks, size_t jobs)
+{
+    std::vector<Result> results(batch.size());
+    if (batch.empty())
+        return results;
+
+    if (jobs <= 1) {
+        MapConverter converter(m_logOutput, m_databaseContainer, m_rngFactory, batch[0]);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            converter.setSettings(batch[i]);
+            results[i] = runTasks(converter, m_logOutput, tasks);
+        }
+        return results;
+    }
+
+    MapConverter::preloadDatabases(m_databaseContainer);
+
+    std::mutex logMutex;
+    size_t     finished = 0;
+
+    Mernel::TaskQueue taskQueue;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        taskQueue.addTask([&, i] {
+            // items already run in parallel, so work inside one map is not split further.
+            MapConverter::Settings settings = batch[i];
+            settings.m_threads              = 1;
+
+            std::ostringstream log;
+            MapConverter       converter(log, m_databaseContainer, m_rngFactory, std::move(settings));
+            results[i] = runTasks(converter, log, tasks);
+
+            static constexpr const char* s_statusNames[] = { "done", "FAILED round-trip", "FATAL" };
+
+            std::lock_guard lock(logMutex);
+            finished++;
+            m_logOutput << log.str();
+            m_logOutput << "[" << finished << "/" << batch.size() << "] " << batch[i].m_inputs.m_h3m.m_binary << " "
+                        << s_statusNames[static_cast<int>(results[i].m_status)] << "\n";
+        });
+    }
+    Mernel::ParallelExecutor executor(jobs);
+    executor.execQueue(taskQueue);
+    return results;
+}
+
+void MapConverterBatch::writeSummaryJson(Mernel::PropertyTree& json, const std::vector<MapConverter::Settings>& batch, const std::vector<Result>& results)
+{
+    using namespace Mernel;
+
+    PropertyTree& succeeded = json["succeeded"];
+    PropertyTree& failed    = json["failedRoundTrip"];
+    PropertyTree& fatal     = json["fatal"];
+    succeeded.convertToList();
+    failed.convertToList();
+    fatal.convertToList();
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const std::string path = path2string(batch[i].m_inputs.m_h3m.m_binary);
+        if (results[i].m_status == RunStatus::Succeeded) {
+            succeeded.append(PropertyTreeScalar(path));
+        } else if (results[i].m_status == RunStatus::FailedRoundTrip) {
+            failed.append(PropertyTreeScalar(path));
+        } else {
+            PropertyTree item;
+            item["path"]  = PropertyTreeScalar(path);
+            item["error"] = PropertyTreeScalar(results[i].m_error);
+            fatal.append(std::move(item));
+        }
+    }
+}
+
+MapConverterBatch::Result MapConverterBatch::runTasks(MapConverter& converter, std::ostream& log, const std::vector<MapConverter::Task>& tasks)
+{
+    Result result;
+    for (const MapConverter::Task task : tasks) {
+        try {
+            converter.run(task);
+        }
+        catch (MapConverter::RoundTripException&) {
+            if (result.m_status == RunStatus::Succeeded)
+                result.m_status = RunStatus::FailedRoundTrip;
+            continue;
+        }
+        catch (std::exception& ex) {
+            log << ex.what() << "\n";
+            result.m_status = RunStatus::Fatal;
+            result.m_error  = ex.what();
+            continue;
+        }
+    }
+    return result;
+}
+
+}
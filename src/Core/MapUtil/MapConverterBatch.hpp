@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2024 Smirnov Vladimir / mapron1@gmail.com
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file for details.
+ */
+#pragma once
+
+#include "MapConverter.hpp"
+
+#include "MernelPlatform/PropertyTree.hpp"
+
+#include "MapUtilExport.hpp"
+
+#include <string>
+#include <vector>
+
+namespace FreeHeroes {
+
+// Same converter tasks run for every item of a batch, e.g. all maps of a folder.
+class MAPUTIL_EXPORT MapConverterBatch {
+public:
+    enum class RunStatus
+    {
+        Succeeded,
+        FailedRoundTrip,
+        Fatal,
+    };
+    struct Result {
+        RunStatus   m_status = RunStatus::Succeeded;
+        std::string m_error;
+    };
+
+    MapConverterBatch(std::ostream&                        logOutput,
+                      const Core::IGameDatabaseContainer*  databaseContainer,
+                      const Core::IRandomGeneratorFactory* rngFactory);
+
+    // with jobs > 1 every item gets own converter; its log is printed at once when item is done.
+    std::vector<Result> run(const std::vector<MapConverter::Settings>& batch, const std::vector<MapConverter::Task>& tasks, size_t jobs);
+
+    // h3m input paths by status, fatal ones with error text.
+    static void writeSummaryJson(Mernel::PropertyTree& json, const std::vector<MapConverter::Settings>& batch, const std::vector<Result>& results);
+
+private:
+    static Result runTasks(MapConverter& converter, std::ostream& log, const std::vector<MapConverter::Task>& tasks);
+
+private:
+    std::ostream&                              m_logOutput;
+    const Core::IGameDatabaseContainer* const  m_databaseContainer;
+    const Core::IRandomGeneratorFactory* const m_rngFactory;
+};
+
+}
@@ -9,8 +9,15 @@
 #include "MernelPlatform/FileFormatJson.hpp"
 #include "MernelPlatform/FileFormatCSV.hpp"
 #include "MernelPlatform/Compression.hpp"
+#include "MernelPlatform/ByteOrderStream.hpp"
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
 #include <cstring>
+#include <fstream>
+#include <unordered_map>
 
 namespace FreeHeroes {
 
@@ -28,6 +35,475 @@ void uncompressGzip(Mernel::ByteArrayHolder& data)
     data = std::move(out);
 }
 
+constexpr const std::array<uint8_t, 4> g_binaryPropertySignature{ { 0x46, 0x48, 0x50, 0x54 } }; // 'FHPT'
+constexpr const uint32_t               g_binaryPropertyVersion = 1;
+
+enum class BinaryPropertyNode : uint8_t
+{
+    Null,
+    False,
+    True,
+    Int,
+    Double,
+    String,
+    List,
+    Map,
+};
+
+class BinaryPropertyWriter {
+public:
+    void write(const Mernel::PropertyTree& node, Mernel::ByteOrderDataStreamWriter& stream)
+    {
+        using enum BinaryPropertyNode;
+        if (node.isMap()) {
+            stream << static_cast<uint8_t>(Map) << static_cast<uint32_t>(node.getMap().size());
+            for (const auto& [key, child] : node.getMap()) {
+                stream << intern(key);
+                write(child, stream);
+            }
+        } else if (node.isList()) {
+            stream << static_cast<uint8_t>(List) << static_cast<uint32_t>(node.getList().size());
+            for (const auto& child : node.getList())
+                write(child, stream);
+        } else if (node.isScalar()) {
+            const auto& scalar = node.getScalar();
+            if (scalar.isBool())
+                stream << static_cast<uint8_t>(scalar.toBool() ? True : False);
+            else if (scalar.isInt())
+                stream << static_cast<uint8_t>(Int) << scalar.toInt();
+            else if (scalar.isDouble())
+                stream << static_cast<uint8_t>(Double) << std::bit_cast<uint64_t>(scalar.toDouble());
+            else if (scalar.isString())
+                stream << static_cast<uint8_t>(String) << intern(scalar.toString());
+            else
+                stream << static_cast<uint8_t>(Null);
+        } else {
+            stream << static_cast<uint8_t>(Null);
+        }
+    }
+
+    std::vector<std::string> m_strings;
+
+private:
+    uint32_t intern(const std::string& str)
+    {
+        auto [it, inserted] = m_stringIndex.try_emplace(str, static_cast<uint32_t>(m_strings.size()));
+        if (inserted)
+            m_strings.push_back(str);
+        return it->second;
+    }
+
+    std::unordered_map<std::string, uint32_t> m_stringIndex;
+};
+
+// data may come from untrusted file, so sizes are checked against bytes left before anything is allocated.
+class BinaryPropertyReader {
+public:
+    static constexpr int s_maxDepth = 512;
+
+    void read(Mernel::PropertyTree& node, Mernel::ByteOrderDataStreamReader& stream, int depth = 0) const
+    {
+        using enum BinaryPropertyNode;
+        if (depth > s_maxDepth)
+            throw std::runtime_error("Binary property data is nested too deep");
+        uint8_t type;
+        stream >> type;
+        switch (static_cast<BinaryPropertyNode>(type)) {
+            case Null:
+                node = {};
+                break;
+            case False:
+            case True:
+                node = Mernel::PropertyTreeScalar(type == static_cast<uint8_t>(True));
+                break;
+            case Int:
+            {
+                int64_t value;
+                stream >> value;
+                node = Mernel::PropertyTreeScalar(value);
+            } break;
+            case Double:
+            {
+                uint64_t value;
+                stream >> value;
+                node = Mernel::PropertyTreeScalar(std::bit_cast<double>(value));
+            } break;
+            case String:
+                node = Mernel::PropertyTreeScalar(readString(stream));
+                break;
+            case List:
+            {
+                uint32_t size;
+                stream >> size;
+                checkRemaining(stream, size, 1); // type byte of each item
+                node.convertToList();
+                for (uint32_t i = 0; i < size; ++i) {
+                    Mernel::PropertyTree child;
+                    read(child, stream, depth + 1);
+                    node.append(std::move(child));
+                }
+            } break;
+            case Map:
+            {
+                uint32_t size;
+                stream >> size;
+                checkRemaining(stream, size, sizeof(uint32_t) + 1); // key index and type byte of each item
+                node.convertToMap();
+                for (uint32_t i = 0; i < size; ++i) {
+                    const std::string& key = readString(stream);
+                    read(node[key], stream, depth + 1);
+                }
+            } break;
+            default:
+                throw std::runtime_error("Invalid node type in binary property data: " + std::to_string(type));
+        }
+    }
+
+    std::vector<std::string> m_strings;
+
+    static void checkRemaining(Mernel::ByteOrderDataStreamReader& stream, uint32_t count, size_t minItemSize)
+    {
+        const auto&  buffer = stream.getBuffer();
+        const size_t remain = buffer.getSize() - std::min(buffer.getSize(), buffer.getOffsetRead());
+        if (count > remain / minItemSize)
+            throw std::runtime_error("Binary property data is truncated, expected at least " + std::to_string(count) + " items");
+    }
+
+private:
+    const std::string& readString(Mernel::ByteOrderDataStreamReader& stream) const
+    {
+        uint32_t index;
+        stream >> index;
+        if (index >= m_strings.size())
+            throw std::runtime_error("Invalid string index in binary property data: " + std::to_string(index));
+        return m_strings[index];
+    }
+};
+
+constexpr const size_t g_jsonStreamBufferSize = 1 << 16;
+
+// Writes compact JSON text directly into stream, so text of the whole document is never held in memory.
+// Scalars and containers without nested containers are formatted by Mernel, so output is byte to byte the same as writeJsonToBuffer().
+class JsonStreamWriter {
+public:
+    explicit JsonStreamWriter(std::ostream& stream)
+        : m_stream(stream)
+    {}
+
+    void write(const Mernel::PropertyTree& node)
+    {
+        if (!hasNestedContainers(node)) {
+            m_stream << Mernel::writeJsonToBuffer(node);
+        } else if (node.isMap()) {
+            m_stream.put('{');
+            bool first = true;
+            for (const auto& [key, child] : node.getMap()) {
+                if (!first)
+                    m_stream.put(',');
+                first = false;
+                m_stream << Mernel::writeJsonToBuffer(Mernel::PropertyTreeScalar(key));
+                m_stream.put(':');
+                write(child);
+            }
+            m_stream.put('}');
+        } else {
+            m_stream.put('[');
+            bool first = true;
+            for (const auto& child : node.getList()) {
+                if (!first)
+                    m_stream.put(',');
+                first = false;
+                write(child);
+            }
+            m_stream.put(']');
+        }
+    }
+
+private:
+    static bool hasNestedContainers(const Mernel::PropertyTree& node)
+    {
+        auto isContainer = [](const Mernel::PropertyTree& child) { return child.isMap() || child.isList(); };
+        if (node.isMap())
+            return std::any_of(node.getMap().cbegin(), node.getMap().cend(), [&isContainer](const auto& item) { return isContainer(item.second); });
+        if (node.isList())
+            return std::any_of(node.getList().cbegin(), node.getList().cend(), isContainer);
+        return false;
+    }
+
+    std::ostream& m_stream;
+};
+
+// Pull parser reading JSON text from stream; input is consumed char by char, so whole text is never held in memory.
+class JsonStreamReader {
+public:
+    explicit JsonStreamReader(std::istream& stream)
+        : m_buf(*stream.rdbuf())
+    {
+        // skip UTF-8 BOM.
+        if (m_buf.sgetc() == 0xEF) {
+            get();
+            if (get() != 0xBB || get() != 0xBF)
+                fail("invalid BOM");
+        }
+    }
+
+    static constexpr int s_maxDepth = 512;
+
+    void read(Mernel::PropertyTree& node, int depth = 0)
+    {
+        if (depth > s_maxDepth)
+            fail("nested too deep");
+        const int c = peekNonSpace();
+        if (c == '{') {
+            get();
+            node.convertToMap();
+            if (peekNonSpace() == '}') {
+                get();
+                return;
+            }
+            while (true) {
+                if (peekNonSpace() != '"')
+                    fail("expected key");
+                const std::string key = readString();
+                expect(':');
+                read(node[key], depth + 1);
+                if (getNonSpace() == '}')
+                    return;
+                if (m_last != ',')
+                    fail("expected ',' or '}'");
+            }
+        } else if (c == '[') {
+            get();
+            node.convertToList();
+            if (peekNonSpace() == ']') {
+                get();
+                return;
+            }
+            while (true) {
+                Mernel::PropertyTree child;
+                read(child, depth + 1);
+                node.append(std::move(child));
+                if (getNonSpace() == ']')
+                    return;
+                if (m_last != ',')
+                    fail("expected ',' or ']'");
+            }
+        } else if (c == '"') {
+            node = Mernel::PropertyTreeScalar(readString());
+        } else if (c == 't') {
+            readLiteral("true");
+            node = Mernel::PropertyTreeScalar(true);
+        } else if (c == 'f') {
+            readLiteral("false");
+            node = Mernel::PropertyTreeScalar(false);
+        } else if (c == 'n') {
+            readLiteral("null");
+            node = {};
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            readNumber(node);
+        } else {
+            fail("unexpected character");
+        }
+    }
+
+    void finish()
+    {
+        if (peekNonSpace() != std::char_traits<char>::eof())
+            fail("trailing data");
+    }
+
+private:
+    int get()
+    {
+        m_offset++;
+        m_last = m_buf.sbumpc();
+        return m_last;
+    }
+
+    int peekNonSpace()
+    {
+        int c = m_buf.sgetc();
+        while (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+            get();
+            c = m_buf.sgetc();
+        }
+        return c;
+    }
+
+    int getNonSpace()
+    {
+        peekNonSpace();
+        return get();
+    }
+
+    void expect(char expected)
+    {
+        if (getNonSpace() != expected)
+            fail(std::string("expected '") + expected + "'");
+    }
+
+    void readLiteral(std::string_view literal)
+    {
+        for (const char c : literal) {
+            if (get() != c)
+                fail("invalid literal");
+        }
+    }
+
+    // strict JSON grammar: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+    void readNumber(Mernel::PropertyTree& node)
+    {
+        std::string text;
+        auto        isDigit    = [](int c) { return c >= '0' && c <= '9'; };
+        auto        readDigits = [this, &text, &isDigit] {
+            if (!isDigit(m_buf.sgetc()))
+                fail("invalid number '" + text + "'");
+            while (isDigit(m_buf.sgetc()))
+                text += static_cast<char>(get());
+        };
+        if (m_buf.sgetc() == '-')
+            text += static_cast<char>(get());
+        if (m_buf.sgetc() == '0')
+            text += static_cast<char>(get());
+        else
+            readDigits();
+        bool isDouble = false;
+        if (m_buf.sgetc() == '.') {
+            isDouble = true;
+            text += static_cast<char>(get());
+            readDigits();
+        }
+        if (m_buf.sgetc() == 'e' || m_buf.sgetc() == 'E') {
+            isDouble = true;
+            text += static_cast<char>(get());
+            if (m_buf.sgetc() == '-' || m_buf.sgetc() == '+')
+                text += static_cast<char>(get());
+            readDigits();
+        }
+        if (isDigit(m_buf.sgetc()))
+            fail("invalid number '" + text + "'"); // leading zero
+
+        const char* end = text.data() + text.size();
+        if (!isDouble) {
+            int64_t value;
+            auto [ptr, ec] = std::from_chars(text.data(), end, value);
+            if (ec == std::errc() && ptr == end) {
+                node = Mernel::PropertyTreeScalar(value);
+                return;
+            }
+        }
+        double value;
+        auto [ptr, ec] = std::from_chars(text.data(), end, value);
+        if (ec != std::errc() || ptr != end)
+            fail("invalid number '" + text + "'");
+        node = Mernel::PropertyTreeScalar(value);
+    }
+
+    std::string readString()
+    {
+        get(); // opening quote
+        std::string result;
+        while (true) {
+            const int c = get();
+            if (c == std::char_traits<char>::eof())
+                fail("unterminated string");
+            if (c == '"')
+                return result;
+            if (c != '\\') {
+                result += static_cast<char>(c);
+                continue;
+            }
+            switch (get()) {
+                case '"':
+                    result += '"';
+                    break;
+                case '\\':
+                    result += '\\';
+                    break;
+                case '/':
+                    result += '/';
+                    break;
+                case 'b':
+                    result += '\b';
+                    break;
+                case 'f':
+                    result += '\f';
+                    break;
+                case 'n':
+                    result += '\n';
+                    break;
+                case 'r':
+                    result += '\r';
+                    break;
+                case 't':
+                    result += '\t';
+                    break;
+                case 'u':
+                {
+                    uint32_t code = readHex4();
+                    if (code >= 0xD800 && code < 0xDC00) {
+                        if (get() != '\\' || get() != 'u')
+                            fail("invalid surrogate pair");
+                        const uint32_t low = readHex4();
+                        if (low < 0xDC00 || low >= 0xE000)
+                            fail("invalid surrogate pair");
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(result, code);
+                } break;
+                default:
+                    fail("invalid escape sequence");
+            }
+        }
+    }
+
+    uint32_t readHex4()
+    {
+        uint32_t code = 0;
+        for (int i = 0; i < 4; ++i) {
+            const int c = get();
+            code <<= 4;
+            if (c >= '0' && c <= '9')
+                code |= c - '0';
+            else if (c >= 'a' && c <= 'f')
+                code |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                code |= c - 'A' + 10;
+            else
+                fail("invalid \\u escape");
+        }
+        return code;
+    }
+
+    static void appendUtf8(std::string& str, uint32_t code)
+    {
+        if (code < 0x80) {
+            str += static_cast<char>(code);
+        } else if (code < 0x800) {
+            str += static_cast<char>(0xC0 | (code >> 6));
+            str += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            str += static_cast<char>(0xE0 | (code >> 12));
+            str += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            str += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            str += static_cast<char>(0xF0 | (code >> 18));
+            str += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            str += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            str += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    [[noreturn]] void fail(const std::string& message) const
+    {
+        throw std::runtime_error("Failed to parse json at offset " + std::to_string(m_offset) + ": " + message);
+    }
+
+    std::streambuf& m_buf;
+    size_t          m_offset = 0;
+    int             m_last   = 0;
+};
+
 }
 
 void MapConverterFile::readBinaryBufferData()
@@ -56,14 +532,33 @@ void MapConverterFile::writeBinaryBufferDataAsUncompressed()
 
 void MapConverterFile::readJsonToProperty()
 {
-    std::string buffer = Mernel::readFileIntoBuffer(m_filename);
-    m_json             = Mernel::readJsonFromBuffer(buffer);
+    std::vector<char> buffer(g_jsonStreamBufferSize);
+    std::ifstream     stream;
+    stream.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    stream.open(m_filename, std::ios_base::in | std::ios_base::binary);
+    if (!stream)
+        throw std::runtime_error("Failed to open file for reading: " + Mernel::path2string(m_filename));
+
+    JsonStreamReader reader(stream);
+    m_json = {};
+    reader.read(m_json);
+    reader.finish();
 }
 
 void MapConverterFile::writeJsonFromProperty()
 {
-    std::string buffer = Mernel::writeJsonToBuffer(m_json);
-    Mernel::writeFileFromBuffer(m_filename, buffer);
+    std::vector<char> buffer(g_jsonStreamBufferSize);
+    std::ofstream     stream;
+    stream.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    stream.open(m_filename, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    if (!stream)
+        throw std::runtime_error("Failed to open file for writing: " + Mernel::path2string(m_filename));
+
+    JsonStreamWriter writer(stream);
+    writer.write(m_json);
+    stream.close();
+    if (!stream)
+        throw std::runtime_error("Failed to write file: " + Mernel::path2string(m_filename));
 }
 
 void MapConverterFile::binaryBufferToString()
@@ -107,6 +602,56 @@ void MapConverterFile::writeCsvToBuffer()
     binaryBufferFromString();
 }
 
+void MapConverterFile::readBinaryToPropertyFromBuffer()
+{
+    if (m_rawState != RawState::Uncompressed)
+        throw std::runtime_error("Buffer needs to be in Uncompressed state.");
+
+    Mernel::ByteOrderBuffer           bobuffer(m_binaryBuffer);
+    Mernel::ByteOrderDataStreamReader reader(bobuffer, Mernel::ByteOrderDataStream::s_littleEndian);
+
+    std::array<uint8_t, 4> signature;
+    uint32_t               version;
+    reader >> signature >> version;
+    if (signature != g_binaryPropertySignature)
+        throw std::runtime_error("Binary property signature is not found");
+    if (version != g_binaryPropertyVersion)
+        throw std::runtime_error("Unsupported binary property version: " + std::to_string(version));
+
+    BinaryPropertyReader propertyReader;
+    uint32_t             stringCount;
+    reader >> stringCount;
+    BinaryPropertyReader::checkRemaining(reader, stringCount, sizeof(uint32_t)); // length of each string
+    propertyReader.m_strings.resize(stringCount);
+    for (auto& str : propertyReader.m_strings)
+        reader >> str;
+
+    m_json = {};
+    propertyReader.read(m_json, reader);
+}
+
+void MapConverterFile::writeBinaryFromPropertyToBuffer()
+{
+    // strings are collected while nodes are written, so table is prepended afterwards.
+    Mernel::ByteArrayHolder           nodesBuffer;
+    Mernel::ByteOrderBuffer           nodesBobuffer(nodesBuffer);
+    Mernel::ByteOrderDataStreamWriter nodesWriter(nodesBobuffer, Mernel::ByteOrderDataStream::s_littleEndian);
+    BinaryPropertyWriter              propertyWriter;
+    propertyWriter.write(m_json, nodesWriter);
+
+    m_binaryBuffer = {};
+    Mernel::ByteOrderBuffer           bobuffer(m_binaryBuffer);
+    Mernel::ByteOrderDataStreamWriter writer(bobuffer, Mernel::ByteOrderDataStream::s_littleEndian);
+
+    writer << g_binaryPropertySignature << g_binaryPropertyVersion;
+    writer << static_cast<uint32_t>(propertyWriter.m_strings.size());
+    for (const auto& str : propertyWriter.m_strings)
+        writer << str;
+    writer.writeBlock(nodesBuffer.data(), nodesBuffer.size());
+
+    m_rawState = RawState::Uncompressed;
+}
+
 void MapConverterFile::detectCompression()
 {
     m_compressionOffsets.clear();
@@ -118,9 +663,8 @@ void MapConverterFile::detectCompression()
         m_compressionMethod = CompressionMethod::NoCompression;
         return;
     }
-    std::string buffer;
-    buffer.resize(m_binaryBuffer.size());
-    memcpy(buffer.data(), m_binaryBuffer.data(), m_binaryBuffer.size());
+    // gzip members are searched right in the file buffer, without copying it.
+    const std::string_view buffer(reinterpret_cast<const char*>(m_binaryBuffer.data()), m_binaryBuffer.size());
 
     /// @todo: other comressions?
     const std::string_view gzipDeflate("\x1f\x8b\x08", 3);
@@ -128,7 +672,7 @@ void MapConverterFile::detectCompression()
         m_compressionMethod = CompressionMethod::Gzip;
         m_compressionOffsets.push_back(0);
         size_t nextPos = 1;
-        while ((nextPos = buffer.find(gzipDeflate, nextPos)) != std::string::npos) {
+        while ((nextPos = buffer.find(gzipDeflate, nextPos)) != std::string_view::npos) {
             m_compressionOffsets.push_back(nextPos);
             nextPos += 1;
         }
@@ -197,6 +741,8 @@ void MapConverterFile::splitCompressedDataByOffsets()
         memcpy(part.data(), m_binaryBuffer.data() + start, size);
         m_binaryParts.push_back(std::move(part));
     }
+    // all data now lives in parts; keeping the whole file too only raises peak memory.
+    m_binaryBuffer = {};
 }
 
 void MapConverterFile::uncompressRawParts()
@@ -12,9 +12,11 @@
 #include "MernelPlatform/FsUtils.hpp"
 #include "MernelPlatform/Profiler.hpp"
 
+#include "MapUtilExport.hpp"
+
 namespace FreeHeroes {
 
-struct MapConverterFile {
+struct MAPUTIL_EXPORT MapConverterFile {
     enum class RawState
     {
         Undefined,
@@ -57,6 +59,10 @@ struct MapConverterFile {
     void readCsvFromBuffer();
     void writeCsvToBuffer();
 
+    // compact binary form of m_json: tagged nodes, all keys and strings interned into a table.
+    void readBinaryToPropertyFromBuffer();
+    void writeBinaryFromPropertyToBuffer();
+
     // Compression tasks
     void detectCompression();
     void uncompressRaw();
@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2023 Smirnov Vladimir / mapron1@gmail.com
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file for details.
+ */
+#include "MapIndex.hpp"
+
+#include "H3MMap.hpp"
+#include "H3MMapReflection.hpp"
+#include "MapConverterFile.hpp"
+#include "ParallelChunks.hpp"
+
+#include "MernelPlatform/ByteOrderStream.hpp"
+#include "MernelPlatform/FileFormatJson.hpp"
+#include "MernelPlatform/FileIOUtils.hpp"
+
+#include <algorithm>
+#include <map>
+
+namespace FreeHeroes {
+using namespace Mernel;
+
+namespace {
+
+template<class Enum>
+std::string enumToStr(Enum value)
+{
+    auto str = Reflection::EnumTraits::enumToString(value);
+    return std::string(str.begin(), str.end());
+}
+
+void fillFromH3M(MapIndexEntry& entry, const std_path& path)
+{
+    MapConverterFile file;
+    file.m_filename = path;
+    file.readBinaryBufferData();
+    file.detectCompression();
+    file.uncompressRaw();
+
+    ByteOrderBuffer           bobuffer(file.m_binaryBuffer);
+    ByteOrderDataStreamReader reader(bobuffer, ByteOrderDataStream::s_littleEndian);
+
+    H3Map map;
+    map.readBinary(reader, H3Map::ReadScope::Tiles);
+
+    entry.m_format = enumToStr(map.m_format);
+    entry.m_name   = map.m_mapName;
+    entry.m_width  = map.m_tiles.m_size;
+    entry.m_height = map.m_tiles.m_size;
+    entry.m_depth  = 1 + map.m_tiles.m_hasUnderground;
+    for (const auto& player : map.m_players) {
+        entry.m_players += player.m_canHumanPlay || player.m_canComputerPlay;
+        entry.m_humanPlayers += player.m_canHumanPlay;
+    }
+    entry.m_victoryCondition = enumToStr(map.m_victoryCondition.m_type);
+    entry.m_lossCondition    = enumToStr(map.m_lossCondition.m_type);
+
+    if (!map.m_tiles.m_size)
+        return;
+    // nearest tile to the center of each thumbnail cell.
+    const int size  = map.m_tiles.m_size;
+    const int cells = MapIndex::s_thumbnailSize;
+    entry.m_thumbnail.resize(cells * cells);
+    for (int ty = 0; ty < cells; ++ty) {
+        for (int tx = 0; tx < cells; ++tx) {
+            const uint8_t terrain = map.m_tiles.get((2 * tx + 1) * size / (2 * cells), (2 * ty + 1) * size / (2 * cells), 0).m_terType;
+
+            entry.m_thumbnail[ty * cells + tx] = terrain < 16 ? "0123456789abcdef"[terrain] : '.';
+        }
+    }
+}
+
+void fillFromFH(MapIndexEntry& entry, const std_path& path)
+{
+    MapConverterFile file;
+    file.m_filename = path;
+    if (pathToLower(path.extension()) == ".fhmapb") {
+        file.readBinaryBufferData();
+        file.detectCompression();
+        file.uncompressRaw();
+        file.readBinaryToPropertyFromBuffer();
+    } else {
+        file.readJsonToProperty();
+    }
+    // terrain ids of packed tile map can not be resolved without game database, so no thumbnail here.
+    const PropertyTree& json = file.m_json;
+    if (!json.isMap() || !json.contains("format") || !json.contains("tileMap"))
+        throw std::runtime_error("Not a FH map");
+
+    entry.m_format = json["format"].getScalar().toString();
+    if (json.contains("name"))
+        entry.m_name = json["name"].getScalar().toString();
+    const PropertyTree& tileMap = json["tileMap"];
+    entry.m_width               = tileMap.contains("width") ? static_cast<int>(tileMap["width"].getScalar().toInt()) : 0;
+    entry.m_height              = tileMap.contains("height") ? static_cast<int>(tileMap["height"].getScalar().toInt()) : 0;
+    entry.m_depth               = tileMap.contains("depth") ? static_cast<int>(tileMap["depth"].getScalar().toInt()) : 0;
+    if (json.contains("players") && json["players"].isMap())
+        entry.m_players = static_cast<int>(json["players"].getMap().size());
+}
+
+}
+
+void MapIndexEntry::toJson(Mernel::PropertyTree& data) const
+{
+    data.convertToMap();
+    data["path"]     = PropertyTreeScalar(m_path);
+    data["mtime"]    = PropertyTreeScalar(m_mtime);
+    data["fileSize"] = PropertyTreeScalar(m_fileSize);
+    if (!m_error.empty()) {
+        data["error"] = PropertyTreeScalar(m_error);
+        return;
+    }
+    data["format"]           = PropertyTreeScalar(m_format);
+    data["name"]             = PropertyTreeScalar(m_name);
+    data["width"]            = PropertyTreeScalar(m_width);
+    data["height"]           = PropertyTreeScalar(m_height);
+    data["depth"]            = PropertyTreeScalar(m_depth);
+    data["players"]          = PropertyTreeScalar(m_players);
+    data["humanPlayers"]     = PropertyTreeScalar(m_humanPlayers);
+    data["victoryCondition"] = PropertyTreeScalar(m_victoryCondition);
+    data["lossCondition"]    = PropertyTreeScalar(m_lossCondition);
+    data["thumbnail"]        = PropertyTreeScalar(m_thumbnail);
+}
+
+void MapIndexEntry::fromJson(const Mernel::PropertyTree& data)
+{
+    *this        = {};
+    auto readStr = [&data](const char* key) { return data.contains(key) ? data[key].getScalar().toString() : std::string(); };
+    auto readInt = [&data](const char* key) { return data.contains(key) ? data[key].getScalar().toInt() : int64_t(0); };
+
+    m_path             = readStr("path");
+    m_mtime            = readInt("mtime");
+    m_fileSize         = readInt("fileSize");
+    m_error            = readStr("error");
+    m_format           = readStr("format");
+    m_name             = readStr("name");
+    m_width            = static_cast<int>(readInt("width"));
+    m_height           = static_cast<int>(readInt("height"));
+    m_depth            = static_cast<int>(readInt("depth"));
+    m_players          = static_cast<int>(readInt("players"));
+    m_humanPlayers     = static_cast<int>(readInt("humanPlayers"));
+    m_victoryCondition = readStr("victoryCondition");
+    m_lossCondition    = readStr("lossCondition");
+    m_thumbnail        = readStr("thumbnail");
+}
+
+void MapIndex::load(const Mernel::std_path& indexFile)
+{
+    m_entries.clear();
+    m_failed.clear();
+    if (!std_fs::exists(indexFile))
+        return;
+
+    const PropertyTree json = readJsonFromBuffer(readFileIntoBuffer(indexFile));
+    for (auto [key, list] : { std::pair{ "maps", &m_entries }, std::pair{ "failed", &m_failed } }) {
+        if (!json.contains(key))
+            continue;
+        for (const auto& item : json[key].getList())
+            list->emplace_back().fromJson(item);
+    }
+}
+
+void MapIndex::save(const Mernel::std_path& indexFile) const
+{
+    PropertyTree json;
+    for (auto [key, list] : { std::pair{ "maps", &m_entries }, std::pair{ "failed", &m_failed } }) {
+        PropertyTree& items = json[key];
+        items.convertToList();
+        for (const auto& entry : *list) {
+            PropertyTree item;
+            entry.toJson(item);
+            items.append(std::move(item));
+        }
+    }
+    writeFileFromBuffer(indexFile, writeJsonToBuffer(json));
+}
+
+size_t MapIndex::update(const Mernel::std_path& root, size_t jobs)
+{
+    std::map<std::string, MapIndexEntry> previous;
+    for (auto* list : { &m_entries, &m_failed }) {
+        for (auto& entry : *list)
+            previous[entry.m_path] = std::move(entry);
+        list->clear();
+    }
+
+    // entries of deleted files are not carried over.
+    std::vector<std_path> changedPaths;
+    std::vector<size_t>   changedIndexes;
+    for (const auto& it : std_fs::recursive_directory_iterator(root)) {
+        if (!it.is_regular_file())
+            continue;
+        const auto path = it.path();
+        if (!isMapFile(path))
+            continue;
+
+        const std::string relPath  = path2string(std_fs::relative(path, root));
+        const int64_t     mtime    = it.last_write_time().time_since_epoch().count();
+        const int64_t     fileSize = static_cast<int64_t>(it.file_size());
+
+        auto prevIt = previous.find(relPath);
+        if (prevIt != previous.end() && prevIt->second.m_mtime == mtime && prevIt->second.m_fileSize == fileSize) {
+            m_entries.push_back(std::move(prevIt->second));
+            continue;
+        }
+        changedIndexes.push_back(m_entries.size());
+        changedPaths.push_back(path);
+        m_entries.push_back({ .m_path = relPath, .m_mtime = mtime, .m_fileSize = fileSize });
+    }
+
+    // one chunk per file; entries are preallocated so no locking needed.
+    forEachChunkParallel(changedPaths.size(), changedPaths.size(), std::max<size_t>(jobs, 1), [this, &changedPaths, &changedIndexes](size_t i, size_t, size_t) {
+        MapIndexEntry& entry  = m_entries[changedIndexes[i]];
+        MapIndexEntry  parsed = makeEntry(changedPaths[i]);
+        parsed.m_path         = std::move(entry.m_path);
+        parsed.m_mtime        = entry.m_mtime;
+        parsed.m_fileSize     = entry.m_fileSize;
+        entry                 = std::move(parsed);
+    });
+
+    auto failedIt = std::stable_partition(m_entries.begin(), m_entries.end(), [](const MapIndexEntry& entry) { return entry.m_error.empty(); });
+    m_failed.assign(std::make_move_iterator(failedIt), std::make_move_iterator(m_entries.end()));
+    m_entries.erase(failedIt, m_entries.end());
+
+    auto byPath = [](const MapIndexEntry& l, const MapIndexEntry& r) { return l.m_path < r.m_path; };
+    std::sort(m_entries.begin(), m_entries.end(), byPath);
+    std::sort(m_failed.begin(), m_failed.end(), byPath);
+    return changedPaths.size();
+}
+
+bool MapIndex::isMapFile(const Mernel::std_path& path)
+{
+    // plain .json may be anything (templates, databases, this index), FH maps are saved as .fh.json.
+    const std::string filename = pathToLower(path.filename());
+    // legacy converter writes its archive index next to the maps with the same extension.
+    if (filename == "archive_index.fh.json")
+        return false;
+    return filename.ends_with(".h3m") || filename.ends_with(".fhmapb") || filename.ends_with(".fh.json");
+}
+
+MapIndexEntry MapIndex::makeEntry(const Mernel::std_path& path)
+{
+    MapIndexEntry entry;
+    try {
+        if (pathToLower(path.extension()) == ".h3m")
+            fillFromH3M(entry, path);
+        else
+            fillFromFH(entry, path);
+    }
+    catch (std::exception& ex) {
+        entry         = {};
+        entry.m_error = ex.what();
+    }
+    return entry;
+}
+
+}
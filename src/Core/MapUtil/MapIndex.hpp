@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2023 Smirnov Vladimir / mapron1@gmail.com
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file for details.
+ */
+#pragma once
+
+#include "MernelPlatform/FsUtils.hpp"
+#include "MernelPlatform/PropertyTree.hpp"
+
+#include "MapUtilExport.hpp"
+
+#include <string>
+#include <vector>
+
+namespace FreeHeroes {
+
+// Summary of one map file, enough for map lists without parsing the map again.
+struct MAPUTIL_EXPORT MapIndexEntry {
+    std::string m_path; // relative to index root
+    int64_t     m_mtime    = 0;
+    int64_t     m_fileSize = 0;
+
+    std::string m_format;
+    std::string m_name;
+    int         m_width        = 0;
+    int         m_height       = 0;
+    int         m_depth        = 0;
+    int         m_players      = 0;
+    int         m_humanPlayers = 0;
+    std::string m_victoryCondition;
+    std::string m_lossCondition;
+
+    // s_thumbnailSize^2 chars, surface terrain type per cell as hex digit, '.' if unknown. Empty for FH maps.
+    std::string m_thumbnail;
+
+    std::string m_error; // not empty if map failed to parse; such entries go to MapIndex::m_failed.
+
+    void toJson(Mernel::PropertyTree& data) const;
+    void fromJson(const Mernel::PropertyTree& data);
+};
+
+class MAPUTIL_EXPORT MapIndex {
+public:
+    static constexpr int s_thumbnailSize = 32;
+
+    std::vector<MapIndexEntry> m_entries; // sorted by path, only successfully parsed maps
+    std::vector<MapIndexEntry> m_failed;  // sorted by path, files that are not maps; retried only when file changes
+
+    // missing file means empty index.
+    void load(const Mernel::std_path& indexFile);
+    void save(const Mernel::std_path& indexFile) const;
+
+    // rescans .h3m, .fh.json and .fhmapb files under root; only new or changed files are parsed.
+    // returns number of parsed files.
+    size_t update(const Mernel::std_path& root, size_t jobs);
+
+    static bool          isMapFile(const Mernel::std_path& path);
+    static MapIndexEntry makeEntry(const Mernel::std_path& path);
+};
+
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2024 Smirnov Vladimir / mapron1@gmail.com
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file for details.
+ */
+#include "ParallelChunks.hpp"
+
+#include "MernelExecution/ParallelExecutor.hpp"
+#include "MernelExecution/TaskQueue.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace FreeHeroes {
+
+size_t getParallelThreads(size_t threads)
+{
+    return threads ? threads : std::max(1U, std::thread::hardware_concurrency());
+}
+
+size_t getParallelChunks(size_t count, size_t minPerChunk, size_t threads)
+{
+    return std::clamp<size_t>(count / std::max<size_t>(minPerChunk, 1), 1, getParallelThreads(threads));
+}
+
+void forEachChunkParallel(size_t count, size_t chunks, size_t threads, const std::function<void(size_t, size_t, size_t)>& f)
+{
+    chunks = std::min(chunks, count);
+    if (!chunks)
+        return;
+    if (chunks == 1) {
+        f(0, 0, count);
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(chunks);
+    Mernel::TaskQueue               taskQueue;
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        taskQueue.addTask([&f, &errors, count, chunks, chunk] {
+            try {
+                f(chunk, count * chunk / chunks, count * (chunk + 1) / chunks);
+            }
+            catch (...) {
+                errors[chunk] = std::current_exception();
+            }
+        });
+    }
+    {
+        Mernel::ParallelExecutor executor(std::min(chunks, getParallelThreads(threads)));
+        executor.execQueue(taskQueue);
+    }
+    for (const auto& error : errors) {
+        if (error)
+            std::rethrow_exception(error);
+    }
+}
+
+}
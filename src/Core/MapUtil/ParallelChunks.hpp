@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2024 Smirnov Vladimir / mapron1@gmail.com
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file for details.
+ */
+#pragma once
+
+#include "MapUtilExport.hpp"
+
+#include <functional>
+
+namespace FreeHeroes {
+
+// threads == 0 means hardware concurrency.
+MAPUTIL_EXPORT size_t getParallelThreads(size_t threads);
+
+// count of chunks, so each one has at least minPerChunk items and there is no more chunks than threads.
+MAPUTIL_EXPORT size_t getParallelChunks(size_t count, size_t minPerChunk, size_t threads);
+
+// Splits [0, count) into 'chunks' contiguous ranges and calls f(chunk, begin, end) for each, using up to 'threads' threads.
+// Single chunk runs on the calling thread. Exception of the first failed chunk is rethrown after all chunks are done.
+MAPUTIL_EXPORT void forEachChunkParallel(size_t count, size_t chunks, size_t threads, const std::function<void(size_t, size_t, size_t)>& f);
+
+}
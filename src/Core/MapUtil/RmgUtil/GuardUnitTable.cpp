@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2023 Smirnov Vladimir / mapron1@gmail.com
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file for details.
+ */
+#include "GuardUnitTable.hpp"
+
+#include "LibraryUnit.hpp"
+
+#include <algorithm>
+#include <map>
+
+namespace FreeHeroes {
+
+void GuardUnitTable::init(const std::vector<Core::LibraryUnitConstPtr>& units)
+{
+    m_entries.clear();
+    m_entries.reserve(units.size());
+    for (Core::LibraryUnitConstPtr unit : units) {
+        m_entries.push_back(Entry{
+            .m_value        = unit->value,
+            .m_guardMult1   = unit->guardMult1,
+            .m_guardMult100 = unit->guardMult100,
+            .m_level        = unit->level,
+            .m_order        = m_entries.size(),
+            .m_unit         = unit,
+        });
+    }
+    std::stable_sort(m_entries.begin(), m_entries.end(), [](const Entry& l, const Entry& r) { return l.m_value < r.m_value; });
+}
+
+int GuardUnitTable::getPossibleCount(Core::LibraryUnitConstPtr unit, int64_t value)
+{
+    return getPossibleCount(unit->value, unit->guardMult1, unit->guardMult100, value);
+}
+
+int GuardUnitTable::getPossibleCount(int64_t unitValue, int64_t guardMult1, int64_t guardMult100, int64_t value)
+{
+    auto possibleCount = value / unitValue;
+    if (possibleCount <= 1)
+        return possibleCount;
+    int64_t coef1   = 100;
+    int64_t coef100 = 0;
+    if (possibleCount >= 100) {
+        coef1   = 0;
+        coef100 = 100;
+    } else {
+        coef1   = 100 - possibleCount + 1;
+        coef100 = possibleCount - 1;
+    }
+
+    unitValue = (coef1 * guardMult1 + coef100 * guardMult100) * unitValue / 10000;
+
+    possibleCount = value / unitValue;
+    return possibleCount;
+}
+
+std::vector<Core::LibraryUnitConstPtr> GuardUnitTable::makeCandidates(int64_t value) const
+{
+    struct Fit {
+        size_t m_order = 0;
+        int    m_count = 0;
+        int    m_level = 0;
+
+        Core::LibraryUnitConstPtr m_unit = nullptr;
+    };
+
+    // with less than 2 units per value, stack size is 'value / unit value' and can't reach 5.
+    const auto end = std::upper_bound(m_entries.cbegin(), m_entries.cend(), value / 2, [](int64_t v, const Entry& entry) { return v < entry.m_value; });
+
+    std::vector<Fit> fits;
+    for (auto it = m_entries.cbegin(); it != end; ++it) {
+        const int possibleCount = getPossibleCount(it->m_value, it->m_guardMult1, it->m_guardMult100, value);
+        if (possibleCount < 5)
+            continue;
+        if (possibleCount < 10 && it->m_level < 50)
+            continue;
+        fits.push_back(Fit{ .m_order = it->m_order, .m_count = possibleCount, .m_level = it->m_level, .m_unit = it->m_unit });
+    }
+    if (fits.empty())
+        return {};
+    std::sort(fits.begin(), fits.end(), [](const Fit& l, const Fit& r) { return l.m_order < r.m_order; });
+
+    std::map<int, int> unitLevelScore;
+    for (const Fit& fit : fits) {
+        int score = 0;
+        if (fit.m_count < 10)
+            score = 1;
+        else if (fit.m_count < 25)
+            score = 2;
+        else if (fit.m_count < 35)
+            score = 5;
+        else if (fit.m_count < 50)
+            score = 3;
+        else if (fit.m_count < 100)
+            score = 2;
+        else
+            score = 1;
+        unitLevelScore[fit.m_level / 10] += score;
+    }
+    auto      it                = std::max_element(unitLevelScore.begin(), unitLevelScore.end(), [](auto l, auto r) { return l.second < r.second; });
+    const int optimalGuardLevel = it->first;
+
+    std::vector<Core::LibraryUnitConstPtr> result;
+    for (const Fit& fit : fits) {
+        const int levelDiff = (fit.m_level / 10) - optimalGuardLevel;
+        if (levelDiff < -1 || levelDiff > 2)
+            continue;
+
+        if (fit.m_level < 80 && fit.m_count >= 100)
+            continue;
+        result.push_back(fit.m_unit);
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2023 Smirnov Vladimir / mapron1@gmail.com
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file for details.
+ */
+#pragma once
+
+#include "LibraryFwd.hpp"
+
+#include "MapUtilExport.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace FreeHeroes {
+
+// Units that can guard objects, with their value data copied out and sorted by unit value,
+// so stack size estimation for a guard value needs neither unit lookups nor full scans.
+class MAPUTIL_EXPORT GuardUnitTable {
+public:
+    void init(const std::vector<Core::LibraryUnitConstPtr>& units);
+
+    // stack size of 'unit' that makes up guard 'value'.
+    static int getPossibleCount(Core::LibraryUnitConstPtr unit, int64_t value);
+
+    // units fitting to guard 'value', in order they were passed to init().
+    std::vector<Core::LibraryUnitConstPtr> makeCandidates(int64_t value) const;
+
+    size_t size() const noexcept { return m_entries.size(); }
+
+private:
+    struct Entry {
+        int64_t                   m_value        = 0;
+        int64_t                   m_guardMult1   = 100;
+        int64_t                   m_guardMult100 = 100;
+        int                       m_level        = 0;
+        size_t                    m_order        = 0;
+        Core::LibraryUnitConstPtr m_unit         = nullptr;
+    };
+
+    static int getPossibleCount(int64_t unitValue, int64_t guardMult1, int64_t guardMult100, int64_t value);
+
+    std::vector<Entry> m_entries; // sorted by m_value
+};
+
+}
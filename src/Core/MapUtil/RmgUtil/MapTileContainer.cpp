@@ -9,6 +9,59 @@
 
 namespace FreeHeroes {
 
+MapTileContainer::MapTileContainer(const MapTileContainer& other)
+{
+    *this = other;
+}
+
+MapTileContainer& MapTileContainer::operator=(const MapTileContainer& other)
+{
+    if (this == &other)
+        return *this;
+
+    m_width  = other.m_width;
+    m_height = other.m_height;
+    m_depth  = other.m_depth;
+    m_tiles  = other.m_tiles;
+
+    auto remap = [this, &other](MapTilePtr tile) -> MapTilePtr {
+        return tile ? &m_tiles[tile - other.m_tiles.data()] : nullptr;
+    };
+    // tiles keep same order, so sorted lists stay sorted.
+    auto remapList = [&remap](const auto& list) {
+        MapTilePtrSortedList result;
+        result.reserve(list.size());
+        for (MapTilePtr tile : list)
+            result.push_back(remap(tile));
+        return result;
+    };
+
+    m_tileIndex.clear();
+    m_tileIndex.reserve(m_tiles.size());
+    for (auto& tile : m_tiles) {
+        tile.m_container  = this;
+        tile.m_self       = remap(tile.m_self);
+        tile.m_neighborT  = remap(tile.m_neighborT);
+        tile.m_neighborL  = remap(tile.m_neighborL);
+        tile.m_neighborR  = remap(tile.m_neighborR);
+        tile.m_neighborB  = remap(tile.m_neighborB);
+        tile.m_neighborTL = remap(tile.m_neighborTL);
+        tile.m_neighborTR = remap(tile.m_neighborTR);
+        tile.m_neighborBL = remap(tile.m_neighborBL);
+        tile.m_neighborBR = remap(tile.m_neighborBR);
+
+        tile.m_orthogonalNeighbours  = remapList(tile.m_orthogonalNeighbours);
+        tile.m_diagNeighbours        = remapList(tile.m_diagNeighbours);
+        tile.m_allNeighboursWithDiag = remapList(tile.m_allNeighboursWithDiag);
+
+        m_tileIndex[tile.m_pos] = &tile;
+    }
+    m_all        = MapTileRegion(remapList(other.m_all));
+    m_innerEdge  = MapTileRegion(remapList(other.m_innerEdge));
+    m_centerTile = remap(other.m_centerTile);
+    return *this;
+}
+
 void MapTileContainer::init(int width, int height, int depth)
 {
     m_width  = width;
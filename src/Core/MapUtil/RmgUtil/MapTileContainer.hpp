@@ -27,6 +27,11 @@ public:
     std::unordered_map<FHPos, MapTilePtr> m_tileIndex;
     MapTilePtr                            m_centerTile = nullptr;
 
+    MapTileContainer() = default;
+    // copy has its own tiles, all tile pointers are remapped to them; zone and segment pointers are copied as is.
+    MapTileContainer(const MapTileContainer& other);
+    MapTileContainer& operator=(const MapTileContainer& other);
+
     void init(int width, int height, int depth);
 
     MapTilePtr find(FHPos pos) const noexcept
@@ -7,10 +7,75 @@
 #include "MapTileContainer.hpp"
 #include "MapTileRegionSegmentation.hpp"
 
+#include <cassert>
 #include <iostream>
 
 namespace FreeHeroes {
 
+namespace {
+
+// Membership bitmap over region bounding box (with margin of 1 tile for neighbours).
+class RegionBitmap {
+public:
+    explicit RegionBitmap(const MapTileRegion& region)
+    {
+        FHPos minPos = region[0]->m_pos;
+        FHPos maxPos = region[0]->m_pos;
+        for (MapTilePtr cell : region) {
+            minPos = FHPos{ std::min(minPos.m_x, cell->m_pos.m_x), std::min(minPos.m_y, cell->m_pos.m_y), std::min(minPos.m_z, cell->m_pos.m_z) };
+            maxPos = FHPos{ std::max(maxPos.m_x, cell->m_pos.m_x), std::max(maxPos.m_y, cell->m_pos.m_y), std::max(maxPos.m_z, cell->m_pos.m_z) };
+        }
+        m_origin = FHPos{ minPos.m_x - 1, minPos.m_y - 1, minPos.m_z };
+        m_width  = maxPos.m_x - minPos.m_x + 3;
+        m_height = maxPos.m_y - minPos.m_y + 3;
+        m_depth  = maxPos.m_z - minPos.m_z + 1;
+        m_bits.resize((static_cast<size_t>(m_width) * m_height * m_depth + 63) / 64);
+        for (MapTilePtr cell : region)
+            insert(cell);
+    }
+
+    bool contains(MapTileConstPtr cell) const noexcept
+    {
+        const size_t index = indexOf(cell);
+        return index != s_outside && (m_bits[index / 64] & (uint64_t(1) << (index % 64)));
+    }
+    // return true if cell was not set before.
+    bool insert(MapTileConstPtr cell) noexcept
+    {
+        const size_t index = indexOf(cell);
+        assert(index != s_outside);
+        uint64_t&      word = m_bits[index / 64];
+        const uint64_t bit  = uint64_t(1) << (index % 64);
+        if (word & bit)
+            return false;
+        word |= bit;
+        return true;
+    }
+
+private:
+    static constexpr size_t s_outside = size_t(-1);
+
+    size_t indexOf(MapTileConstPtr cell) const noexcept
+    {
+        if (!cell)
+            return s_outside;
+        const int x = cell->m_pos.m_x - m_origin.m_x;
+        const int y = cell->m_pos.m_y - m_origin.m_y;
+        const int z = cell->m_pos.m_z - m_origin.m_z;
+        if (x < 0 || y < 0 || z < 0 || x >= m_width || y >= m_height || z >= m_depth)
+            return s_outside;
+        return (static_cast<size_t>(z) * m_height + y) * m_width + x;
+    }
+
+    FHPos                 m_origin;
+    int                   m_width  = 0;
+    int                   m_height = 0;
+    int                   m_depth  = 0;
+    std::vector<uint64_t> m_bits;
+};
+
+}
+
 MapTileRegionList MapTileRegion::splitByFloodFill(bool useDiag, MapTilePtr hint) const
 {
     return MapTileRegionSegmentation::splitByFloodFill(*this, useDiag, hint);
@@ -112,50 +177,57 @@ MapTileRegion MapTileRegion::makeOuterEdge(bool useDiag) const
 EdgeSegmentationResults MapTileRegion::makeInnerAndOuterEdge(EdgeSegmentationParams params) const
 {
     //Mernel::ProfilerScope scope("makeInnerAndOuterEdge");
-    const int64_t           diameter       = intSqrt(static_cast<int64_t>(size()));
-    const size_t            perimeterInner = diameter * 4;
-    const size_t            perimeterOuter = (diameter + 2) * 4;
     EdgeSegmentationResults result;
+    if (empty())
+        return result;
+
+    const int64_t diameter       = intSqrt(static_cast<int64_t>(size()));
+    const size_t  perimeterInner = diameter * 4;
+    const size_t  perimeterOuter = (diameter + 2) * 4;
+
+    const RegionBitmap   regionBits(*this);
+    RegionBitmap         outerBits(regionBits);
+    MapTilePtrSortedList inner;
+    MapTilePtrSortedList outer;
+    MapTilePtrSortedList center;
     if (params.m_makeInner)
-        result.m_inner.reserve(perimeterInner);
+        inner.reserve(perimeterInner);
     if (params.m_makeOuter)
-        result.m_outer.reserve(perimeterOuter);
+        outer.reserve(perimeterOuter);
     if (params.m_makeCenter)
-        result.m_center.reserve(size());
+        center.reserve(size());
+
+    // cells are visited in sorted order, so inner and center lists are sorted already.
     for (MapTilePtr cell : *this) {
-        if (params.m_useDiag) {
-            if (contains(cell->m_neighborB)
-                && contains(cell->m_neighborT)
-                && contains(cell->m_neighborR)
-                && contains(cell->m_neighborL)
-                && contains(cell->m_neighborTL)
-                && contains(cell->m_neighborTR)
-                && contains(cell->m_neighborBL)
-                && contains(cell->m_neighborBR)) {
-                if (params.m_makeCenter)
-                    result.m_center.insert(cell);
-                continue;
-            }
-        } else {
-            if (contains(cell->m_neighborB)
-                && contains(cell->m_neighborT)
-                && contains(cell->m_neighborR)
-                && contains(cell->m_neighborL)) {
-                if (params.m_makeCenter)
-                    result.m_center.insert(cell);
-                continue;
-            }
+        bool isCenter = regionBits.contains(cell->m_neighborB)
+                        && regionBits.contains(cell->m_neighborT)
+                        && regionBits.contains(cell->m_neighborR)
+                        && regionBits.contains(cell->m_neighborL);
+        if (isCenter && params.m_useDiag) {
+            isCenter = regionBits.contains(cell->m_neighborTL)
+                       && regionBits.contains(cell->m_neighborTR)
+                       && regionBits.contains(cell->m_neighborBL)
+                       && regionBits.contains(cell->m_neighborBR);
+        }
+        if (isCenter) {
+            if (params.m_makeCenter)
+                center.push_back(cell);
+            continue;
         }
         if (params.m_makeInner)
-            result.m_inner.insert(cell);
+            inner.push_back(cell);
         if (params.m_makeOuter) {
             for (auto* ncell : cell->neighboursList(params.m_useDiag)) {
-                if (!contains(ncell))
-                    result.m_outer.insert(ncell);
+                if (outerBits.insert(ncell))
+                    outer.push_back(ncell);
             }
         }
     }
+    std::sort(outer.begin(), outer.end());
 
+    result.m_inner  = MapTileRegion(std::move(inner));
+    result.m_outer  = MapTileRegion(std::move(outer));
+    result.m_center = MapTileRegion(std::move(center));
     return result;
 }
 
@@ -163,12 +235,10 @@ void MapTileRegion::eraseExclaves(bool useDiag)
 {
     if (empty())
         return;
-    auto           parts   = splitByFloodFill(useDiag);
-    auto           it      = std::max_element(parts.begin(), parts.end(), [](const MapTileRegion& l, const MapTileRegion& r) {
-        return std::tuple{ l.size(), &l } < std::tuple{ r.size(), &r };
-    });
-    MapTileRegion& largest = *it;
-    *this                  = std::move(largest);
+    const ComponentLabels labels = MapTileRegionSegmentation::labelComponents(*this, useDiag);
+    if (labels.count() == 1)
+        return;
+    *this = labels.makeComponent(*this, labels.largest());
 }
 
 }
@@ -6,6 +6,7 @@
 
 #include <cassert>
 #include <iostream>
+#include <limits>
 
 namespace FreeHeroes {
 
@@ -21,6 +22,17 @@ struct KMeansData {
         size_t               m_pointsCount    = 0;
         int64_t              m_radiusPromille = 0;
 
+        // accelerated mode: running mass sums, updated only for the points that changed cluster.
+        int64_t m_sumX  = 0;
+        int64_t m_sumY  = 0;
+        size_t  m_count = 0;
+
+        // centroid position which point bounds are currently relative to.
+        FHPos   m_boundCentroid;
+        int64_t m_boundShift = 0;
+        // max change of distanceTo() result per promille of centroid shift.
+        int64_t m_lipschitz = 1;
+
         std::string toPrintableStringPoints() const
         {
             if (m_points.size() > 5)
@@ -40,8 +52,13 @@ struct KMeansData {
 
         int64_t distanceTo(MapTilePtr point) const
         {
-            const auto dx = int64_t(m_centroid.m_x - point->m_pos.m_x) * 1000; // max 20bit
-            const auto dy = int64_t(m_centroid.m_y - point->m_pos.m_y) * 1000;
+            return distanceTo(point->m_pos.m_x, point->m_pos.m_y);
+        }
+
+        int64_t distanceTo(int x, int y) const
+        {
+            const auto dx = int64_t(m_centroid.m_x - x) * 1000; // max 20bit
+            const auto dy = int64_t(m_centroid.m_y - y) * 1000;
 
             // prevent branching as much as possible
             const auto arg = dx * dx + dy * dy; // max 40bit
@@ -87,6 +104,28 @@ struct KMeansData {
                 throw std::runtime_error("no points");
             }
         }
+
+        // same result as clearMass() + addToMass() for every point + finalizeMass(), but from running sums.
+        void finalizeMassIncremental()
+        {
+            const int64_t extraWeight = m_settings.m_extraMassWeight;
+            m_pointsCount             = extraWeight + m_count;
+            if (!m_pointsCount)
+                throw std::runtime_error("no points");
+
+            m_centerMass.m_x = static_cast<int>((extraWeight * m_extraMassPoint.m_x + m_sumX) / int64_t(m_pointsCount));
+            m_centerMass.m_y = static_cast<int>((extraWeight * m_extraMassPoint.m_y + m_sumY) / int64_t(m_pointsCount));
+            m_centerMass.m_z = 0;
+        }
+
+        void updateBoundShift()
+        {
+            const auto dx = int64_t(m_centroid.m_x - m_boundCentroid.m_x) * 1000;
+            const auto dy = int64_t(m_centroid.m_y - m_boundCentroid.m_y) * 1000;
+            // +1 covers intSqrt() rounding on both ends of triangle inequality.
+            m_boundShift    = (dx || dy) ? (intSqrt(dx * dx + dy * dy) + 1) * m_lipschitz : 0;
+            m_boundCentroid = m_centroid;
+        }
     };
 
     void clearMass()
@@ -105,6 +144,15 @@ struct KMeansData {
             i++;
         }
     }
+    void collectPoints()
+    {
+        for (auto& cluster : m_clusters)
+            cluster.m_points.clear();
+        for (size_t i = 0; MapTilePtr tile : *m_region) {
+            m_clusters[m_nearestIndex[i]].m_points.push_back(tile);
+            i++;
+        }
+    }
     void finalizeMass()
     {
         for (auto& cluster : m_clusters)
@@ -160,8 +208,32 @@ struct KMeansData {
         return nearestClusterId;
     }
 
+    // same tie-breaking as getNearestClusterId(), also reports distance to the second nearest cluster.
+    size_t getNearestClusterId(int x, int y, int64_t& minDist, int64_t& secondDist) const
+    {
+        minDist                 = m_clusters[0].distanceTo(x, y);
+        secondDist              = std::numeric_limits<int64_t>::max();
+        size_t nearestClusterId = 0;
+
+        for (size_t i = 1; i < m_clusters.size(); i++) {
+            const auto dist = m_clusters[i].distanceTo(x, y);
+            if (dist < minDist) {
+                secondDist       = minDist;
+                minDist          = dist;
+                nearestClusterId = i;
+            } else if (dist < secondDist) {
+                secondDist = dist;
+            }
+        }
+
+        return nearestClusterId;
+    }
+
     bool runIter(bool last)
     {
+        if (m_accelerated)
+            return runIterAccelerated();
+
         bool done = true;
 
         // fix repeated centroids
@@ -196,58 +268,264 @@ struct KMeansData {
         return done;
     }
 
+    // Hamerly-style k-means iteration: each point keeps an upper bound to its assigned cluster
+    // and a lower bound to any other cluster; bounds are loosened by centroid shifts, and
+    // full distance scan is done only when they overlap. Point is skipped only when its cluster
+    // is strictly the nearest, so assignment is always identical to the plain algorithm.
+    bool runIterAccelerated()
+    {
+        bool done = true;
+
+        // fix repeated centroids
+        checkCentroids();
+
+        int64_t maxShift = 0;
+        for (auto& cluster : m_clusters) {
+            cluster.updateBoundShift();
+            maxShift = std::max(maxShift, cluster.m_boundShift);
+        }
+
+        {
+            Mernel::ProfilerScope scope("getNearestClusterId");
+            const size_t          count = m_nearestIndex.size();
+            for (size_t i = 0; i < count; i++) {
+                size_t&   currentClusterId = m_nearestIndex[i];
+                const int x                = m_xs[i];
+                const int y                = m_ys[i];
+                if (currentClusterId != size_t(-1) && m_pruning) {
+                    auto& cluster = m_clusters[currentClusterId];
+                    m_upper[i] += cluster.m_boundShift;
+                    m_lower[i] -= maxShift;
+                    if (m_upper[i] < m_lower[i])
+                        continue;
+                    m_upper[i] = cluster.distanceTo(x, y);
+                    if (m_upper[i] < m_lower[i])
+                        continue;
+                }
+                const size_t nearestClusterId = getNearestClusterId(x, y, m_upper[i], m_lower[i]);
+                if (currentClusterId == nearestClusterId)
+                    continue;
+
+                if (currentClusterId != size_t(-1)) {
+                    auto& prev = m_clusters[currentClusterId];
+                    prev.m_sumX -= x;
+                    prev.m_sumY -= y;
+                    prev.m_count--;
+                }
+                auto& next = m_clusters[nearestClusterId];
+                next.m_sumX += x;
+                next.m_sumY += y;
+                next.m_count++;
+
+                currentClusterId = nearestClusterId;
+                done             = false;
+            }
+        }
+
+        // calculate new mass points and move centroids
+        bool moved = false;
+        for (auto& cluster : m_clusters) {
+            cluster.finalizeMassIncremental();
+            const FHPos prevCentroid = cluster.m_centroid;
+            cluster.updateCentroid();
+            moved = moved || prevCentroid != cluster.m_centroid;
+        }
+
+        // unchanged centroids produce unchanged assignment on the next iteration.
+        return done || !moved;
+    }
+
+    void initAccelerated()
+    {
+        const size_t count = m_region->size();
+        m_xs.resize(count);
+        m_ys.resize(count);
+        m_upper.resize(count);
+        m_lower.resize(count);
+        for (size_t i = 0; MapTilePtr tile : *m_region) {
+            m_xs[i] = tile->m_pos.m_x;
+            m_ys[i] = tile->m_pos.m_y;
+            i++;
+        }
+        m_pruning = true;
+        for (auto& cluster : m_clusters) {
+            const auto& settings = cluster.m_settings;
+            // bounds are valid only for distance monotonous by linear distance.
+            if (settings.m_insideWeight < 0 || settings.m_outsideWeight < 0)
+                m_pruning = false;
+            cluster.m_lipschitz     = std::max(settings.m_insideWeight, settings.m_outsideWeight);
+            cluster.m_boundCentroid = cluster.m_centroid;
+        }
+    }
+
     const MapTileContainer* m_container = nullptr;
     const MapTileRegion*    m_region    = nullptr;
     std::vector<size_t>     m_nearestIndex;
     std::vector<Cluster>    m_clusters;
+
+    bool m_accelerated = false;
+    bool m_pruning     = false;
+
+    // accelerated mode: tile coordinates and distance bounds, indexed same as m_region.
+    std::vector<int>     m_xs;
+    std::vector<int>     m_ys;
+    std::vector<int64_t> m_upper;
+    std::vector<int64_t> m_lower;
 };
 
+size_t ComponentLabels::getIndex(MapTileConstPtr tile) const noexcept
+{
+    const int x = tile->m_pos.m_x - m_origin.m_x;
+    const int y = tile->m_pos.m_y - m_origin.m_y;
+    const int z = tile->m_pos.m_z - m_origin.m_z;
+    if (x < 0 || y < 0 || z < 0 || x >= m_width || y >= m_height || z >= m_depth)
+        return s_outside;
+    return (static_cast<size_t>(z) * m_height + y) * m_width + x;
+}
+
+uint32_t ComponentLabels::getLabel(MapTileConstPtr tile) const noexcept
+{
+    const size_t index = getIndex(tile);
+    return index == s_outside ? 0 : m_labels[index];
+}
+
+uint32_t ComponentLabels::largest() const noexcept
+{
+    uint32_t result = 0;
+    size_t   maxSize = 0;
+    for (size_t i = 0; i < m_sizes.size(); ++i) {
+        if (m_sizes[i] >= maxSize) {
+            maxSize = m_sizes[i];
+            result  = static_cast<uint32_t>(i + 1);
+        }
+    }
+    return result;
+}
+
+MapTileRegion ComponentLabels::makeComponent(const MapTileRegion& region, uint32_t label) const
+{
+    MapTilePtrSortedList result;
+    result.reserve(m_sizes[label - 1]);
+    for (MapTilePtr tile : region) {
+        if (getLabel(tile) == label)
+            result.push_back(tile);
+    }
+    return MapTileRegion(std::move(result));
+}
+
+ComponentLabels MapTileRegionSegmentation::labelComponents(const MapTileRegion& region, bool useDiag)
+{
+    ComponentLabels result;
+    if (region.empty())
+        return result;
+
+    FHPos minPos = region[0]->m_pos;
+    FHPos maxPos = region[0]->m_pos;
+    for (MapTilePtr tile : region) {
+        minPos = FHPos{ std::min(minPos.m_x, tile->m_pos.m_x), std::min(minPos.m_y, tile->m_pos.m_y), std::min(minPos.m_z, tile->m_pos.m_z) };
+        maxPos = FHPos{ std::max(maxPos.m_x, tile->m_pos.m_x), std::max(maxPos.m_y, tile->m_pos.m_y), std::max(maxPos.m_z, tile->m_pos.m_z) };
+    }
+    result.m_origin = minPos;
+    result.m_width  = maxPos.m_x - minPos.m_x + 1;
+    result.m_height = maxPos.m_y - minPos.m_y + 1;
+    result.m_depth  = maxPos.m_z - minPos.m_z + 1;
+    result.m_labels.assign(static_cast<size_t>(result.m_width) * result.m_height * result.m_depth, 0);
+
+    const size_t w = result.m_width;
+
+    // first pass: provisional labels in scan order, merging equivalent ones with union-find.
+    std::vector<uint32_t> parent{ 0 };
+    auto                  findRoot = [&parent](uint32_t label) {
+        while (parent[label] != label) {
+            parent[label] = parent[parent[label]];
+            label         = parent[label];
+        }
+        return label;
+    };
+    auto unite = [&parent, &findRoot](uint32_t current, uint32_t other) {
+        if (!other)
+            return current;
+        other = findRoot(other);
+        if (!current)
+            return other;
+        // keep smaller root, so it always corresponds to first tile in scan order.
+        if (other < current)
+            std::swap(other, current);
+        parent[other] = current;
+        return current;
+    };
+
+    // tiles are sorted by linear index, which is the scan order of label image too.
+    for (MapTilePtr tile : region) {
+        const size_t x     = tile->m_pos.m_x - minPos.m_x;
+        const size_t y     = tile->m_pos.m_y - minPos.m_y;
+        const size_t index = result.getIndex(tile);
+
+        uint32_t label = 0;
+        if (x > 0)
+            label = unite(label, result.m_labels[index - 1]);
+        if (y > 0) {
+            label = unite(label, result.m_labels[index - w]);
+            if (useDiag && x > 0)
+                label = unite(label, result.m_labels[index - w - 1]);
+            if (useDiag && x + 1 < w)
+                label = unite(label, result.m_labels[index - w + 1]);
+        }
+        if (!label) {
+            label = static_cast<uint32_t>(parent.size());
+            parent.push_back(label);
+        }
+        result.m_labels[index] = label;
+    }
+
+    // second pass: resolve roots to sequential final labels.
+    std::vector<uint32_t> finalLabel(parent.size(), 0);
+    for (uint32_t label = 1; label < parent.size(); ++label) {
+        const uint32_t root = findRoot(label);
+        if (root == label) {
+            result.m_sizes.push_back(0);
+            finalLabel[label] = static_cast<uint32_t>(result.m_sizes.size());
+        } else {
+            finalLabel[label] = finalLabel[root];
+        }
+    }
+    for (MapTilePtr tile : region) {
+        uint32_t& label = result.m_labels[result.getIndex(tile)];
+        label           = finalLabel[label];
+        result.m_sizes[label - 1]++;
+    }
+    return result;
+}
+
 MapTileRegionList MapTileRegionSegmentation::splitByFloodFill(const MapTileRegion& region, bool useDiag, MapTilePtr hint)
 {
     if (region.empty())
         return {};
 
-    MapTileRegionList result;
-    MapTilePtrList    currentBuffer;
-
-    MapTileRegion  visited;
-    MapTilePtrList currentEdge;
-    auto           addToCurrent = [&currentBuffer, &visited, &currentEdge, &region](MapTilePtr cell) {
-        if (visited.contains(cell))
-            return;
-        if (!region.contains(cell))
-            return;
-        visited.insert(cell);
-        currentBuffer.push_back(cell);
-        currentEdge.push_back(cell);
-    };
-    MapTileRegion remain = region;
     if (hint) {
-        if (!remain.contains(hint))
+        if (!region.contains(hint))
             throw std::runtime_error("Invalid tile hint provided");
     }
 
-    while (!remain.empty()) {
-        MapTilePtr startCell = hint ? hint : *remain.begin();
-        hint                 = nullptr;
-        addToCurrent(startCell);
+    const ComponentLabels labels = labelComponents(region, useDiag);
 
-        while (!currentEdge.empty()) {
-            MapTilePtrList nextEdge = currentEdge;
-            currentEdge.clear();
+    // component of hint goes first, others keep order of their smallest tile.
+    const uint32_t      hintLabel = hint ? labels.getLabel(hint) : 0;
+    std::vector<size_t> order(labels.count() + 1, 0);
+    size_t              next = hintLabel ? 1 : 0;
+    for (uint32_t label = 1; label <= labels.count(); ++label)
+        order[label] = label == hintLabel ? 0 : next++;
 
-            for (MapTilePtr edgeCell : nextEdge) {
-                const auto& neighbours = edgeCell->neighboursList(useDiag);
-                for (auto growedCell : neighbours) {
-                    addToCurrent(growedCell);
-                }
-            }
-        }
-        MapTileRegion current = MapTileRegion(currentBuffer);
-        currentBuffer.clear();
-        remain.erase(current);
-        result.push_back(std::move(current));
-    }
+    std::vector<MapTilePtrSortedList> parts(labels.count());
+    for (uint32_t label = 1; label <= labels.count(); ++label)
+        parts[order[label]].reserve(labels.m_sizes[label - 1]);
+    for (MapTilePtr tile : region)
+        parts[order[labels.getLabel(tile)]].push_back(tile);
+
+    MapTileRegionList result;
+    result.reserve(parts.size());
+    for (auto& part : parts)
+        result.push_back(MapTileRegion(std::move(part)));
 
     return result;
 }
@@ -330,6 +608,10 @@ MapTileRegionList MapTileRegionSegmentation::splitByKExt(const MapTileRegion& re
         kmeans.m_nearestIndex[i] = size_t(-1);
     }
 
+    kmeans.m_accelerated = settingsList.m_accelerated;
+    if (kmeans.m_accelerated)
+        kmeans.initAccelerated();
+
     for (size_t iter = 0; iter < iterLimit; ++iter) {
         //        std::cout << "clusters:\n";
         //        for (size_t i = 0; i < K; i++) {
@@ -337,8 +619,13 @@ MapTileRegionList MapTileRegionSegmentation::splitByKExt(const MapTileRegion& re
         //        }
         const bool last = iter == iterLimit - 1;
         try {
-            if (kmeans.runIter(last))
+            if (kmeans.runIter(last)) {
+                if (kmeans.m_accelerated)
+                    kmeans.collectPoints();
                 break;
+            }
+            if (last && kmeans.m_accelerated)
+                kmeans.collectPoints();
         }
         catch (...) {
             if (1) {
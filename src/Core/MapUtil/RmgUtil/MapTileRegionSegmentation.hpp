@@ -27,6 +27,29 @@ struct KMeansSegmentationSettings {
         size_t     m_extraMassWeight = 0; // in tiles.
     };
     std::vector<Item> m_items;
+
+    bool m_accelerated = true; // bounds pruning and incremental centroids; gives same result as plain Lloyd iterations.
+};
+
+// Connected components of region as label image over region bounding box.
+// Labels are 1-based and ordered by smallest tile of component; 0 means tile is not in region.
+struct MAPUTIL_EXPORT ComponentLabels {
+    FHPos                 m_origin;
+    int                   m_width  = 0;
+    int                   m_height = 0;
+    int                   m_depth  = 0;
+    std::vector<uint32_t> m_labels;
+    std::vector<size_t>   m_sizes; // tiles count, index is label - 1
+
+    static constexpr size_t s_outside = size_t(-1);
+
+    size_t   count() const noexcept { return m_sizes.size(); }
+    size_t   getIndex(MapTileConstPtr tile) const noexcept; // index in m_labels, or s_outside
+    uint32_t getLabel(MapTileConstPtr tile) const noexcept;
+
+    // label with most tiles; on tie, the last one.
+    uint32_t      largest() const noexcept;
+    MapTileRegion makeComponent(const MapTileRegion& region, uint32_t label) const;
 };
 
 struct MAPUTIL_EXPORT MapTileRegionSegmentation {
@@ -45,6 +68,7 @@ struct MAPUTIL_EXPORT MapTileRegionSegmentation {
         MapTilePtrList m_left;
     };
 
+    static ComponentLabels   labelComponents(const MapTileRegion& region, bool useDiag);
     static MapTileRegionList splitByFloodFill(const MapTileRegion& region, bool useDiag, MapTilePtr hint = nullptr);
     static MapTileRegionList splitByMaxArea(const MapTileRegion& region, size_t maxArea, size_t iterLimit = 100);
     static MapTileRegionList splitByK(const MapTileRegion& region, size_t k, size_t iterLimit = 100);
@@ -16,6 +16,10 @@ namespace FreeHeroes {
 
 void MapTileRegionWithEdge::makeEdgeFromInnerArea()
 {
+    if (!m_edgeDirty)
+        return;
+
+    m_edgeDirty   = false;
     auto result   = m_innerArea.makeInnerAndOuterEdge({ .m_makeInner = true, .m_makeOuter = true });
     m_innerEdge   = std::move(result.m_inner);
     m_outsideEdge = std::move(result.m_outer);
@@ -36,10 +40,12 @@ bool MapTileRegionWithEdge::refineEdgeRemoveHollows(MapTileRegion& allowedArea)
             additional.push_back(cell);
         }
     }
+    const bool changed = !additional.empty();
     allowedArea.erase(additional);
     m_innerArea.insert(additional);
+    m_edgeDirty = m_edgeDirty || changed;
     makeEdgeFromInnerArea();
-    return true;
+    return changed;
 }
 
 bool MapTileRegionWithEdge::refineEdgeRemoveSpikes(MapTileRegion& allowedArea)
@@ -55,27 +61,33 @@ bool MapTileRegionWithEdge::refineEdgeRemoveSpikes(MapTileRegion& allowedArea)
             removal.push_back(cell);
         }
     }
+    const bool changed = !removal.empty();
     allowedArea.insert(removal);
     m_innerArea.erase(removal);
+    m_edgeDirty = m_edgeDirty || changed;
     makeEdgeFromInnerArea();
-    return true;
+    return changed;
 }
 
 bool MapTileRegionWithEdge::refineEdgeExpand(MapTileRegion& allowedArea)
 {
     auto additional = allowedArea.intersectWith(m_outsideEdge);
+    const bool changed = !additional.empty();
     allowedArea.erase(additional);
     m_innerArea.insert(std::move(additional));
+    m_edgeDirty = m_edgeDirty || changed;
     makeEdgeFromInnerArea();
-    return true;
+    return changed;
 }
 
 bool MapTileRegionWithEdge::refineEdgeShrink(MapTileRegion& allowedArea)
 {
+    const bool changed = !m_innerEdge.empty();
     m_innerArea.erase(m_innerEdge);
     allowedArea.insert(m_innerEdge);
+    m_edgeDirty = m_edgeDirty || changed;
     makeEdgeFromInnerArea();
-    return true;
+    return changed;
 }
 
 MapTileRegion MapTileRegionWithEdge::getBottomEdge() const
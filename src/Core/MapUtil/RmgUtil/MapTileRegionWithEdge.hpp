@@ -17,7 +17,6 @@ using MapTileRegionWithEdgeList = std::vector<MapTileRegionWithEdge>;
 
 class MAPUTIL_EXPORT MapTileRegionWithEdge {
 public:
-    MapTileRegion m_innerArea;
     MapTileRegion m_innerEdge;   // subset of innerArea;
     MapTileRegion m_outsideEdge; // is not subset of inner area.
 
@@ -28,8 +27,28 @@ public:
         Expand,
     };
 
+    // inner area is changed only through these methods, so edges are known to be stale.
+    const MapTileRegion& getInnerArea() const { return m_innerArea; }
+    void                 setInnerArea(MapTileRegion area)
+    {
+        m_innerArea = std::move(area);
+        m_edgeDirty = true;
+    }
+    void insertInner(const auto& tiles)
+    {
+        m_innerArea.insert(tiles);
+        m_edgeDirty = true;
+    }
+    void eraseInner(const auto& tiles)
+    {
+        m_innerArea.erase(tiles);
+        m_edgeDirty = true;
+    }
+
+    // edges are recalculated only if inner area was changed since last call.
     void makeEdgeFromInnerArea();
 
+    // return true if inner area was changed.
     bool refineEdgeRemoveHollows(MapTileRegion& allowedArea);
     bool refineEdgeRemoveSpikes(MapTileRegion& allowedArea);
     bool refineEdgeExpand(MapTileRegion& allowedArea);
@@ -68,6 +87,10 @@ public:
     static MapTileRegion                     getInnerBorderNet(const MapTileRegionWithEdgeList& areas);
     static MapTileRegion                     getOuterBorderNet(const MapTileRegionWithEdgeList& areas);
     static std::pair<CollisionResult, FHPos> getCollisionShiftForObject(const MapTileRegion& object, const MapTileRegion& obstacle, bool invertObstacle = false);
+
+private:
+    MapTileRegion m_innerArea;
+    bool          m_edgeDirty = true;
 };
 
 }
@@ -55,7 +55,7 @@ ZoneObjectGeneration ObjectGenerator::generate(const FHRngZone&             zone
 
         {
             auto targetScoreRemainingPrevCopy = targetScoreRemainingPrev;
-            for (auto& [key, val] : targetScoreRemainingPrevCopy) {
+            for (const auto& [key, val] : targetScoreRemainingPrevCopy) {
                 if (targetScore.contains(key)) {
                     targetScore[key] += val;
                     targetScoreRemainingPrev.erase(key);
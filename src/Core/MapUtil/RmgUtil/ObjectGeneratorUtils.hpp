@@ -6,6 +6,7 @@
 #pragma once
 
 #include "ObjectGenerator.hpp"
+#include "WeightedIndex.hpp"
 
 #include "../FHMap.hpp"
 
@@ -33,39 +34,56 @@ struct CommonRecord {
 
 template<class Record>
 struct CommonRecordList {
-    std::vector<Record>        m_records;
-    size_t                     m_active    = 0;
-    uint64_t                   m_frequency = 0;
-    std::map<uint64_t, size_t> m_index;
+    std::vector<Record> m_records;
+    size_t              m_active    = 0;
+    uint64_t            m_frequency = 0;
+    WeightedIndex       m_index;
+    std::vector<size_t> m_accepted; // min limit boost of accepted records is dropped only on next update.
+
+    uint64_t activeFrequency(const Record& rec) const
+    {
+        auto freq = rec.m_frequency;
+        if (!rec.m_enabled || freq == 0)
+            return 0;
+        if (rec.m_minLimit > 0) {
+            if (rec.m_generatedCounter < rec.m_minLimit)
+                freq = 1000000;
+        }
+        return freq;
+    }
 
     void updateFrequency()
     {
-        m_frequency = 0;
-        m_active    = 0;
-        m_index.clear();
+        m_active = 0;
+        m_index.reset(m_records.size());
+        m_accepted.clear();
         for (size_t i = 0; const Record& rec : m_records) {
-            auto freq = rec.m_frequency;
-            if (rec.m_enabled && freq > 0) {
-                if (rec.m_minLimit > 0) {
-                    if (rec.m_generatedCounter < rec.m_minLimit)
-                        freq = 1000000;
-                }
-                m_index[m_frequency] = i;
-                m_frequency += freq;
+            const auto freq = activeFrequency(rec);
+            if (freq > 0) {
+                m_index.setWeight(i, freq);
                 m_active++;
             }
             i++;
         }
+        m_frequency = m_index.total();
     }
 
+    // same as full updateFrequency(), but only for records that could change since last update.
+    void updateFrequency(const Record& changed)
+    {
+        updateRecordFrequency(&changed - m_records.data());
+        for (size_t index : m_accepted)
+            updateRecordFrequency(index);
+        m_accepted.clear();
+        m_frequency = m_index.total();
+    }
+
+    // record frequency covers range (start, start + freq], first record also covers 0.
     size_t getFreqIndex(uint64_t rngFreq) const
     {
-        if (rngFreq == 0)
-            return m_index.at(0);
-        auto it = m_index.lower_bound(rngFreq);
-        it--;
-        const size_t lower = it->second;
-        return lower;
+        if (!m_frequency)
+            throw std::runtime_error("No active records to choose from");
+        return m_index.lowerBound(std::clamp<uint64_t>(rngFreq, 1, m_frequency));
     }
 
     void onDisable(Record& record)
@@ -73,20 +91,32 @@ struct CommonRecordList {
         record.m_attempts--;
         if (record.m_attempts == 0) {
             record.m_enabled = false;
-            updateFrequency();
+            updateFrequency(record);
         }
     }
 
     void onAccept(Record& record)
     {
         record.m_generatedCounter++;
+        m_accepted.push_back(&record - m_records.data());
         if (record.m_maxLimit != -1) {
             if (record.m_generatedCounter >= record.m_maxLimit) {
                 record.m_enabled = false;
-                updateFrequency();
+                updateFrequency(record);
             }
         }
     }
+
+    void updateRecordFrequency(size_t index)
+    {
+        const bool wasActive = m_index.getWeight(index) > 0;
+        const auto freq      = activeFrequency(m_records[index]);
+        m_index.setWeight(index, freq);
+        if (wasActive && !freq)
+            m_active--;
+        if (!wasActive && freq)
+            m_active++;
+    }
 };
 
 struct AcceptableArtifact {
@@ -253,6 +283,7 @@ struct ObjectGenerator::AbstractFactory : public IObjectFactory {
                     Core::IRandomGenerator* const rng)
         : m_map(map)
         , m_scoreSettings(scoreSettings)
+        , m_scoreSettingsChecked(scoreSettings)
         , m_scoreId(scoreId)
         , m_database(database)
         , m_rng(rng)
@@ -280,16 +311,6 @@ struct ObjectGenerator::AbstractFactory : public IObjectFactory {
 
     IZoneObjectPtr makeChecked(uint64_t rngFreq, Core::MapScore& currentScore, const Core::MapScore& targetScore) override // return null on fail
     {
-        auto isScoreOverflow = [&targetScore](const Core::MapScore& current) {
-            for (const auto& [key, val] : current) {
-                if (!targetScore.contains(key))
-                    return true;
-                const auto targetVal = targetScore.at(key);
-                if (val > targetVal)
-                    return true;
-            }
-            return false;
-        };
         /*
 	  target = 20000
 	  current = 14000
@@ -297,7 +318,9 @@ struct ObjectGenerator::AbstractFactory : public IObjectFactory {
 	  max = 7000 -> now max is 6000
 */
 
-        FHScoreSettings scoreSettings = m_scoreSettings; // targetScore can contain MORE than m_scoreSettings, be careful.
+        // reuse settings copy, only scores are changed (sets and lists are kept).
+        FHScoreSettings& scoreSettings = m_scoreSettingsChecked; // targetScore can contain MORE than m_scoreSettings, be careful.
+        scoreSettings.m_score          = m_scoreSettings.m_score;
         for (const auto& [key, val] : currentScore) {
             if (!scoreSettings.m_score.contains(key))
                 continue;
@@ -319,7 +342,7 @@ struct ObjectGenerator::AbstractFactory : public IObjectFactory {
             throw std::runtime_error("Object '" + obj->getId() + "' has no score!");
 
         Core::MapScore currentScoreTmp = currentScore + obj->getScore();
-        if (isScoreOverflow(currentScoreTmp)) {
+        if (currentScoreTmp.isOverflow(targetScore)) {
             //std::cout << "overflow '" << obj->getId() << "' score=" << obj->getScore() << ", current=" << currentScore << "\n";
             obj->setAccepted(false);
             return nullptr;
@@ -335,6 +358,7 @@ struct ObjectGenerator::AbstractFactory : public IObjectFactory {
 
     FHMap&                        m_map;
     const FHScoreSettings         m_scoreSettings;
+    FHScoreSettings               m_scoreSettingsChecked; // scratch for makeChecked
     const std::string             m_scoreId;
     const Core::IGameDatabase*    m_database;
     Core::IRandomGenerator* const m_rng;
@@ -15,113 +15,120 @@
 
 namespace FreeHeroes {
 
-void ObstacleIndex::add(Core::LibraryMapObstacleConstPtr obj)
+void ObstacleBitGrid::init(size_t width, size_t height)
 {
-    auto* def = obj->objectDefs.get({});
-    assert(def);
-    auto mask = def->blockMapPlanar;
-    auto w    = mask.m_width;
-    auto h    = mask.m_height;
-    if (!w || !h)
-        return;
+    m_width    = width;
+    m_height   = height;
+    m_rowWords = width / 64 + 2; // extra word, so 8-bit lookup never needs bounds check.
+    m_required.assign(m_rowWords * height, 0);
+    m_allowed.assign(m_rowWords * height, 0);
+}
 
-    ObstacleBucketList& bucketList = m_bucketLists;
-    auto                it         = std::find_if(bucketList.begin(), bucketList.end(), [&mask](const ObstacleBucket& buck) {
-        return buck.m_mask == mask;
-    });
-    if (it != bucketList.end()) {
-        (*it).m_objects.push_back(obj);
-        return;
-    }
-    ObstacleBucket buck;
-    buck.m_mask = mask;
-    buck.m_area = mask.m_height * mask.m_width;
-    buck.m_objects.push_back(obj);
-    bucketList.push_back(std::move(buck));
+void ObstacleBitGrid::set(size_t x, size_t y, uint8_t value)
+{
+    const size_t   word = y * m_rowWords + x / 64;
+    const uint64_t bit  = uint64_t(1) << (x % 64);
+    m_required[word]    = value == 1 ? (m_required[word] | bit) : (m_required[word] & ~bit);
+    m_allowed[word]     = value != 0 ? (m_allowed[word] | bit) : (m_allowed[word] & ~bit);
 }
 
-void ObstacleIndex::doSort()
+uint8_t ObstacleBitGrid::get(size_t x, size_t y) const
 {
-    //assert(m_bucketLists.contains(Type::Small));
-    // for (auto& bucketList : m_bucketLists) {
-    std::sort(m_bucketLists.begin(), m_bucketLists.end(), [](const ObstacleBucket& l, const ObstacleBucket& r) {
-        return l.m_area > r.m_area;
-    });
-    //}
+    const size_t   word = y * m_rowWords + x / 64;
+    const uint64_t bit  = uint64_t(1) << (x % 64);
+    if (m_required[word] & bit)
+        return 1;
+    return (m_allowed[word] & bit) ? 2 : 0;
 }
 
-bool ObstacleIndex::isEmpty(const Core::PlanarMask& mask, size_t xOffset, size_t yOffset, size_t w, size_t h)
+uint64_t ObstacleBitGrid::rowBits(const std::vector<uint64_t>& bits, size_t xOffset, size_t y) const
 {
-    for (size_t y = 0; y < h && (y + yOffset) < mask.m_height; ++y) {
-        for (size_t x = 0; x < w && (x + xOffset) < mask.m_width; ++x) {
-            const uint8_t requiredBlockBit = mask.m_rows[y + yOffset][x + xOffset];
-            if (requiredBlockBit)
-                return false;
-        }
+    const size_t word  = y * m_rowWords + xOffset / 64;
+    const size_t shift = xOffset % 64;
+    uint64_t     row   = bits[word] >> shift;
+    if (shift)
+        row |= bits[word + 1] << (64 - shift);
+    return row & 0xFFU;
+}
+
+ObstacleBitGrid::Window ObstacleBitGrid::getWindow(size_t xOffset, size_t yOffset) const
+{
+    Window result;
+    if (xOffset >= m_width)
+        return result;
+
+    const size_t   insideWidth = std::min(s_windowWidth, m_width - xOffset);
+    const uint64_t insideRow   = (uint64_t(1) << insideWidth) - 1;
+    for (size_t y = 0; y < s_windowHeight && y + yOffset < m_height; ++y) {
+        const size_t shift = y * s_windowWidth;
+        result.m_required |= rowBits(m_required, xOffset, y + yOffset) << shift;
+        result.m_allowed |= rowBits(m_allowed, xOffset, y + yOffset) << shift;
+        result.m_inside |= insideRow << shift;
     }
-    return true;
+    return result;
 }
 
-std::vector<const ObstacleBucket*> ObstacleIndex::find(const Core::PlanarMask& mask, size_t xOffset, size_t yOffset)
+void ObstacleBucket::setMask(Core::PlanarMask mask)
 {
-    auto w = mask.m_width;
-    auto h = mask.m_height;
-    if (!w || !h)
-        return {};
-
-    auto isMaskFit = [&mask, xOffset, yOffset](const Core::PlanarMask& maskObj) {
-        const auto w       = mask.m_width - xOffset;
-        const auto h       = mask.m_height - yOffset;
-        const auto wmin    = std::min(maskObj.m_width, w);
-        const auto hmin    = std::min(maskObj.m_height, h);
-        size_t     overlap = 0;
-        for (size_t y = 0; y < hmin; ++y) {
-            const auto& row = mask.m_rows[y + yOffset];
-            for (size_t x = 0; x < wmin; ++x) {
-                const bool emptyBlockBit    = row[x + xOffset] == 0;
-                const bool requiredBlockBit = row[x + xOffset] == 1;
-                //const bool tentativeBlockBit = row[x + xOffset] == 2;
-                const bool objBlockBit = maskObj.m_rows[y][x] == 1;
-                if (objBlockBit) {
-                    overlap++;
-                    if (emptyBlockBit)
-                        return false;
-                }
-                if (!objBlockBit) {
-                    if (requiredBlockBit)
-                        return false;
-                }
-            }
-        }
-        return overlap > 0;
-    };
+    m_mask      = std::move(mask);
+    m_area      = m_mask.m_height * m_mask.m_width;
+    m_packed    = m_mask.m_width <= ObstacleBitGrid::s_windowWidth && m_mask.m_height <= ObstacleBitGrid::s_windowHeight;
+    m_blockBits = 0;
+    m_boxBits   = 0;
+    if (!m_packed)
+        return;
 
-    std::vector<const ObstacleBucket*> result;
-    for (const ObstacleBucket& bucket : m_bucketLists) {
-        if (isMaskFit(bucket.m_mask))
-            result.push_back(&bucket);
+    for (size_t y = 0; y < m_mask.m_height; ++y) {
+        for (size_t x = 0; x < m_mask.m_width; ++x) {
+            const uint64_t bit = uint64_t(1) << (y * ObstacleBitGrid::s_windowWidth + x);
+            m_boxBits |= bit;
+            if (m_mask.m_rows[y][x] == 1)
+                m_blockBits |= bit;
+        }
     }
-    return result;
 }
 
-ObstacleHelper::ObstacleHelper(FHMap&                        map,
-                               std::vector<TileZone>&        tileZones,
-                               MapTileContainer&             tileContainer,
-                               Core::IRandomGenerator* const rng,
-                               const Core::IGameDatabase*    database,
-                               std::ostream&                 logOutput)
-    : m_map(map)
-    , m_tileZones(tileZones)
-    , m_tileContainer(tileContainer)
-    , m_rng(rng)
-    , m_database(database)
-    , m_logOutput(logOutput)
+bool ObstacleBucket::isFit(const ObstacleBitGrid::Window& window) const
 {
+    const uint64_t covered = m_blockBits & window.m_inside;
+    if (!covered)
+        return false;
+    if (covered & ~window.m_allowed) // covering empty cell
+        return false;
+    if (m_boxBits & ~m_blockBits & window.m_required) // leaving required cell uncovered
+        return false;
+    return true;
 }
 
-void ObstacleHelper::placeObstacles(size_t minSuitable)
+bool ObstacleBucket::isFitCellwise(const ObstacleBitGrid& grid, size_t xOffset, size_t yOffset) const
+{
+    const auto w       = grid.m_width - xOffset;
+    const auto h       = grid.m_height - yOffset;
+    const auto wmin    = std::min(m_mask.m_width, w);
+    const auto hmin    = std::min(m_mask.m_height, h);
+    size_t     overlap = 0;
+    for (size_t y = 0; y < hmin; ++y) {
+        for (size_t x = 0; x < wmin; ++x) {
+            const uint8_t gridValue        = grid.get(x + xOffset, y + yOffset);
+            const bool    emptyBlockBit    = gridValue == 0;
+            const bool    requiredBlockBit = gridValue == 1;
+            const bool    objBlockBit      = m_mask.m_rows[y][x] == 1;
+            if (objBlockBit) {
+                overlap++;
+                if (emptyBlockBit)
+                    return false;
+            }
+            if (!objBlockBit) {
+                if (requiredBlockBit)
+                    return false;
+            }
+        }
+    }
+    return overlap > 0;
+}
+
+void ObstacleIndex::init(const Core::IGameDatabase* database)
 {
-    ObstacleIndex obstacleIndex;
     using Type = Core::LibraryMapObstacle::Type;
     const std::set<Type> suitableObjTypes{
         Type::BRUSH,
@@ -161,25 +168,116 @@ void ObstacleHelper::placeObstacles(size_t minSuitable)
         Type::SWAMP_FOLIAGE,
     };
 
-    for (auto* record : m_database->mapObstacles()->records()) {
+    for (auto* record : database->mapObstacles()->records()) {
         if (!suitableObjTypes.contains(record->type))
             continue;
-        obstacleIndex.add(record);
+        add(record);
     }
-    obstacleIndex.doSort();
+    doSort();
+}
 
-    Core::PlanarMask mapMask;
-    mapMask.m_width  = m_map.m_tileMap.m_width;
-    mapMask.m_height = m_map.m_tileMap.m_height;
-    mapMask.m_rows.resize(mapMask.m_height);
-    for (auto& row : mapMask.m_rows)
-        row.resize(mapMask.m_width);
+void ObstacleIndex::add(Core::LibraryMapObstacleConstPtr obj)
+{
+    auto* def = obj->objectDefs.get({});
+    assert(def);
+    auto mask = def->blockMapPlanar;
+    auto w    = mask.m_width;
+    auto h    = mask.m_height;
+    if (!w || !h)
+        return;
+
+    ObstacleBucketList& bucketList = m_bucketLists;
+    auto                it         = std::find_if(bucketList.begin(), bucketList.end(), [&mask](const ObstacleBucket& buck) {
+        return buck.m_mask == mask;
+    });
+    if (it != bucketList.end()) {
+        (*it).m_objects.push_back(obj);
+        return;
+    }
+    ObstacleBucket buck;
+    buck.setMask(std::move(mask));
+    buck.m_objects.push_back(obj);
+    bucketList.push_back(std::move(buck));
+}
+
+void ObstacleIndex::doSort()
+{
+    std::sort(m_bucketLists.begin(), m_bucketLists.end(), [](const ObstacleBucket& l, const ObstacleBucket& r) {
+        return l.m_area > r.m_area;
+    });
+
+    for (auto& group : m_packedByKey)
+        group.clear();
+    m_unpacked.clear();
+    for (size_t i = 0; i < m_bucketLists.size(); ++i) {
+        const ObstacleBucket& bucket = m_bucketLists[i];
+        if (bucket.m_packed)
+            m_packedByKey[cornerKey(bucket.m_blockBits)].push_back(i);
+        else
+            m_unpacked.push_back(i);
+    }
+}
+
+std::vector<const ObstacleBucket*> ObstacleIndex::find(const ObstacleBitGrid& grid, const ObstacleBitGrid::Window& window, size_t xOffset, size_t yOffset) const
+{
+    // bucket can fit only if its corner blocks nothing but allowed cells (cells outside of map do not matter),
+    // so only groups with key being a submask of free corner are checked.
+    const uint64_t keyMask    = (uint64_t(1) << s_keyBits) - 1;
+    const uint64_t freeCorner = cornerKey(window.m_allowed) | (~cornerKey(window.m_inside) & keyMask);
+
+    std::vector<size_t> candidates;
+    for (uint64_t key = freeCorner;; key = (key - 1) & freeCorner) {
+        for (size_t index : m_packedByKey[key]) {
+            if (m_bucketLists[index].isFit(window))
+                candidates.push_back(index);
+        }
+        if (!key)
+            break;
+    }
+    for (size_t index : m_unpacked) {
+        if (m_bucketLists[index].isFitCellwise(grid, xOffset, yOffset))
+            candidates.push_back(index);
+    }
+    // keep order of m_bucketLists.
+    std::sort(candidates.begin(), candidates.end());
+
+    std::vector<const ObstacleBucket*> result;
+    result.reserve(candidates.size());
+    for (size_t index : candidates)
+        result.push_back(&m_bucketLists[index]);
+    return result;
+}
+
+uint64_t ObstacleIndex::cornerKey(uint64_t windowBits)
+{
+    return (windowBits & 0b111) | (((windowBits >> ObstacleBitGrid::s_windowWidth) & 0b111) << 3);
+}
+
+ObstacleHelper::ObstacleHelper(FHMap&                        map,
+                               std::vector<TileZone>&        tileZones,
+                               MapTileContainer&             tileContainer,
+                               Core::IRandomGenerator* const rng,
+                               const ObstacleIndex&          obstacleIndex,
+                               std::ostream&                 logOutput)
+    : m_map(map)
+    , m_tileZones(tileZones)
+    , m_tileContainer(tileContainer)
+    , m_rng(rng)
+    , m_obstacleIndex(obstacleIndex)
+    , m_logOutput(logOutput)
+{
+}
+
+void ObstacleHelper::placeObstacles(size_t minSuitable)
+{
+    ObstacleBitGrid mapMask;
+    mapMask.init(m_map.m_tileMap.m_width, m_map.m_tileMap.m_height);
 
     for (auto& tileZone : m_tileZones) {
         for (MapTilePtr cell : tileZone.m_needPlaceObstacles)
-            mapMask.m_rows[cell->m_pos.m_y][cell->m_pos.m_x] = 1;
+            mapMask.set(cell->m_pos.m_x, cell->m_pos.m_y, 1);
         for (MapTilePtr cell : tileZone.m_needPlaceObstaclesTentative) {
-            mapMask.m_rows[cell->m_pos.m_y][cell->m_pos.m_x] = 2;
+            mapMask.set(cell->m_pos.m_x, cell->m_pos.m_y, 2);
         }
 
         //m_map.m_debugTiles.push_back(FHDebugTile{ .m_pos = cell->m_pos, .m_valueA = 0, .m_valueB = 2 });
@@ -187,9 +285,6 @@ void ObstacleHelper::placeObstacles(size_t minSuitable)
 
     MapTileRegion hasBlocked;
 
-    const size_t maxMaskLookupWidth  = 8;
-    const size_t maxMaskLookupHeight = 6;
-
     /*
     for (size_t y = 0; y < mapMask.height; ++y) {
         for (size_t x = 0; x < mapMask.width; ++x) {
@@ -205,9 +300,10 @@ void ObstacleHelper::placeObstacles(size_t minSuitable)
         for (size_t x = 0; x < mapMask.m_width; ++x) {
             //if (mapMask.data[y][x] == 0)
             //    continue;
-            if (obstacleIndex.isEmpty(mapMask, x, y, maxMaskLookupWidth, maxMaskLookupHeight))
+            const ObstacleBitGrid::Window window = mapMask.getWindow(x, y);
+            if (!window.m_allowed)
                 continue;
-            std::vector<const ObstacleBucket*> buckets = obstacleIndex.find(mapMask, x, y);
+            std::vector<const ObstacleBucket*> buckets = m_obstacleIndex.find(mapMask, window, x, y);
             if (buckets.empty())
                 continue;
             assert(!buckets.empty());
@@ -266,8 +362,8 @@ void ObstacleHelper::placeObstacles(size_t minSuitable)
                     size_t py = y + my;
                     FHPos  maskBitPos{ (int) px, (int) py, 0 };
                     if (py < mapMask.m_height && px < mapMask.m_width) {
-                        if (mapMask.m_rows[py][px] == 1)
-                            mapMask.m_rows[py][px] = 2;
+                        if (mapMask.get(px, py) == 1)
+                            mapMask.set(px, py, 2);
                         auto* cell = m_tileContainer.m_tileIndex.at(maskBitPos);
                         hasBlocked.insert(cell);
                     }
@@ -7,7 +7,10 @@
 
 #include "TileZone.hpp"
 
+#include "MapUtilExport.hpp"
+
 #include <algorithm>
+#include <array>
 
 namespace FreeHeroes {
 
@@ -15,23 +18,73 @@ namespace Core {
 class IGameDatabase;
 }
 
-struct ObstacleBucket {
+// Free space for obstacles as row bitsets, 'required' cells must be covered, 'allowed' cells may be covered (required or tentative).
+struct MAPUTIL_EXPORT ObstacleBitGrid {
+    static constexpr size_t s_windowWidth  = 8;
+    static constexpr size_t s_windowHeight = 6;
+
+    // lookup window of 8x6 cells packed into 64 bits: bit (y * 8 + x).
+    struct Window {
+        uint64_t m_required = 0;
+        uint64_t m_allowed  = 0;
+        uint64_t m_inside   = 0; // cells that are within map bounds
+    };
+
+    void init(size_t width, size_t height);
+
+    // value is PlanarMask-style: 0 - empty, 1 - required, 2 - tentative.
+    void    set(size_t x, size_t y, uint8_t value);
+    uint8_t get(size_t x, size_t y) const;
+
+    Window getWindow(size_t xOffset, size_t yOffset) const;
+
+    size_t m_width  = 0;
+    size_t m_height = 0;
+
+private:
+    uint64_t rowBits(const std::vector<uint64_t>& bits, size_t xOffset, size_t y) const;
+
+    size_t                m_rowWords = 0;
+    std::vector<uint64_t> m_required;
+    std::vector<uint64_t> m_allowed;
+};
+
+struct MAPUTIL_EXPORT ObstacleBucket {
     std::vector<Core::LibraryMapObstacleConstPtr> m_objects;
     Core::PlanarMask                              m_mask;
     size_t                                        m_area = 0;
+
+    uint64_t m_blockBits = 0; // packed like ObstacleBitGrid::Window
+    uint64_t m_boxBits   = 0; // all cells of mask bounding box
+    bool     m_packed    = false;
+
+    void setMask(Core::PlanarMask mask);
+
+    bool isFit(const ObstacleBitGrid::Window& window) const;
+    bool isFitCellwise(const ObstacleBitGrid& grid, size_t xOffset, size_t yOffset) const;
 };
 using ObstacleBucketList = std::vector<ObstacleBucket>;
 
-struct ObstacleIndex {
+struct MAPUTIL_EXPORT ObstacleIndex {
+    // packed buckets are grouped by blocked cells of top-left 3x2 corner (bits 0-2 first row, 3-5 second row).
+    static constexpr size_t s_keyBits = 6;
+
     ObstacleBucketList m_bucketLists;
 
+    // all obstacles suitable for generation, sorted.
+    void init(const Core::IGameDatabase* database);
+
     void add(Core::LibraryMapObstacleConstPtr obj);
-    void doSort();
+    void doSort(); // also rebuilds lookup groups, call after any change of m_bucketLists
 
-    bool isEmpty(const Core::PlanarMask& mask, size_t xOffset, size_t yOffset, size_t w, size_t h);
+    // buckets that fit into top-left corner of 8x6 window, largest first.
+    std::vector<const ObstacleBucket*> find(const ObstacleBitGrid& grid, const ObstacleBitGrid::Window& window, size_t xOffset, size_t yOffset) const;
 
-    // mask is 8x6, for example. we will search for an object that fits int top-left corner.
-    std::vector<const ObstacleBucket*> find(const Core::PlanarMask& mask, size_t xOffset, size_t yOffset);
+    static uint64_t cornerKey(uint64_t windowBits);
+
+private:
+    std::array<std::vector<size_t>, size_t(1) << s_keyBits> m_packedByKey; // indices in m_bucketLists
+    std::vector<size_t>                                     m_unpacked;
 };
 
 struct FHMap;
@@ -41,7 +94,7 @@ public:
                    std::vector<TileZone>&        tileZones,
                    MapTileContainer&             tileContainer,
                    Core::IRandomGenerator* const rng,
-                   const Core::IGameDatabase*    database,
+                   const ObstacleIndex&          obstacleIndex,
                    std::ostream&                 logOutput);
 
     void placeObstacles(size_t minSuitable);
@@ -51,7 +104,7 @@ private:
     std::vector<TileZone>&           m_tileZones;
     MapTileContainer&                m_tileContainer;
     Core::IRandomGenerator* const    m_rng;
-    const Core::IGameDatabase* const m_database;
+    const ObstacleIndex&             m_obstacleIndex;
     std::ostream&                    m_logOutput;
 };
 
@@ -129,28 +129,28 @@ void SegmentHelper::makeInitialZones(std::vector<TileZone>& tileZones)
     }
 
     for (auto& tileZone : tileZones) {
-        tileZone.m_area.m_innerArea = std::move(splitRegions[tileZone.m_index]);
+        tileZone.m_area.setInnerArea(std::move(splitRegions[tileZone.m_index]));
 
         tileZone.m_area.makeEdgeFromInnerArea();
         /*
         for (auto* tile : tileZone.m_area.m_innerEdge) {
-            const bool eT        = tileZone.m_area.m_innerArea.contains(tile->m_neighborT);
-            const bool eL        = tileZone.m_area.m_innerArea.contains(tile->m_neighborL);
-            const bool eR        = tileZone.m_area.m_innerArea.contains(tile->m_neighborR);
-            const bool eB        = tileZone.m_area.m_innerArea.contains(tile->m_neighborB);
+            const bool eT        = tileZone.m_area.getInnerArea().contains(tile->m_neighborT);
+            const bool eL        = tileZone.m_area.getInnerArea().contains(tile->m_neighborL);
+            const bool eR        = tileZone.m_area.getInnerArea().contains(tile->m_neighborR);
+            const bool eB        = tileZone.m_area.getInnerArea().contains(tile->m_neighborB);
             const int  sameCount = eT + eL + eR + eB;
             if (sameCount == 2) {
                 if ((eT && eB) || (eR && eL)) {
-                    tileZone.m_area.m_innerArea.erase(tile);
+                    tileZone.m_area.eraseInner(tile);
                 }
             }
         }
         tileZone.m_area.m_innerArea.eraseExclaves(false);*/
         tileZone.m_area.makeEdgeFromInnerArea();
 
-        for (auto* tile : tileZone.m_area.m_innerArea)
+        for (auto* tile : tileZone.m_area.getInnerArea())
             tile->m_zone = &tileZone;
-        tileZone.m_centroid = tileZone.m_area.m_innerArea.makeCentroid(true);
+        tileZone.m_centroid = tileZone.m_area.getInnerArea().makeCentroid(true);
 
         m_logOutput << m_indent << "zone [" << tileZone.m_id << "] areaDeficit=" << tileZone.getAreaDeficit() << "\n";
     }
@@ -205,7 +205,7 @@ MapGuardList SegmentHelper::makeBorders(std::vector<TileZone>& tileZones)
     // generate blocked tiles
 
     for (auto& tileZone : tileZones) {
-        tileZone.m_protectionBorder   = tileZone.m_area.m_innerArea.makeInnerEdge(true).intersectWith(allBorderNet);
+        tileZone.m_protectionBorder   = tileZone.m_area.getInnerArea().makeInnerEdge(true).intersectWith(allBorderNet);
         tileZone.m_needPlaceObstacles = tileZone.m_protectionBorder;
 
         const TileZone::TileIntMapping costs = tileZone.makeMoveCosts(false);
@@ -215,7 +215,7 @@ MapGuardList SegmentHelper::makeBorders(std::vector<TileZone>& tileZones)
         for (auto tile : tileZone.m_protectionBorder)
             completed.insert(tile);
 
-        for (auto tile : tileZone.m_area.m_innerArea) {
+        for (auto tile : tileZone.m_area.getInnerArea()) {
             remaining.insert(tile);
         }
         const int borderRadius = 2;
@@ -232,13 +232,13 @@ MapGuardList SegmentHelper::makeBorders(std::vector<TileZone>& tileZones)
                 tileZone.m_needPlaceObstaclesTentative.insert(area);
         }
 
-        tileZone.m_innerAreaUsable.m_innerArea = tileZone.m_area.m_innerArea;
-        tileZone.m_innerAreaUsable.m_innerArea.erase(tileZone.m_needPlaceObstacles);
-        tileZone.m_innerAreaUsable.m_innerArea.erase(tileZone.m_needPlaceObstaclesTentative);
+        tileZone.m_innerAreaUsable.setInnerArea(tileZone.m_area.getInnerArea());
+        tileZone.m_innerAreaUsable.eraseInner(tileZone.m_needPlaceObstacles);
+        tileZone.m_innerAreaUsable.eraseInner(tileZone.m_needPlaceObstaclesTentative);
         tileZone.m_innerAreaUsable.makeEdgeFromInnerArea();
 
         auto bottomLine = tileZone.m_innerAreaUsable.getBottomEdge();
-        tileZone.m_innerAreaUsable.m_innerArea.erase(bottomLine);
+        tileZone.m_innerAreaUsable.eraseInner(bottomLine);
         tileZone.m_innerAreaUsable.makeEdgeFromInnerArea();
     }
 
@@ -327,7 +327,7 @@ void SegmentHelper::makeSegments(TileZone& tileZone)
 {
     Mernel::ProfilerScope scope("makeSegments");
     // make k-means segmentation
-    auto segmentList = tileZone.m_innerAreaUsable.m_innerArea.splitByMaxArea(tileZone.m_rngZoneSettings.m_segmentAreaSize, 30);
+    auto segmentList = tileZone.m_innerAreaUsable.getInnerArea().splitByMaxArea(tileZone.m_rngZoneSettings.m_segmentAreaSize, 30);
 
     if (segmentList.empty())
         throw std::runtime_error("No segments in tile zone!");
@@ -351,7 +351,7 @@ void SegmentHelper::makeSegments(TileZone& tileZone)
 
     // remove inner network from segments
     for (auto& seg : tileZone.m_innerAreaSegments) {
-        seg.m_innerArea.erase(borderNet);
+        seg.eraseInner(borderNet);
         seg.makeEdgeFromInnerArea();
     }
 
@@ -368,7 +368,7 @@ void SegmentHelper::makeSegments(TileZone& tileZone)
     tileZone.updateSegmentIndex();
 
     // make bordernet as everything non-segment
-    borderNet = tileZone.m_innerAreaUsable.m_innerArea.diffWith(tileZone.m_innerAreaSegmentsUnited);
+    borderNet = tileZone.m_innerAreaUsable.getInnerArea().diffWith(tileZone.m_innerAreaSegmentsUnited);
 
     //
 
@@ -475,7 +475,7 @@ void SegmentHelper::makeSegments(TileZone& tileZone)
 
                 AstarGenerator generator;
                 generator.setPoints(closestTileInOrphan, largestNearest);
-                auto usable = tileZone.m_innerAreaUsable.m_innerArea;
+                auto usable = tileZone.m_innerAreaUsable.getInnerArea();
                 usable.insert(closestTileInOrphan);
                 usable.insert(largestNearest);
                 generator.setNonCollision(std::move(usable));
@@ -493,11 +493,11 @@ void SegmentHelper::makeSegments(TileZone& tileZone)
 void SegmentHelper::refineSegments(TileZone& tileZone)
 {
     Mernel::ProfilerScope scope("refineSegments");
-    auto                  innerWithoutRoads = tileZone.m_innerAreaUsable.m_innerArea;
+    auto                  innerWithoutRoads = tileZone.m_innerAreaUsable.getInnerArea();
     innerWithoutRoads.erase(tileZone.m_roads.m_all);
 
     for (auto& seg : tileZone.m_innerAreaSegments) {
-        seg.m_innerArea.erase(tileZone.m_roads.m_all);
+        seg.eraseInner(tileZone.m_roads.m_all);
         seg.makeEdgeFromInnerArea();
         seg.refineEdgeRemoveSpikes(innerWithoutRoads);
     }
@@ -534,7 +534,7 @@ void SegmentHelper::makeHeatMap(TileZone& tileZone)
     if (completed.empty())
         completed.insert(tileZone.m_centroid);
 
-    for (auto tile : tileZone.m_innerAreaUsable.m_innerArea) {
+    for (auto tile : tileZone.m_innerAreaUsable.getInnerArea()) {
         if (!completed.contains(tile))
             remaining.insert(tile);
     }
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2023 Smirnov Vladimir / mapron1@gmail.com
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file for details.
+ */
+#pragma once
+
+#include "MapTileContainer.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace FreeHeroes {
+
+// Owner id for every tile of container, stored by linear index; 0 means tile has no owner.
+class TileOwnerGrid {
+public:
+    static constexpr uint32_t s_noOwner = 0;
+
+    void init(const MapTileContainer& container)
+    {
+        m_width  = container.m_width;
+        m_height = container.m_height;
+        m_owners.assign(static_cast<size_t>(container.m_width) * container.m_height * container.m_depth, s_noOwner);
+    }
+
+    uint32_t get(MapTileConstPtr tile) const noexcept { return m_owners[index(tile)]; }
+    void     set(MapTileConstPtr tile, uint32_t owner) noexcept { m_owners[index(tile)] = owner; }
+    void     set(const MapTileRegion& region, uint32_t owner) noexcept
+    {
+        for (MapTilePtr tile : region)
+            set(tile, owner);
+    }
+
+    bool isOwnedBy(const MapTileRegion& region, uint32_t owner) const noexcept
+    {
+        for (MapTilePtr tile : region) {
+            if (get(tile) != owner)
+                return false;
+        }
+        return true;
+    }
+    // first owner found in region, or s_noOwner.
+    uint32_t findOwner(const MapTileRegion& region) const noexcept
+    {
+        for (MapTilePtr tile : region) {
+            if (const uint32_t owner = get(tile); owner != s_noOwner)
+                return owner;
+        }
+        return s_noOwner;
+    }
+
+    MapTileRegion filterNotOwned(const MapTileRegion& region) const
+    {
+        MapTilePtrSortedList result;
+        result.reserve(region.size());
+        for (MapTilePtr tile : region) {
+            if (get(tile) == s_noOwner)
+                result.push_back(tile);
+        }
+        return MapTileRegion(std::move(result));
+    }
+
+private:
+    size_t index(MapTileConstPtr tile) const noexcept
+    {
+        return (static_cast<size_t>(tile->m_pos.m_z) * m_height + tile->m_pos.m_y) * m_width + tile->m_pos.m_x;
+    }
+
+    int                   m_width  = 0;
+    int                   m_height = 0;
+    std::vector<uint32_t> m_owners;
+};
+
+}
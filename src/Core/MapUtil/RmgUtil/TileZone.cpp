@@ -32,13 +32,13 @@ MapTileRegionWithEdgeList TileZone::getSegments() const
 
 void TileZone::updateSegmentIndex()
 {
-    for (auto* tile : m_innerAreaUsable.m_innerArea)
+    for (auto* tile : m_innerAreaUsable.getInnerArea())
         tile->m_segmentMedium = nullptr;
 
     m_innerAreaSegmentsUnited.clear();
     for (auto& seg : m_innerAreaSegments) {
-        m_innerAreaSegmentsUnited.insert(seg.m_innerArea);
-        for (auto* tile : seg.m_innerArea)
+        m_innerAreaSegmentsUnited.insert(seg.getInnerArea());
+        for (auto* tile : seg.getInnerArea())
             tile->m_segmentMedium = &seg;
     }
 }
@@ -46,7 +46,7 @@ void TileZone::updateSegmentIndex()
 TileZone::TileIntMapping TileZone::makeMoveCosts(bool onlyUsable) const
 {
     TileIntMapping costs;
-    auto&          area = onlyUsable ? m_innerAreaUsable.m_innerArea : m_area.m_innerArea;
+    auto&          area = onlyUsable ? m_innerAreaUsable.getInnerArea() : m_area.getInnerArea();
     for (auto tile : area)
         costs[tile] = 100;
     for (const auto& [level, rarea] : m_roads.m_byLevel) {
@@ -139,7 +139,7 @@ struct TileZone {
 
     int64_t getPlacedArea() const
     {
-        return m_area.m_innerArea.size();
+        return m_area.getInnerArea().size();
     }
     int64_t getAreaDeficit() const
     {
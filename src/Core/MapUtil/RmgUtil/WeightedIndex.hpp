@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2023 Smirnov Vladimir / mapron1@gmail.com
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file for details.
+ */
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace FreeHeroes {
+
+// Fenwick tree over item weights: weight change and lookup by cumulative weight are O(log n).
+class WeightedIndex {
+public:
+    void reset(size_t size)
+    {
+        m_tree.assign(size + 1, 0);
+        m_weights.assign(size, 0);
+        m_total = 0;
+    }
+
+    void setWeight(size_t index, uint64_t weight)
+    {
+        const uint64_t prev = m_weights[index];
+        if (prev == weight)
+            return;
+        m_weights[index] = weight;
+        m_total          = m_total - prev + weight;
+        // unsigned wrap-around makes decrease work same as increase.
+        const uint64_t delta = weight - prev;
+        for (size_t i = index + 1; i < m_tree.size(); i += i & (~i + 1))
+            m_tree[i] += delta;
+    }
+
+    uint64_t getWeight(size_t index) const { return m_weights[index]; }
+    uint64_t total() const noexcept { return m_total; }
+    size_t   size() const noexcept { return m_weights.size(); }
+
+    // smallest index which cumulative weight (including itself) is >= value; size() if there is none.
+    size_t lowerBound(uint64_t value) const
+    {
+        const size_t n   = m_weights.size();
+        size_t       pos = 0;
+        for (size_t step = std::bit_floor(n); step; step >>= 1) {
+            if (pos + step <= n && m_tree[pos + step] < value) {
+                pos += step;
+                value -= m_tree[pos];
+            }
+        }
+        return pos;
+    }
+
+private:
+    std::vector<uint64_t> m_tree; // 1-based partial sums
+    std::vector<uint64_t> m_weights;
+    uint64_t              m_total = 0;
+};
+
+}
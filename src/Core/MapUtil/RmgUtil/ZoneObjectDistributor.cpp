@@ -19,6 +19,25 @@
 
 namespace FreeHeroes {
 
+void ZoneObjectWrap::initFootprint()
+{
+    const auto visitMask     = m_object->getVisitableMask();
+    const auto blockNotVisit = m_object->getBlockedUnvisitableMask();
+
+    m_footprintOffsets.assign(visitMask.cbegin(), visitMask.cend());
+    m_footprintOffsets.insert(m_footprintOffsets.end(), blockNotVisit.cbegin(), blockNotVisit.cend());
+    m_footprintVisitCount = visitMask.size();
+    if (m_footprintOffsets.empty())
+        return;
+
+    m_footprintMin = m_footprintOffsets[0];
+    m_footprintMax = m_footprintOffsets[0];
+    for (FHPos offset : m_footprintOffsets) {
+        m_footprintMin = FHPos{ std::min(m_footprintMin.m_x, offset.m_x), std::min(m_footprintMin.m_y, offset.m_y), 0 };
+        m_footprintMax = FHPos{ std::max(m_footprintMax.m_x, offset.m_x), std::max(m_footprintMax.m_y, offset.m_y), 0 };
+    }
+}
+
 bool ZoneObjectWrap::estimateOccupied(MapTilePtr absPosCenter)
 {
     if (!absPosCenter)
@@ -42,9 +61,7 @@ bool ZoneObjectWrap::estimateOccupied(MapTilePtr absPosCenter)
         return false;
     }
 
-    const auto visitMask     = m_object->getVisitableMask();
-    const auto blockNotVisit = m_object->getBlockedUnvisitableMask();
-    if (visitMask.empty()) {
+    if (!m_footprintVisitCount) {
         assert(!"Non-visitables not supported");
         return false;
     }
@@ -52,20 +69,16 @@ bool ZoneObjectWrap::estimateOccupied(MapTilePtr absPosCenter)
     MapTileRegion blockNotVisitRegion;
 
     {
-        for (FHPos offset : visitMask) {
-            auto* tile = m_absPos->neighbourByOffset(offset);
-            if (!tile)
-                return false;
-            visitMaskRegion.insert(tile);
-        }
-        for (FHPos offset : blockNotVisit) {
-            auto* tile = m_absPos->neighbourByOffset(offset);
+        for (size_t i = 0; i < m_footprintOffsets.size(); ++i) {
+            auto* tile = m_absPos->neighbourByOffset(m_footprintOffsets[i]);
             if (!tile)
                 return false;
-            blockNotVisitRegion.insert(tile);
+            if (i < m_footprintVisitCount)
+                visitMaskRegion.insert(tile);
+            else
+                blockNotVisitRegion.insert(tile);
         }
         m_rewardArea = visitMaskRegion.unionWith(blockNotVisitRegion);
-        assert((visitMaskRegion.size() + blockNotVisitRegion.size()) > 0);
     }
     const MapTilePtr lastVisitTile   = visitMaskRegion[visitMaskRegion.size() - 1];
     const auto       rewardAreaOuter = m_rewardArea.makeOuterEdge(true);
@@ -174,6 +187,11 @@ bool ZoneObjectDistributor::makeInitialDistribution(DistributionResult& distribu
     }
     if (generated.m_objects.empty())
         return true;
+
+    distribution.m_freeOwners.init(m_tileContainer);
+    for (ZoneSegment& seg : distribution.m_segments)
+        seg.updateFreeOwners(distribution.m_freeOwners, {});
+
     size_t                totalSizeObjects = 0;
     ZoneObjectWrapPtrList segmentsNormal;
     for (auto& obj : generated.m_objects) {
@@ -293,7 +311,7 @@ bool ZoneObjectDistributor::makeInitialDistribution(DistributionResult& distribu
         const auto& roadRegion = distribution.m_tileZone->m_roads.m_all;
         auto&       freeRoads  = distribution.m_allFreeRoads;
         auto&       freeCells  = distribution.m_allFreeCells;
-        freeRoads              = roadRegion.intersectWith(distribution.m_tileZone->m_innerAreaUsable.m_innerArea);
+        freeRoads              = roadRegion.intersectWith(distribution.m_tileZone->m_innerAreaUsable.getInnerArea());
         freeRoads.erase(distribution.m_tileZone->m_nodes.getRegion(RoadLevel::Towns));
         if (freeRoads.size() < distribution.m_roadPickables.size()) {
             m_logOutput << m_indent << "Roads size " << freeRoads.size() << " < " << distribution.m_roadPickables.size() << "\n";
@@ -318,19 +336,20 @@ void ZoneObjectDistributor::doPlaceDistribution(DistributionResult& distribution
     if (distribution.m_allObjects.empty())
         return;
 
-    MergedRegion  totalFreeTiles;
-    MapTileRegion placedTiles;
+    MergedRegion   totalFreeTiles;
+    TileOwnerGrid& placedOwners = distribution.m_placedOwners;
+    placedOwners.init(m_tileContainer);
 
     for (ZoneSegment& seg : distribution.m_segments) {
         for (auto* object : seg.m_successNormal) {
-            commitPlacement(distribution, object, placedTiles);
+            commitPlacement(distribution, object);
         }
     }
 
     if (distribution.m_stopAfterHeat == 1000) {
         const auto& roadRegion = distribution.m_allFreeRoads;
         auto&       freeCells  = distribution.m_allFreeCells;
-        if (!placedTiles.intersectWith(roadRegion).empty())
+        if (placedOwners.findOwner(roadRegion) != TileOwnerGrid::s_noOwner)
             throw std::runtime_error("roadRegion tiles already were used");
         std::set<size_t> indexes;
         for (size_t i = 0; auto* obj : distribution.m_roadPickables) {
@@ -343,13 +362,11 @@ void ZoneObjectDistributor::doPlaceDistribution(DistributionResult& distribution
             obj->m_absPos = roadRegion[index];
             obj->estimateOccupied(obj->m_absPos);
 
-            commitPlacement(distribution, obj, placedTiles);
+            commitPlacement(distribution, obj);
         }
 
-        freeCells.erase(placedTiles);
+        freeCells = placedOwners.filterNotOwned(freeCells);
 
-        if (!placedTiles.intersectWith(freeCells).empty())
-            throw std::runtime_error("freeCells tiles already were used");
         indexes.clear();
         for (size_t i = 0; auto* obj : distribution.m_segFreePickables) {
             size_t index = i++ * freeCells.size() / distribution.m_segFreePickables.size();
@@ -361,7 +378,7 @@ void ZoneObjectDistributor::doPlaceDistribution(DistributionResult& distribution
             obj->m_absPos = freeCells[index];
             obj->estimateOccupied(obj->m_absPos);
 
-            commitPlacement(distribution, obj, placedTiles);
+            commitPlacement(distribution, obj);
         }
     }
 
@@ -430,14 +447,23 @@ bool ZoneObjectDistributor::placeWrapIntoSegments(DistributionResult& distributi
 
         segCandidatesSorted.insert(std::tuple{ distance, seg });
     }
+    const TileOwnerGrid& freeOwners = distribution.m_freeOwners;
+    MapTilePtr           skippedLast = nullptr;
     for (auto& [_, seg] : segCandidatesSorted) {
         auto tiles = object->m_objectType == ZoneObjectType::Segment ? seg->getTilesByDistance() : seg->getTilesByDistanceFrom(object->m_preferredPos);
         for (auto* tile : tiles) {
+            skippedLast = nullptr;
+            if (!seg->mayFit(*object, tile, freeOwners)) {
+                skippedLast = tile;
+                continue;
+            }
             if (object->estimateOccupied(tile)) {
-                if (seg->m_freeArea.intersectWith(object->m_occupiedWithDangerZone) == object->m_occupiedWithDangerZone) {
+                if (freeOwners.isOwnedBy(object->m_occupiedWithDangerZone, seg->getOwnerId())) {
+                    const MapTileRegion prevFree = seg->m_freeArea;
                     seg->m_freeArea.erase(object->m_allArea);
 
                     seg->m_freeArea.eraseExclaves(false);
+                    seg->updateFreeOwners(distribution.m_freeOwners, prevFree);
                     seg->m_spacingArea.insert(object->m_passAroundEdge);
 
                     seg->m_successNormal.push_back(object);
@@ -448,16 +474,23 @@ bool ZoneObjectDistributor::placeWrapIntoSegments(DistributionResult& distributi
             }
         }
     }
+    // keep object state of the last tried position, it is used for failure report.
+    if (skippedLast)
+        object->estimateOccupied(skippedLast);
 
     return false;
 }
 
-void ZoneObjectDistributor::commitPlacement(DistributionResult& distribution, ZoneObjectWrap* object, MapTileRegion& placedTiles) const
+void ZoneObjectDistributor::commitPlacement(DistributionResult& distribution, ZoneObjectWrap* object) const
 {
-    if (!placedTiles.intersectWith(object->m_occupiedWithDangerZone).empty())
-        throw std::runtime_error("Placing object in same area twice");
+    if (const uint32_t owner = distribution.m_placedOwners.findOwner(object->m_occupiedWithDangerZone); owner != TileOwnerGrid::s_noOwner) {
+        const ZoneObjectWrap& prev = distribution.m_allObjects[owner - 1];
+        throw std::runtime_error("Placing object in same area twice, area is used by " + prev.m_object->getId());
+    }
 
-    placedTiles.insert(object->m_occupiedWithDangerZone);
+    const size_t objectIndex = object - distribution.m_allObjects.data();
+    assert(objectIndex < distribution.m_allObjects.size());
+    distribution.m_placedOwners.set(object->m_occupiedWithDangerZone, static_cast<uint32_t>(objectIndex + 1));
 
     object->place();
     //m_map.m_debugTiles.push_back(FHDebugTile{ .m_pos = seg.m_originalAreaCentroid->m_pos, .m_text = std::to_string(seg.m_segmentIndex) });
@@ -503,7 +536,7 @@ void ZoneObjectDistributor::DistributionResult::init(TileZone& tileZone)
     m_segments.clear();
     for (size_t index = 0; auto& seg : tileZone.m_innerAreaSegments) {
         ZoneSegment zs;
-        zs.m_originalArea = seg.m_innerArea;
+        zs.m_originalArea = seg.getInnerArea();
         zs.m_originalArea.erase(safePadding);
         zs.m_originalArea.eraseExclaves(false);
 
@@ -582,6 +615,43 @@ void ZoneObjectDistributor::ZoneSegment::commitPlacement(DistributionResult& dis
     this->m_freeArea.erase(object->m_allArea);
 }
 
+void ZoneObjectDistributor::ZoneSegment::updateFreeOwners(TileOwnerGrid& freeOwners, const MapTileRegion& prevFree)
+{
+    freeOwners.set(prevFree, TileOwnerGrid::s_noOwner);
+    freeOwners.set(m_freeArea, getOwnerId());
+
+    if (m_freeArea.empty())
+        return;
+    m_freeMin = m_freeArea[0]->m_pos;
+    m_freeMax = m_freeArea[0]->m_pos;
+    for (auto* tile : m_freeArea) {
+        m_freeMin = FHPos{ std::min(m_freeMin.m_x, tile->m_pos.m_x), std::min(m_freeMin.m_y, tile->m_pos.m_y), m_freeMin.m_z };
+        m_freeMax = FHPos{ std::max(m_freeMax.m_x, tile->m_pos.m_x), std::max(m_freeMax.m_y, tile->m_pos.m_y), m_freeMax.m_z };
+    }
+}
+
+bool ZoneObjectDistributor::ZoneSegment::mayFit(const ZoneObjectWrap& object, MapTilePtr absPosCenter, const TileOwnerGrid& freeOwners) const
+{
+    // offset is unknown until first successful estimation.
+    if (object.m_centerOffset == g_invalidPos || object.m_footprintOffsets.empty())
+        return true;
+    const FHPos absPos = absPosCenter->m_pos - object.m_centerOffset;
+    if (absPos.m_x + object.m_footprintMin.m_x < m_freeMin.m_x || absPos.m_x + object.m_footprintMax.m_x > m_freeMax.m_x
+        || absPos.m_y + object.m_footprintMin.m_y < m_freeMin.m_y || absPos.m_y + object.m_footprintMax.m_y > m_freeMax.m_y)
+        return false;
+
+    MapTilePtr absTile = absPosCenter->neighbourByOffset(FHPos{} - object.m_centerOffset);
+    if (!absTile)
+        return false;
+    const uint32_t owner = getOwnerId();
+    for (FHPos offset : object.m_footprintOffsets) {
+        MapTilePtr tile = absTile->neighbourByOffset(offset);
+        if (!tile || freeOwners.get(tile) != owner)
+            return false;
+    }
+    return true;
+}
+
 void ZoneObjectDistributor::ZoneSegment::recalcHeat()
 {
     for (auto& [heat, data] : m_heatMap) {
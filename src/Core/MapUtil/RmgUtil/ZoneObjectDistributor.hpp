@@ -9,6 +9,9 @@
 
 #include "MapTileRegionWithEdge.hpp"
 #include "MapGuard.hpp"
+#include "TileOwnerGrid.hpp"
+
+#include "MapUtilExport.hpp"
 
 namespace FreeHeroes {
 
@@ -20,11 +23,13 @@ class IRandomGenerator;
 struct TileZone;
 struct FHMap;
 class MapTileContainer;
-struct ZoneObjectWrap : public ZoneObjectItem {
+struct MAPUTIL_EXPORT ZoneObjectWrap : public ZoneObjectItem {
     ZoneObjectWrap() = default;
     ZoneObjectWrap(const ZoneObjectItem& item)
         : ZoneObjectItem(item)
-    {}
+    {
+        initFootprint();
+    }
 
     enum class GuardPosition
     {
@@ -58,11 +63,18 @@ struct ZoneObjectWrap : public ZoneObjectItem {
 
     //MapTileRegion m_lastCellSource;
 
+    // object masks do not change after generation, so they are read once.
+    std::vector<FHPos> m_footprintOffsets;        // visitable, then blocked tiles, relative to m_absPos
+    size_t             m_footprintVisitCount = 0; // first offsets that are visitable
+    FHPos              m_footprintMin;
+    FHPos              m_footprintMax;
+
     int    m_placedHeat           = 0;
     size_t m_segmentIndex         = 0;
     size_t m_segmentFragmentIndex = 0;
     size_t m_estimatedArea        = 0;
 
+    void initFootprint();
     bool estimateOccupied(MapTilePtr absPosCenter);
 
     std::string toPrintableString() const;
@@ -97,7 +109,11 @@ public:
 
         size_t m_segmentIndex = 0;
 
-        int getFreePercent() const { return static_cast<int>(m_freeArea.size() * 100 / m_originalArea.size()); }
+        FHPos m_freeMin; // bounding box of m_freeArea
+        FHPos m_freeMax;
+
+        int      getFreePercent() const { return static_cast<int>(m_freeArea.size() * 100 / m_originalArea.size()); }
+        uint32_t getOwnerId() const { return static_cast<uint32_t>(m_segmentIndex + 1); }
 
         std::string toPrintableString() const;
 
@@ -106,6 +122,10 @@ public:
         void compactIfNeeded();
         void commitPlacement(DistributionResult& distribution, ZoneObjectWrap* object);
         void recalcHeat();
+        void updateFreeOwners(TileOwnerGrid& freeOwners, const MapTileRegion& prevFree);
+
+        // fast check that object footprint lies in free area; false means estimateOccupied() result won't fit for sure.
+        bool mayFit(const ZoneObjectWrap& object, MapTilePtr absPosCenter, const TileOwnerGrid& freeOwners) const;
 
         MapTilePtrList getTilesByDistance() const;
         MapTilePtrList getTilesByDistanceFrom(MapTilePtr tile) const;
@@ -130,6 +150,8 @@ public:
         ZoneObjectWrapList m_allObjects;
 
         ZoneSegmentList m_segments;
+        TileOwnerGrid   m_freeOwners;   // segment owner of free tiles
+        TileOwnerGrid   m_placedOwners; // object owner of committed tiles
         MapGuardList    m_guards;
         MapTileRegion   m_needBlock;
         MapTileRegion   m_allFreeCells;
@@ -164,7 +186,7 @@ public:
 
 private:
     bool placeWrapIntoSegments(DistributionResult& distribution, ZoneObjectWrap* object, std::vector<ZoneSegment*>& segCandidates) const;
-    void commitPlacement(DistributionResult& distribution, ZoneObjectWrap* object, MapTileRegion& placedTiles) const;
+    void commitPlacement(DistributionResult& distribution, ZoneObjectWrap* object) const;
     void makePreferredPoint(DistributionResult& distribution, ZoneObjectWrap* object, int angleStartOffset, size_t index, size_t count) const;
 
 private:
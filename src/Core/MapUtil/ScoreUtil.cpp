@@ -71,7 +71,7 @@ void estimateSpellListScore(const std::vector<Core::LibrarySpellConstPtr>& spell
         }
     }
     // make sure spell list is worth 150% of maximum value
-    for (auto& [attr, value] : score) {
+    for (auto&& [attr, value] : score) {
         value = value * 3 / 2;
     }
 }
@@ -3,12 +3,43 @@
  * SPDX-License-Identifier: MIT
  * See LICENSE file for details.
  */
+#include "RmgUtil/GuardUnitTable.hpp"
 #include "RmgUtil/MapTileContainer.hpp"
 #include "RmgUtil/MapTileRegionWithEdge.hpp"
 #include "RmgUtil/MapTileRegionSegmentation.hpp"
+#include "RmgUtil/ObstacleHelper.hpp"
+#include "RmgUtil/WeightedIndex.hpp"
+#include "RmgUtil/ZoneObjectDistributor.hpp"
+
+#include "FHMapObject.hpp"
+#include "FHTemplateProcessor.hpp"
+#include "FHTemplateStats.hpp"
+#include "FHTileMap.hpp"
+#include "H3M2FH.hpp"
+#include "LibraryUnit.hpp"
+#include "MapConverterFile.hpp"
+#include "MapConverter.hpp"
+#include "MapConverterBatch.hpp"
+#include "MapIndex.hpp"
+#include "ParallelChunks.hpp"
+
+#include "GameDatabaseContainer.hpp"
+#include "RandomGenerator.hpp"
+#include "ResourceLibraryFactory.hpp"
+
+#include "MernelPlatform/FileFormatJson.hpp"
+#include "MernelPlatform/FileIOUtils.hpp"
+#include "MernelPlatform/ByteOrderStream.hpp"
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <random>
+#include <sstream>
+#include <utility>
+
 using namespace FreeHeroes;
 
 struct CommonSegmentationParams {
@@ -455,6 +486,28 @@ TEST_P(KmeansTest, BasicSegmentation)
     ASSERT_EQ(m_objectRegion, m_calculatedSegmentsUnited);
 }
 
+TEST_P(KmeansTest, AcceleratedSameAsPlain)
+{
+    const auto& params = GetParam();
+    this->prepare(params);
+
+    m_reg.load(params.m_startPoints);
+    auto startPointRegions = m_reg.getList();
+
+    KMeansSegmentationSettings settings;
+    settings.m_items.resize(startPointRegions.size());
+    for (size_t i = 0; i < startPointRegions.size(); ++i)
+        settings.m_items[i].m_initialCentroid = startPointRegions[i][0];
+
+    for (size_t iterLimit : { 1, 2, 3, 100 }) {
+        settings.m_accelerated = false;
+        auto plain             = m_objectRegion.splitByKExt(settings, iterLimit);
+        settings.m_accelerated = true;
+        auto accelerated       = m_objectRegion.splitByKExt(settings, iterLimit);
+        ASSERT_EQ(plain, accelerated);
+    }
+}
+
 INSTANTIATE_TEST_SUITE_P(InstantiationName,
                          KmeansTest,
                          testing::ValuesIn(testParamsKmeans),
@@ -462,6 +515,76 @@ INSTANTIATE_TEST_SUITE_P(InstantiationName,
                              return info.param.m_id;
                          });
 
+GTEST_TEST(KmeansGrid, AcceleratedSameAsPlain)
+{
+    MapTileContainer tileContainer;
+    tileContainer.init(36, 36, 1);
+    auto settings = MapTileRegionSegmentation::guessKMeansByGrid(tileContainer.m_all, 4);
+    for (auto& item : settings.m_items)
+        item.m_areaHint = tileContainer.m_all.size() / 4;
+
+    settings.m_accelerated = false;
+    const auto plain       = tileContainer.m_all.splitByKExt(settings);
+    settings.m_accelerated = true;
+    const auto accelerated = tileContainer.m_all.splitByKExt(settings);
+    ASSERT_EQ(plain, accelerated);
+}
+
+// timing only, run explicitly with --gtest_also_run_disabled_tests.
+GTEST_TEST(KmeansBenchmark, DISABLED_AcceleratedVsPlain)
+{
+    struct Case {
+        std::string                m_id;
+        MapTileRegion              m_region;
+        KMeansSegmentationSettings m_settings;
+    };
+    std::vector<Case> cases;
+
+    std::vector<MapTileContainer> containers(testParamsKmeans.size() + 1);
+    for (size_t i = 0; const auto& params : testParamsKmeans) {
+        auto& tileContainer = containers[i++];
+        tileContainer.init(params.m_width, params.m_height, 1);
+
+        MergedRegion reg;
+        reg.initFromTileContainer(&tileContainer, 0);
+        reg.load(params.m_object);
+        Case c{ params.m_id, reg.m_regions['O'], {} };
+
+        reg.load(params.m_startPoints);
+        for (const auto& startPoint : reg.getList())
+            c.m_settings.m_items.push_back({ .m_initialCentroid = startPoint[0] });
+        cases.push_back(std::move(c));
+    }
+    {
+        // something close to zone segmentation of XL map.
+        auto& tileContainer = containers.back();
+        tileContainer.init(144, 144, 1);
+        Case c{ "xl", tileContainer.m_all, MapTileRegionSegmentation::guessKMeansByGrid(tileContainer.m_all, 16) };
+        for (auto& item : c.m_settings.m_items)
+            item.m_areaHint = tileContainer.m_all.size() / 16;
+        cases.push_back(std::move(c));
+    }
+
+    for (auto& c : cases) {
+        const int repeats = c.m_region.size() > 1000 ? 3 : 100;
+        auto      measure = [&c, repeats](bool accelerated, MapTileRegionList& result) {
+            c.m_settings.m_accelerated = accelerated;
+            const auto start           = std::chrono::steady_clock::now();
+            for (int i = 0; i < repeats; ++i)
+                result = c.m_region.splitByKExt(c.m_settings);
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / repeats;
+        };
+
+        MapTileRegionList plain, accelerated;
+        const auto        plainUs       = measure(false, plain);
+        const auto        acceleratedUs = measure(true, accelerated);
+        RecordProperty(c.m_id + "_plainUs", std::to_string(plainUs));
+        RecordProperty(c.m_id + "_acceleratedUs", std::to_string(acceleratedUs));
+
+        ASSERT_EQ(plain, accelerated);
+    }
+}
+
 // -----------------------------------------------------------------------------------------------------------
 // --------------------------------          creating Grids               ------------------------------------
 // -----------------------------------------------------------------------------------------------------------
@@ -914,3 +1037,1222 @@ GTEST_TEST(GridDetection, Basic2)
 
     ASSERT_NO_THROW(objectRegion.splitByKExt(settings));
 }
+
+GTEST_TEST(ObstacleFitTest, BitmaskSameAsCellwise)
+{
+    std::mt19937_64 rng(42);
+
+    ObstacleBitGrid grid;
+    grid.init(70, 20); // crosses 64-bit word boundary
+    for (size_t y = 0; y < grid.m_height; ++y)
+        for (size_t x = 0; x < grid.m_width; ++x)
+            grid.set(x, y, static_cast<uint8_t>(rng() % 3));
+
+    for (int i = 0; i < 200; ++i) {
+        Core::PlanarMask mask;
+        mask.m_width  = 1 + rng() % ObstacleBitGrid::s_windowWidth;
+        mask.m_height = 1 + rng() % ObstacleBitGrid::s_windowHeight;
+        mask.m_rows.resize(mask.m_height);
+        for (auto& row : mask.m_rows) {
+            row.resize(mask.m_width);
+            for (auto& cell : row)
+                cell = rng() % 4 != 0;
+        }
+        ObstacleBucket bucket;
+        bucket.setMask(mask);
+        ASSERT_TRUE(bucket.m_packed);
+
+        for (size_t y = 0; y < grid.m_height; ++y) {
+            for (size_t x = 0; x < grid.m_width; ++x) {
+                const auto window = grid.getWindow(x, y);
+                ASSERT_EQ(bucket.isFit(window), bucket.isFitCellwise(grid, x, y)) << "mask=" << i << " x=" << x << " y=" << y;
+            }
+        }
+    }
+}
+
+GTEST_TEST(ObstacleFitTest, IndexSameAsFullScan)
+{
+    std::mt19937_64 rng(43);
+
+    ObstacleBitGrid grid;
+    grid.init(30, 20);
+    for (size_t y = 0; y < grid.m_height; ++y)
+        for (size_t x = 0; x < grid.m_width; ++x)
+            grid.set(x, y, static_cast<uint8_t>(rng() % 3));
+
+    ObstacleIndex index;
+    for (int i = 0; i < 300; ++i) {
+        Core::PlanarMask mask;
+        // some masks are bigger than lookup window.
+        mask.m_width  = 1 + rng() % (ObstacleBitGrid::s_windowWidth + 1);
+        mask.m_height = 1 + rng() % (ObstacleBitGrid::s_windowHeight + 1);
+        mask.m_rows.resize(mask.m_height);
+        for (auto& row : mask.m_rows) {
+            row.resize(mask.m_width);
+            for (auto& cell : row)
+                cell = rng() % 3 != 0;
+        }
+        ObstacleBucket bucket;
+        bucket.setMask(mask);
+        index.m_bucketLists.push_back(std::move(bucket));
+    }
+    index.doSort();
+
+    for (size_t y = 0; y < grid.m_height; ++y) {
+        for (size_t x = 0; x < grid.m_width; ++x) {
+            const auto                         window = grid.getWindow(x, y);
+            std::vector<const ObstacleBucket*> expected;
+            for (const ObstacleBucket& bucket : index.m_bucketLists) {
+                if (bucket.m_packed ? bucket.isFit(window) : bucket.isFitCellwise(grid, x, y))
+                    expected.push_back(&bucket);
+            }
+            ASSERT_EQ(index.find(grid, window, x, y), expected) << "x=" << x << " y=" << y;
+        }
+    }
+}
+
+GTEST_TEST(MapScoreTest, SameAsStdMap)
+{
+    using RefScore = std::map<Core::ScoreAttr, int64_t>;
+    std::mt19937_64 rng(7);
+
+    auto randomScore = [&rng](Core::MapScore& score, RefScore& ref) {
+        const size_t count = rng() % 5;
+        for (size_t i = 0; i < count; ++i) {
+            const auto    attr  = static_cast<Core::ScoreAttr>(rng() % Core::MapScore::s_size);
+            const int64_t value = static_cast<int64_t>(rng() % 5) - 1;
+            score[attr]         = value;
+            ref[attr]           = value;
+        }
+    };
+    auto toRef = [](const Core::MapScore& score) {
+        RefScore result;
+        for (const auto& [attr, value] : score)
+            result[attr] = value;
+        return result;
+    };
+
+    for (int i = 0; i < 1000; ++i) {
+        Core::MapScore l, r;
+        RefScore       lRef, rRef;
+        randomScore(l, lRef);
+        randomScore(r, rRef);
+        ASSERT_EQ(toRef(l), lRef);
+        ASSERT_EQ(l.size(), lRef.size());
+
+        RefScore sumRef = lRef;
+        for (const auto& [key, val] : rRef)
+            sumRef[key] += val;
+        ASSERT_EQ(toRef(l + r), sumRef);
+
+        RefScore diffRef = lRef;
+        for (const auto& [key, val] : rRef) {
+            diffRef[key] -= val;
+            if (!diffRef[key])
+                diffRef.erase(key);
+        }
+        ASSERT_EQ(toRef(l - r), diffRef);
+
+        bool overflowRef = false;
+        for (const auto& [key, val] : lRef)
+            overflowRef = overflowRef || !rRef.contains(key) || val > rRef.at(key);
+        ASSERT_EQ(l.isOverflow(r), overflowRef);
+
+        int64_t totalRef = 0, maxRef = 0;
+        for (const auto& [key, val] : lRef) {
+            totalRef += val;
+            maxRef = std::max(maxRef, val);
+        }
+        ASSERT_EQ(totalScoreValue(l), totalRef);
+        ASSERT_EQ(maxScoreValue(l), maxRef);
+    }
+}
+
+GTEST_TEST(WeightedIndexTest, SameAsLinearScan)
+{
+    std::mt19937_64 rng(3);
+    for (size_t size = 1; size < 40; ++size) {
+        WeightedIndex         index;
+        std::vector<uint64_t> weights(size);
+        index.reset(size);
+        for (int i = 0; i < 50; ++i) {
+            const size_t pos = rng() % size;
+            weights[pos]     = rng() % 3 == 0 ? 0 : rng() % 10;
+            index.setWeight(pos, weights[pos]);
+
+            uint64_t total = 0;
+            for (uint64_t w : weights)
+                total += w;
+            ASSERT_EQ(index.total(), total);
+
+            for (uint64_t value = 1; value <= total + 1; ++value) {
+                size_t   expected = 0;
+                uint64_t sum      = 0;
+                for (; expected < size; ++expected) {
+                    sum += weights[expected];
+                    if (sum >= value)
+                        break;
+                }
+                ASSERT_EQ(index.lowerBound(value), expected);
+            }
+        }
+    }
+}
+
+GTEST_TEST(MapTileRegionTest, EdgeSameAsNaive)
+{
+    std::mt19937_64 rng(42);
+
+    MapTileContainer tileContainer;
+    tileContainer.init(20, 15, 2);
+
+    for (int i = 0; i < 100; ++i) {
+        MapTileRegion region;
+        const int     density = 1 + rng() % 4;
+        for (auto* tile : tileContainer.m_all) {
+            if (static_cast<int>(rng() % 5) < density)
+                region.insert(tile);
+        }
+        for (bool useDiag : { false, true }) {
+            MapTileRegion inner, outer, center;
+            for (auto* tile : region) {
+                bool isCenter = true;
+                for (auto* ntile : tile->neighboursList(useDiag))
+                    isCenter = isCenter && region.contains(ntile);
+                if (tile->neighboursList(useDiag).size() < (useDiag ? 8u : 4u))
+                    isCenter = false;
+                if (isCenter) {
+                    center.insert(tile);
+                    continue;
+                }
+                inner.insert(tile);
+                for (auto* ntile : tile->neighboursList(useDiag)) {
+                    if (!region.contains(ntile))
+                        outer.insert(ntile);
+                }
+            }
+            const auto result = region.makeInnerAndOuterEdge({ .m_useDiag = useDiag, .m_makeInner = true, .m_makeOuter = true, .m_makeCenter = true });
+            ASSERT_EQ(result.m_inner, inner) << "region=" << i << " diag=" << useDiag;
+            ASSERT_EQ(result.m_outer, outer) << "region=" << i << " diag=" << useDiag;
+            ASSERT_EQ(result.m_center, center) << "region=" << i << " diag=" << useDiag;
+        }
+    }
+}
+
+GTEST_TEST(MapTileRegionTest, LabelsSameAsFloodFill)
+{
+    std::mt19937_64 rng(42);
+
+    MapTileContainer tileContainer;
+    tileContainer.init(20, 15, 2);
+
+    for (int i = 0; i < 100; ++i) {
+        MapTileRegion region;
+        const int     density = 1 + rng() % 4;
+        for (auto* tile : tileContainer.m_all) {
+            if (static_cast<int>(rng() % 5) < density)
+                region.insert(tile);
+        }
+        const MapTilePtr hint = region[rng() % region.size()];
+        for (bool useDiag : { false, true }) {
+            MapTileRegionList expected;
+            MapTileRegion     remain = region;
+            MapTilePtr        start  = hint;
+            while (!remain.empty()) {
+                MapTileRegion  part;
+                MapTilePtrList edge{ start ? start : *remain.begin() };
+                start = nullptr;
+                part.insert(edge[0]);
+                while (!edge.empty()) {
+                    MapTilePtrList next;
+                    for (auto* tile : edge) {
+                        for (auto* ntile : tile->neighboursList(useDiag)) {
+                            if (remain.contains(ntile) && !part.contains(ntile)) {
+                                part.insert(ntile);
+                                next.push_back(ntile);
+                            }
+                        }
+                    }
+                    edge = std::move(next);
+                }
+                remain.erase(part);
+                expected.push_back(std::move(part));
+            }
+            ASSERT_EQ(region.splitByFloodFill(useDiag, hint), expected) << "region=" << i << " diag=" << useDiag;
+
+            MapTileRegion exclavesErased = region;
+            exclavesErased.eraseExclaves(useDiag);
+            auto largest = std::max_element(expected.begin(), expected.end(), [](const MapTileRegion& l, const MapTileRegion& r) {
+                return std::tuple{ l.size(), l[0] } < std::tuple{ r.size(), r[0] };
+            });
+            ASSERT_EQ(exclavesErased, *largest) << "region=" << i << " diag=" << useDiag;
+        }
+    }
+}
+
+namespace {
+struct FakeZoneObject : public IZoneObject {
+    Mask m_visit;
+    Mask m_blocked;
+
+    void           place(FHPos) const override {}
+    Core::MapScore getScore() const override { return {}; }
+    void           setAccepted(bool) override {}
+    std::string    getId() const override { return "fake"; }
+    int64_t        getGuard() const override { return 0; }
+    Type           getType() const override { return Type::Visitable; }
+
+    Mask getVisitableMask() const override { return m_visit; }
+    Mask getBlockedUnvisitableMask() const override { return m_blocked; }
+};
+}
+
+GTEST_TEST(ZoneObjectWrapTest, FootprintSameAsMasks)
+{
+    MapTileContainer container;
+    container.init(12, 10, 1);
+
+    auto object       = std::make_shared<FakeZoneObject>();
+    object->m_visit   = { FHPos(0, 0) };
+    object->m_blocked = { FHPos(-1, 0), FHPos(-2, 0), FHPos(-1, -1), FHPos(0, -1) };
+
+    ZoneObjectItem item;
+    item.m_object    = object;
+    item.m_useGuards = false;
+
+    ZoneObjectWrap wrap(item);
+    EXPECT_EQ(wrap.m_footprintVisitCount, 1);
+    EXPECT_EQ(wrap.m_footprintMin, FHPos(-2, -1, 0));
+    EXPECT_EQ(wrap.m_footprintMax, FHPos(0, 0, 0));
+
+    // same regions as building them from masks on every call, before and after center offset is known.
+    for (int pass = 0; pass < 2; ++pass) {
+        for (MapTilePtr center : container.m_all) {
+            MapTilePtr absPos = center;
+            if (wrap.m_centerOffset != g_invalidPos)
+                absPos = center->neighbourByOffset(FHPos{} - wrap.m_centerOffset);
+
+            MapTileRegion expected;
+            bool          allInside = absPos != nullptr;
+            for (const auto& mask : { object->m_visit, object->m_blocked }) {
+                for (FHPos offset : mask) {
+                    MapTilePtr tile = absPos ? absPos->neighbourByOffset(offset) : nullptr;
+                    allInside       = allInside && tile;
+                    if (tile)
+                        expected.insert(tile);
+                }
+            }
+            bool noEdge = true;
+            for (MapTilePtr tile : expected)
+                noEdge = noEdge && tile->m_orthogonalNeighbours.size() == 4;
+
+            ZoneObjectWrap fresh(item);
+            fresh.m_centerOffset = wrap.m_centerOffset;
+            ASSERT_EQ(fresh.estimateOccupied(center), allInside && noEdge) << center->toPrintableString();
+            if (allInside)
+                ASSERT_EQ(fresh.m_rewardArea, expected) << center->toPrintableString();
+        }
+        ASSERT_TRUE(wrap.estimateOccupied(container.m_centerTile));
+    }
+}
+
+GTEST_TEST(MapTileContainerTest, CopyRemapsTiles)
+{
+    MapTileContainer original;
+    original.init(7, 5, 2);
+    const MapTileContainer copy = original;
+
+    ASSERT_EQ(copy.m_all.size(), original.m_all.size());
+    for (size_t i = 0; i < copy.m_all.size(); ++i) {
+        MapTilePtr tile = copy.m_all[i];
+        ASSERT_EQ(tile->m_pos, original.m_all[i]->m_pos);
+        ASSERT_EQ(tile->m_container, &copy);
+        ASSERT_EQ(tile->m_self, tile);
+        ASSERT_EQ(copy.find(tile->m_pos), tile);
+        for (auto* ntile : tile->neighboursList(true)) {
+            ASSERT_TRUE(copy.m_all.contains(ntile));
+            ASSERT_EQ(posDistance(tile->m_pos, ntile->m_pos, 100), posDistance(original.m_all[i]->m_pos, original.find(ntile->m_pos)->m_pos, 100));
+        }
+        if (tile->m_neighborBR)
+            ASSERT_EQ(tile->m_neighborBR->m_pos, original.m_all[i]->m_neighborBR->m_pos);
+    }
+    ASSERT_EQ(copy.m_innerEdge.size(), original.m_innerEdge.size());
+    for (size_t i = 0; i < copy.m_innerEdge.size(); ++i) {
+        ASSERT_TRUE(copy.m_all.contains(copy.m_innerEdge[i]));
+        ASSERT_EQ(copy.m_innerEdge[i]->m_pos, original.m_innerEdge[i]->m_pos);
+    }
+    ASSERT_EQ(copy.m_centerTile->m_pos, original.m_centerTile->m_pos);
+}
+
+GTEST_TEST(FHTileMapTest, PackRoundTrip)
+{
+    Core::LibraryTerrain grass, snow;
+
+    FHTileMap map;
+    map.m_width  = 4;
+    map.m_height = 3;
+    map.m_depth  = 2;
+    map.updateSize();
+    // snow gets into terrain list first, but packed list follows tile order.
+    map.get(1, 2, 1).m_terrainId = &snow;
+    for (size_t i = 0; i < map.totalSize(); ++i) {
+        auto tile = map.getByIndex(i);
+        if (!tile.m_terrainId)
+            tile.m_terrainId = &grass;
+        tile.m_terrainView.m_view    = static_cast<uint8_t>(i);
+        tile.m_terrainView.m_flipHor = i % 3 == 0;
+        tile.m_coastal               = i % 5 == 0;
+    }
+    map.get(2, 1, 0).m_roadType             = FHRoadType::Gravel;
+    map.get(2, 1, 0).m_roadView.m_view      = 7;
+    map.get(3, 0, 1).m_riverType            = FHRiverType::Lava;
+    map.get(3, 0, 1).m_riverView.m_flipVert = true;
+
+    FHPackedTileMap packed;
+    packed.packFromMap(map);
+    ASSERT_EQ(packed.m_terrains, (std::vector<Core::LibraryTerrainConstPtr>{ &grass, &snow }));
+
+    FHTileMap unpacked;
+    unpacked.m_width  = map.m_width;
+    unpacked.m_height = map.m_height;
+    unpacked.m_depth  = map.m_depth;
+    unpacked.updateSize();
+    packed.unpackToMap(unpacked);
+
+    for (size_t i = 0; i < map.totalSize(); ++i) {
+        const FHTileMap::Tile expected = std::as_const(map).getByIndex(i);
+        const FHTileMap::Tile actual   = std::as_const(unpacked).getByIndex(i);
+        EXPECT_EQ(actual.m_terrainId, expected.m_terrainId) << i;
+        EXPECT_EQ(actual.m_terrainView.m_view, expected.m_terrainView.m_view) << i;
+        EXPECT_EQ(actual.m_terrainView.m_flipHor, expected.m_terrainView.m_flipHor) << i;
+        EXPECT_EQ(actual.m_coastal, expected.m_coastal) << i;
+        EXPECT_EQ(actual.m_roadType, expected.m_roadType) << i;
+        EXPECT_EQ(actual.m_roadView.m_view, expected.m_roadView.m_view) << i;
+        EXPECT_EQ(actual.m_riverType, expected.m_riverType) << i;
+        EXPECT_EQ(actual.m_riverView.m_flipVert, expected.m_riverView.m_flipVert) << i;
+    }
+}
+
+GTEST_TEST(GuardUnitTableTest, SameAsFullScan)
+{
+    std::mt19937_64                        rng(7);
+    std::vector<Core::LibraryUnit>         units(120);
+    std::vector<Core::LibraryUnitConstPtr> unitPtrs;
+    for (auto& unit : units) {
+        unit.level        = 10 * (1 + rng() % 7) + rng() % 2;
+        unit.value        = 10 + rng() % 4000;
+        unit.guardMult1   = 80 + rng() % 50;
+        unit.guardMult100 = 80 + rng() % 50;
+        unitPtrs.push_back(&unit);
+    }
+    GuardUnitTable table;
+    table.init(unitPtrs);
+
+    // plain scan over all units in their order.
+    auto makeCandidates = [&unitPtrs](int64_t value) {
+        std::map<int, int> unitLevelScore;
+        for (auto* unit : unitPtrs) {
+            const int count = GuardUnitTable::getPossibleCount(unit, value);
+            if (count < 5 || (count < 10 && unit->level < 50))
+                continue;
+            const int score = count < 10 ? 1 : count < 25 ? 2 : count < 35 ? 5 : count < 50 ? 3 : count < 100 ? 2 : 1;
+            unitLevelScore[unit->level / 10] += score;
+        }
+        std::vector<Core::LibraryUnitConstPtr> result;
+        if (unitLevelScore.empty())
+            return result;
+        const int optimalLevel = std::max_element(unitLevelScore.begin(), unitLevelScore.end(), [](auto l, auto r) { return l.second < r.second; })->first;
+        for (auto* unit : unitPtrs) {
+            const int count = GuardUnitTable::getPossibleCount(unit, value);
+            if (count < 5 || (count < 10 && unit->level < 50))
+                continue;
+            const int levelDiff = unit->level / 10 - optimalLevel;
+            if (levelDiff < -1 || levelDiff > 2 || (unit->level < 80 && count >= 100))
+                continue;
+            result.push_back(unit);
+        }
+        return result;
+    };
+
+    for (int i = 0; i < 2000; ++i) {
+        const int64_t value = rng() % 2 ? rng() % 20000 : rng() % 1000000;
+        ASSERT_EQ(table.makeCandidates(value), makeCandidates(value)) << value;
+    }
+}
+
+GTEST_TEST(MapConverterFileTest, BinaryPropertyRoundTrip)
+{
+    using namespace Mernel;
+    MapConverterFile file;
+    file.m_json["name"]   = PropertyTreeScalar(std::string("map"));
+    file.m_json["width"]  = PropertyTreeScalar(int64_t(144));
+    file.m_json["scale"]  = PropertyTreeScalar(0.25);
+    file.m_json["hidden"] = PropertyTreeScalar(false);
+    file.m_json["empty"]  = PropertyTree{};
+    auto& objects         = file.m_json["objects"];
+    objects.convertToList();
+    for (int i = 0; i < 3; ++i) {
+        PropertyTree item;
+        item["id"]    = PropertyTreeScalar(std::string("map")); // repeated strings share one table entry
+        item["index"] = PropertyTreeScalar(int64_t(-i));
+        objects.append(std::move(item));
+    }
+    const std::string expected = writeJsonToBuffer(file.m_json);
+
+    file.writeBinaryFromPropertyToBuffer();
+    file.m_json = {};
+    file.readBinaryToPropertyFromBuffer();
+
+    EXPECT_EQ(writeJsonToBuffer(file.m_json), expected);
+}
+
+GTEST_TEST(MapConverterFileTest, BinaryPropertyMalformed)
+{
+    using namespace Mernel;
+    auto makeBuffer = [](uint32_t stringCount, auto&& writeNodes) {
+        MapConverterFile          file;
+        ByteOrderBuffer           bobuffer(file.m_binaryBuffer);
+        ByteOrderDataStreamWriter writer(bobuffer, ByteOrderDataStream::s_littleEndian);
+        writer << std::array<uint8_t, 4>{ { 0x46, 0x48, 0x50, 0x54 } } << uint32_t(1) << stringCount;
+        writeNodes(writer);
+        file.m_rawState = MapConverterFile::RawState::Uncompressed;
+        return file;
+    };
+    // counts far above what is left in buffer must fail before allocation.
+    {
+        auto file = makeBuffer(0xFFFFFFFFU, [](auto&) {});
+        EXPECT_THROW(file.readBinaryToPropertyFromBuffer(), std::runtime_error);
+    }
+    {
+        auto file = makeBuffer(0, [](auto& writer) { writer << uint8_t(6) << uint32_t(1000000000); }); // List
+        EXPECT_THROW(file.readBinaryToPropertyFromBuffer(), std::runtime_error);
+    }
+    {
+        auto file = makeBuffer(0, [](auto& writer) { writer << uint8_t(7) << uint32_t(1000000000); }); // Map
+        EXPECT_THROW(file.readBinaryToPropertyFromBuffer(), std::runtime_error);
+    }
+    // well-formed but too deep.
+    {
+        MapConverterFile file;
+        for (int i = 0; i < 1000; ++i) {
+            PropertyTree parent;
+            parent.convertToList();
+            parent.append(std::move(file.m_json));
+            file.m_json = std::move(parent);
+        }
+        file.writeBinaryFromPropertyToBuffer();
+        EXPECT_THROW(file.readBinaryToPropertyFromBuffer(), std::runtime_error);
+    }
+}
+
+GTEST_TEST(MapConverterFileTest, JsonStreamRoundTrip)
+{
+    using namespace Mernel;
+    MapConverterFile file;
+    file.m_filename       = std_fs::temp_directory_path() / "fh_json_stream_test.json";
+    file.m_json["name"]   = PropertyTreeScalar(std::string("quote \" slash \\ line\n tab\t"));
+    file.m_json["width"]  = PropertyTreeScalar(int64_t(-144));
+    file.m_json["scale"]  = PropertyTreeScalar(2.0);
+    file.m_json["hidden"] = PropertyTreeScalar(true);
+    file.m_json["empty"]  = PropertyTree{};
+    file.m_json["list"].convertToList();
+    file.m_json["list"].append(PropertyTreeScalar(0.125));
+    for (int i = 0; i < 3; ++i) {
+        PropertyTree item;
+        item["pos"].convertToList();
+        item["pos"].append(PropertyTreeScalar(int64_t(i)));
+        item["id"] = PropertyTreeScalar(std::string("obj ") + char('a' + i));
+        file.m_json["objects"].convertToList();
+        file.m_json["objects"].append(std::move(item));
+    }
+    file.m_json["emptyList"].convertToList();
+    file.m_json["emptyMap"].convertToMap();
+    const std::string expected = writeJsonToBuffer(file.m_json);
+
+    file.writeJsonFromProperty();
+    EXPECT_EQ(readFileIntoBuffer(file.m_filename), expected);
+    file.m_json = {};
+    file.readJsonToProperty();
+    std_fs::remove(file.m_filename);
+
+    EXPECT_EQ(writeJsonToBuffer(file.m_json), expected);
+}
+
+GTEST_TEST(MapConverterFileTest, JsonStreamReadPretty)
+{
+    using namespace Mernel;
+    MapConverterFile file;
+    file.m_filename = std_fs::temp_directory_path() / "fh_json_stream_pretty_test.json";
+    writeFileFromBuffer(file.m_filename,
+                        "\xEF\xBB\xBF{\n"
+                        "    \"name\": \"caf\\u00e9 \\u4E2D \\ud83d\\ude00 \\/\",\n"
+                        "    \"list\": [\n"
+                        "        1,\n"
+                        "        -0,\n"
+                        "        2.5e3,\n"
+                        "        -0.125,\n"
+                        "        { \"a\": null, \"b\": false }\n"
+                        "    ],\n"
+                        "    \"empty\" : { }\r\n"
+                        "}\n");
+    file.readJsonToProperty();
+    std_fs::remove(file.m_filename);
+
+    EXPECT_EQ(file.m_json["name"].getScalar().toString(), "caf\xC3\xA9 \xE4\xB8\xAD \xF0\x9F\x98\x80 /");
+    const auto& list = file.m_json["list"].getList();
+    ASSERT_EQ(list.size(), 5U);
+    EXPECT_EQ(list[0].getScalar().toInt(), 1);
+    EXPECT_EQ(list[1].getScalar().toInt(), 0);
+    EXPECT_EQ(list[2].getScalar().toDouble(), 2500.0);
+    EXPECT_EQ(list[3].getScalar().toDouble(), -0.125);
+    EXPECT_EQ(writeJsonToBuffer(list[4]["a"]), writeJsonToBuffer(PropertyTree{}));
+    EXPECT_FALSE(list[4]["b"].getScalar().toBool());
+    EXPECT_TRUE(file.m_json["empty"].isMap());
+}
+
+GTEST_TEST(MapConverterFileTest, JsonStreamMalformed)
+{
+    using namespace Mernel;
+    MapConverterFile file;
+    file.m_filename = std_fs::temp_directory_path() / "fh_json_stream_malformed_test.json";
+    auto parse      = [&file](const std::string& text) {
+        writeFileFromBuffer(file.m_filename, text);
+        file.readJsonToProperty();
+    };
+    for (std::string text : { "0", "-0.5e-3", "[1E+2, 10, 0.0]", "\"\\u0041\"" })
+        EXPECT_NO_THROW(parse(text)) << text;
+
+    for (std::string text : { "", "01", "-01", "-", "+1", "1.", ".5", "1e", "1e+", "0x10", "[1,]", "[1 2]", "{\"a\":1,}", "{a:1}",
+                              "\"abc", "\"\\x\"", "\"\\ud800\"", "\"\\ud800\\u0041\"", "tru", "nul", "[1] x", "\xEF\xBB" })
+        EXPECT_THROW(parse(text), std::runtime_error) << text;
+
+    EXPECT_NO_THROW(parse(std::string(500, '[') + std::string(500, ']')));
+    EXPECT_THROW(parse(std::string(100000, '[') + std::string(100000, ']')), std::runtime_error);
+    std_fs::remove(file.m_filename);
+}
+
+GTEST_TEST(MapIndexTest, EntryJsonRoundTrip)
+{
+    MapIndexEntry entry{
+        .m_path             = "maps/test.h3m",
+        .m_mtime            = 1234567890123,
+        .m_fileSize         = 4096,
+        .m_format           = "SOD",
+        .m_name             = "Test",
+        .m_width            = 72,
+        .m_height           = 72,
+        .m_depth            = 2,
+        .m_players          = 4,
+        .m_humanPlayers     = 2,
+        .m_victoryCondition = "WINSTANDARD",
+        .m_lossCondition    = "LOSSSTANDARD",
+        .m_thumbnail        = std::string(MapIndex::s_thumbnailSize * MapIndex::s_thumbnailSize, '2'),
+    };
+    Mernel::PropertyTree json;
+    entry.toJson(json);
+    MapIndexEntry loaded;
+    loaded.fromJson(json);
+
+    EXPECT_EQ(loaded.m_path, entry.m_path);
+    EXPECT_EQ(loaded.m_mtime, entry.m_mtime);
+    EXPECT_EQ(loaded.m_fileSize, entry.m_fileSize);
+    EXPECT_EQ(loaded.m_name, entry.m_name);
+    EXPECT_EQ(loaded.m_depth, entry.m_depth);
+    EXPECT_EQ(loaded.m_humanPlayers, entry.m_humanPlayers);
+    EXPECT_EQ(loaded.m_lossCondition, entry.m_lossCondition);
+    EXPECT_EQ(loaded.m_thumbnail, entry.m_thumbnail);
+    EXPECT_TRUE(loaded.m_error.empty());
+}
+
+GTEST_TEST(MapIndexTest, UpdateParsesOnlyChangedFiles)
+{
+    const Mernel::std_path root = Mernel::std_fs::temp_directory_path() / "fh_map_index_test";
+    Mernel::std_fs::remove_all(root);
+    Mernel::std_fs::create_directories(root / "sub");
+
+    auto writeMap = [&root](const std::string& relPath, const std::string& name) {
+        Mernel::writeFileFromBuffer(root / relPath, R"({"format":"HOTA3","name":")" + name + R"(","tileMap":{"width":36,"height":36,"depth":1}})");
+    };
+    auto paths = [](const std::vector<MapIndexEntry>& entries) {
+        std::vector<std::string> result;
+        for (const auto& entry : entries)
+            result.push_back(entry.m_path);
+        return result;
+    };
+    const std::string subMap = Mernel::path2string(Mernel::string2path("sub") / "b.fh.json");
+
+    writeMap("a.fh.json", "A");
+    writeMap(subMap, "B");
+    Mernel::writeFileFromBuffer(root / "broken.fh.json", "{}");
+    Mernel::writeFileFromBuffer(root / "template.json", "{}"); // not a map name
+    Mernel::writeFileFromBuffer(root / "archive_index.fh.json", "{}"); // legacy converter index, not a map
+
+    MapIndex index;
+    EXPECT_EQ(index.update(root, 2), 3);
+    EXPECT_EQ(paths(index.m_entries), (std::vector<std::string>{ "a.fh.json", subMap }));
+    EXPECT_EQ(paths(index.m_failed), (std::vector<std::string>{ "broken.fh.json" }));
+    EXPECT_EQ(index.m_entries[1].m_name, "B");
+
+    // nothing changed, broken file is not retried either.
+    EXPECT_EQ(index.update(root, 2), 0);
+
+    // index survives save and load.
+    const Mernel::std_path indexFile = root / ".fhmapindex";
+    index.save(indexFile);
+    MapIndex loaded;
+    loaded.load(indexFile);
+    EXPECT_EQ(paths(loaded.m_entries), paths(index.m_entries));
+    EXPECT_EQ(paths(loaded.m_failed), paths(index.m_failed));
+
+    // size differs, so change is detected regardless of timestamp resolution.
+    writeMap(subMap, "B changed");
+    writeMap("c.fh.json", "C");
+    Mernel::std_fs::remove(root / "a.fh.json");
+    EXPECT_EQ(loaded.update(root, 2), 2);
+    EXPECT_EQ(paths(loaded.m_entries), (std::vector<std::string>{ "c.fh.json", subMap }));
+    EXPECT_EQ(loaded.m_entries[1].m_name, "B changed");
+    EXPECT_EQ(paths(loaded.m_failed), (std::vector<std::string>{ "broken.fh.json" }));
+
+    Mernel::std_fs::remove_all(root);
+}
+
+GTEST_TEST(TemplateStatsTest, PercentilesAndOutliers)
+{
+    FHTemplateStatsAggregator aggregator;
+    // seed N gives value N, and single far-out value.
+    for (uint64_t seed = 1; seed <= 100; ++seed)
+        aggregator.addSample("metric", static_cast<int64_t>(seed), seed);
+    aggregator.addSample("metric", 1000, 101);
+    // more samples than reservoir holds; exact values must stay exact.
+    for (int64_t value = 0; value < 10000; ++value)
+        aggregator.addSample("big", value % 2 ? value : -value, 1);
+    aggregator.addFailure(5, "oops");
+    aggregator.addFailure(6, "oops");
+
+    Mernel::PropertyTree data;
+    aggregator.toJson(data);
+    auto scalar = [](const Mernel::PropertyTree& tree) { return tree.getScalar().toInt(); };
+
+    EXPECT_EQ(scalar(data["runs"]), 2);
+    EXPECT_EQ(scalar(data["failed"]), 2);
+    EXPECT_EQ(scalar(data["failures"].getList()[0]["count"]), 2);
+
+    Mernel::PropertyTree& metric = data["metrics"]["metric"];
+    EXPECT_EQ(scalar(metric["count"]), 101);
+    EXPECT_EQ(scalar(metric["min"]), 1);
+    EXPECT_EQ(scalar(metric["max"]), 1000);
+    EXPECT_EQ(scalar(metric["p5"]), 6);
+    EXPECT_EQ(scalar(metric["p25"]), 26);
+    EXPECT_EQ(scalar(metric["p50"]), 51);
+    EXPECT_EQ(scalar(metric["p75"]), 76);
+    EXPECT_EQ(scalar(metric["p95"]), 96);
+    EXPECT_EQ(scalar(metric["p99"]), 100);
+    // fences are 26 - 3*50 and 76 + 3*50.
+    ASSERT_EQ(metric["outliers"].getList().size(), 1);
+    EXPECT_EQ(scalar(metric["outliers"].getList()[0]["seed"]), 101);
+    EXPECT_EQ(scalar(metric["outliers"].getList()[0]["value"]), 1000);
+
+    Mernel::PropertyTree& big = data["metrics"]["big"];
+    EXPECT_EQ(scalar(big["count"]), 10000);
+    EXPECT_EQ(scalar(big["min"]), -9998);
+    EXPECT_EQ(scalar(big["max"]), 9999);
+}
+
+// -----------------------------------------------------------------------------------------------------------
+// --------------------------------         maps generated from template         -----------------------------
+// -----------------------------------------------------------------------------------------------------------
+
+namespace {
+
+// json databases of gameResources are enough for generation; tests needing them are skipped if loading fails.
+const Core::IGameDatabaseContainer* getTestDatabaseContainer()
+{
+    struct Environment {
+        Core::IResourceLibrary::ConstPtr                    m_resourceLibrary;
+        std::shared_ptr<const Core::IGameDatabaseContainer> m_databaseContainer;
+    };
+    static const Environment s_environment = [] {
+        Core::ResourceLibraryFactory factory;
+        factory.scanForMods(Mernel::string2path(FH_TEST_GAME_RESOURCES));
+        factory.scanModSubfolders();
+        Environment result;
+        result.m_resourceLibrary   = factory.create({});
+        result.m_databaseContainer = std::make_shared<Core::GameDatabaseContainer>(result.m_resourceLibrary.get());
+        return result;
+    }();
+    return s_environment.m_databaseContainer.get();
+}
+
+const Core::IGameDatabase* getTestDatabase()
+{
+    return getTestDatabaseContainer()->getDatabase(Core::GameVersion::HOTA);
+}
+
+FHMap makeTemplateMap(int mapSize)
+{
+    FHMap map;
+    map.m_database = getTestDatabase();
+    map.fromJson(Mernel::readJsonFromBuffer(Mernel::readFileIntoBuffer(Mernel::string2path(FH_TEST_GAME_RESOURCES) / "templates" / "jebus_balanced.json")));
+    map.m_template.m_userSettings.m_mapSize = mapSize;
+    map.rescaleToUserSize();
+    return map;
+}
+
+struct GenerateOptions {
+    std::string      m_stopAfterStage;
+    Mernel::std_path m_checkpointDir;
+    Mernel::std_path m_resumeFrom;
+};
+
+FHMap generateTestMap(uint64_t seed, const GenerateOptions& options = {})
+{
+    FHMap map  = makeTemplateMap(72);
+    map.m_seed = seed;
+
+    Core::RandomGeneratorFactory rngFactory;
+    auto                         rng = rngFactory.create();
+    rng->setSeed(seed);
+
+    std::ostringstream  log;
+    FHTemplateProcessor processor(map, rng.get(), log, options.m_stopAfterStage, "", "", 1000, false, options.m_checkpointDir, options.m_resumeFrom);
+    processor.run();
+    return map;
+}
+
+std::string mapToJsonString(FHMap& map)
+{
+    map.m_packedTileMap.packFromMap(map.m_tileMap);
+    Mernel::PropertyTree json;
+    map.toJson(json);
+    return Mernel::writeJsonToBuffer(json);
+}
+
+}
+
+GTEST_TEST(TemplateCheckpointTest, ResumeSameAsUninterrupted)
+{
+    if (!getTestDatabase())
+        GTEST_SKIP() << "game database is not available";
+
+    const Mernel::std_path checkpointDir = Mernel::std_fs::temp_directory_path() / "fh_checkpoint_test";
+    Mernel::std_fs::remove_all(checkpointDir);
+
+    FHMap uninterrupted = generateTestMap(42, { .m_checkpointDir = checkpointDir });
+    FHMap resumed       = generateTestMap(42, { .m_resumeFrom = checkpointDir / "HeatMap.fhrmgstate" });
+    Mernel::std_fs::remove_all(checkpointDir);
+
+    EXPECT_EQ(mapToJsonString(resumed), mapToJsonString(uninterrupted));
+}
+
+GTEST_TEST(FHTileMapViewTest, SameForAnyThreadCount)
+{
+    const Core::IGameDatabase* database = getTestDatabase();
+    if (!database)
+        GTEST_SKIP() << "game database is not available";
+
+    const FHMap generated = generateTestMap(42);
+
+    auto makeViews = [&generated, database](size_t threads) {
+        FHTileMap map = generated.m_tileMap;
+        map.determineViewRotation(database, threads);
+        map.makeRecommendedRotation();
+
+        Core::RandomGeneratorFactory rngFactory;
+        auto                         rng = rngFactory.create();
+        rng->setSeed(7);
+        map.makeRngView(rng.get(), generated.m_template.m_roughTilePercentage);
+        return map;
+    };
+    auto packView = [](std::string& bytes, const FHTileMap::TileView& view) {
+        bytes += static_cast<char>(view.m_view);
+        bytes += static_cast<char>(view.m_flipHor | view.m_flipVert << 1);
+    };
+    auto packViews = [&packView](const FHTileMap& map) {
+        std::string bytes;
+        for (size_t i = 0; i < map.totalSize(); ++i) {
+            packView(bytes, map.m_terrainViews[i]);
+            packView(bytes, map.m_roadViews[i]);
+            packView(bytes, map.m_riverViews[i]);
+        }
+        return bytes;
+    };
+
+    const std::string expected = packViews(makeViews(1));
+    ASSERT_EQ(expected.size(), generated.m_tileMap.totalSize() * 6);
+    EXPECT_EQ(packViews(makeViews(3)), expected);
+    EXPECT_EQ(packViews(makeViews(0)), expected);
+}
+
+GTEST_TEST(FHTileMapViewTest, LineViewsSameAsPerTileMatcher)
+{
+    std::mt19937_64 rng(42);
+
+    // wide enough for rows to be split into several chunks.
+    FHTileMap map;
+    map.m_width  = 96;
+    map.m_height = 160;
+    map.m_depth  = 2;
+    map.updateSize();
+    for (size_t i = 0; i < map.totalSize(); ++i) {
+        map.m_roadTypes[i]  = rng() % 2 ? static_cast<FHRoadType>(1 + rng() % 3) : FHRoadType::None;
+        map.m_riverTypes[i] = rng() % 2 ? static_cast<FHRiverType>(1 + rng() % 4) : FHRiverType::None;
+    }
+
+    // matcher which was used per tile before lookup tables; tiles outside of map have no road or river.
+    auto referenceView = [&map](int x, int y, int z, bool road) {
+        auto same = [&map, x, y, z, road](int dx, int dy) {
+            const size_t center = map.index(x, y, z);
+            const bool   inMap  = map.inBounds(x + dx, y + dy);
+            const size_t other  = inMap ? map.index(x + dx, y + dy, z) : center;
+            if (road)
+                return (map.m_roadTypes[center] == FHRoadType::None) == (!inMap || map.m_roadTypes[other] == FHRoadType::None);
+            return inMap ? map.m_riverTypes[center] == map.m_riverTypes[other] : map.m_riverTypes[center] == FHRiverType::None;
+        };
+        FHTileMap::TileViewRange result;
+        auto                     match = [&same, &result, road](bool flipHor, bool flipVert, int order) {
+            const int  sx = flipHor ? -1 : +1;
+            const int  sy = flipVert ? -1 : +1;
+            const bool eR = same(sx, 0), eL = same(-sx, 0), eT = same(0, -sy), eB = same(0, sy);
+            const bool eTR = same(sx, -sy), eBL = same(-sx, sy);
+
+            auto setView = [&result, flipHor, flipVert](uint8_t min, uint8_t max) {
+                result = { .m_viewMin = min, .m_viewMax = max, .m_recommendedFlipHor = flipHor, .m_recommendedFlipVert = flipVert };
+                return true;
+            };
+            if (road) {
+                if (order == 0 && eR && !eL && !eT && eB && (eTR || eBL))
+                    return setView(2, 5);
+                if (order == 1 && eR && eL && eT && eB)
+                    return setView(16, 16);
+                if (order == 1 && eR && eL && !eT && eB)
+                    return setView(8, 9);
+                if (order == 1 && eR && !eL && eT && eB)
+                    return setView(6, 7);
+                if (order == 1 && !eR && !eL && eT && eB)
+                    return setView(10, 11);
+                if (order == 1 && eR && eL && !eT && !eB)
+                    return setView(12, 13);
+                if (order == 1 && eR && !eL && !eT && eB)
+                    return setView(0, 1);
+                if (order == 2 && !eR && !eL && !eT && eB)
+                    return setView(14, 14);
+                if (order == 2 && eR && !eL && !eT && !eB)
+                    return setView(15, 15);
+                if (order == 2 && !eR && !eL && !eT && !eB) {
+                    setView(14, 14);
+                    result.m_recommendedFlipHor  = false;
+                    result.m_recommendedFlipVert = true;
+                    return true;
+                }
+                return false;
+            }
+            if (order == 0 && eR && eL && eT && eB)
+                return setView(4, 4);
+            if (order == 0 && eR && eL && !eT && eB)
+                return setView(5, 6);
+            if (order == 0 && eR && !eL && eT && eB)
+                return setView(7, 8);
+            if (order == 0 && !eR && !eL && eT && eB)
+                return setView(9, 10);
+            if (order == 0 && eR && eL && !eT && !eB)
+                return setView(11, 12);
+            if (order == 0 && eR && !eL && !eT && eB)
+                return setView(0, 3);
+            if (order == 1 && !eR && !eL && !eT && eB)
+                return setView(9, 10);
+            if (order == 1 && !eR && !eL && eT && !eB)
+                return setView(9, 10);
+            if (order == 1 && eR && !eL && !eT && !eB)
+                return setView(11, 12);
+            if (order == 1 && !eR && eL && !eT && !eB)
+                return setView(11, 12);
+            return false;
+        };
+        for (int order = 0; order <= (road ? 2 : 1); ++order) {
+            for (bool flipHor : { false, true }) {
+                for (bool flipVert : { false, true }) {
+                    if (match(flipHor, flipVert, order))
+                        return result;
+                }
+            }
+        }
+        return FHTileMap::TileViewRange{ .m_viewMin = 9, .m_viewMax = 10 };
+    };
+
+    for (size_t threads : { 1, 3 }) {
+        map.m_viewStates = {};
+        map.determineRoadViewRotation(threads);
+        map.determineRiverViewRotation(threads);
+        for (int z = 0; z < map.m_depth; ++z) {
+            for (int y = 0; y < map.m_height; ++y) {
+                for (int x = 0; x < map.m_width; ++x) {
+                    const size_t index = map.index(x, y, z);
+                    for (bool road : { true, false }) {
+                        if (road ? map.m_roadTypes[index] == FHRoadType::None : map.m_riverTypes[index] == FHRiverType::None)
+                            continue;
+                        const auto& actual   = road ? map.m_viewStates[index].m_roadView : map.m_viewStates[index].m_riverView;
+                        const auto  expected = referenceView(x, y, z, road);
+                        ASSERT_EQ(actual.m_viewMin, expected.m_viewMin) << x << "," << y << "," << z << " road=" << road << " threads=" << threads;
+                        ASSERT_EQ(actual.m_viewMax, expected.m_viewMax) << x << "," << y << "," << z << " road=" << road << " threads=" << threads;
+                        ASSERT_EQ(actual.m_recommendedFlipHor, expected.m_recommendedFlipHor) << x << "," << y << "," << z << " road=" << road << " threads=" << threads;
+                        ASSERT_EQ(actual.m_recommendedFlipVert, expected.m_recommendedFlipVert) << x << "," << y << "," << z << " road=" << road << " threads=" << threads;
+                    }
+                }
+            }
+        }
+    }
+}
+
+GTEST_TEST(H3MReadScopeTest, PartialReadSameAsFull)
+{
+    const Core::IGameDatabase* database = getTestDatabase();
+    if (!database)
+        GTEST_SKIP() << "game database is not available";
+
+    const Mernel::std_path tmpDir = Mernel::std_fs::temp_directory_path() / "fh_read_scope_test";
+    Mernel::std_fs::create_directories(tmpDir);
+    const Mernel::std_path     h3mPath = tmpDir / "sample.h3m";
+    Core::RandomGeneratorFactory rngFactory;
+    std::ostringstream           log;
+    {
+        MapConverter writer(log, getTestDatabaseContainer(), &rngFactory, { .m_outputs = { .m_h3m = { .m_binary = h3mPath } } });
+        writer.m_mapFH = generateTestMap(42);
+        writer.run(MapConverter::Task::SaveH3M);
+    }
+    auto readScope = [&](MapConverter::Task task) {
+        auto converter = std::make_unique<MapConverter>(log, getTestDatabaseContainer(), &rngFactory, MapConverter::Settings{ .m_inputs = { .m_h3m = { .m_binary = h3mPath } } });
+        converter->run(task);
+        return converter;
+    };
+    auto toJson = [](const H3Map& map) {
+        Mernel::PropertyTree json;
+        map.toJson(json);
+        return json;
+    };
+    auto full        = readScope(MapConverter::Task::LoadH3MRaw);
+    auto header      = readScope(MapConverter::Task::LoadH3MHeader);
+    auto tiles       = readScope(MapConverter::Task::LoadH3MTiles);
+    auto fullJson    = toJson(full->m_mapH3M);
+    auto headerJson  = toJson(header->m_mapH3M);
+    auto tilesJson   = toJson(tiles->m_mapH3M);
+    auto jsonSection = [](Mernel::PropertyTree& json, const std::string& key) { return Mernel::writeJsonToBuffer(json[key]); };
+
+    ASSERT_FALSE(full->m_mapH3M.m_objects.empty());
+    for (std::string key : { "format", "hotaVer", "anyPlayers", "mapName", "mapDescr", "difficulty", "levelLimit", "players", "victoryCondition", "lossCondition", "teamCount" }) {
+        EXPECT_EQ(jsonSection(headerJson, key), jsonSection(fullJson, key)) << "header scope, " << key;
+        EXPECT_EQ(jsonSection(tilesJson, key), jsonSection(fullJson, key)) << "tiles scope, " << key;
+    }
+    EXPECT_TRUE(header->m_mapH3M.m_tiles.m_tiles.empty());
+    for (std::string key : { "allowedHeroes", "disposedHeroes", "allowedArtifacts", "allowedSpells", "allowedSecSkills", "rumors", "customHeroData", "tiles" })
+        EXPECT_EQ(jsonSection(tilesJson, key), jsonSection(fullJson, key)) << "tiles scope, " << key;
+    EXPECT_TRUE(tiles->m_mapH3M.m_objects.empty());
+    EXPECT_EQ(tiles->m_mapH3M.m_objectsOffset, full->m_mapH3M.m_objectsOffset);
+
+    // objects read later from the same stream complete the map.
+    {
+        Mernel::ByteOrderBuffer           bobuffer(tiles->m_mainFile.m_binaryBuffer);
+        Mernel::ByteOrderDataStreamReader reader(bobuffer, Mernel::ByteOrderDataStream::s_littleEndian);
+        H3Map                             map;
+        map.readBinary(reader, H3Map::ReadScope::Tiles);
+        map.readBinaryObjects(reader);
+        EXPECT_EQ(Mernel::writeJsonToBuffer(toJson(map)), Mernel::writeJsonToBuffer(fullJson));
+    }
+    Mernel::std_fs::remove_all(tmpDir);
+}
+
+GTEST_TEST(H3M2FHTest, ParallelObjectsSameAsSequential)
+{
+    const Core::IGameDatabase* database = getTestDatabase();
+    if (!database)
+        GTEST_SKIP() << "game database is not available";
+
+    const Mernel::std_path tmpDir = Mernel::std_fs::temp_directory_path() / "fh_h3m2fh_test";
+    Mernel::std_fs::create_directories(tmpDir);
+    Core::RandomGeneratorFactory rngFactory;
+    std::ostringstream           log;
+    MapConverter                 writer(log, getTestDatabaseContainer(), &rngFactory, { .m_outputs = { .m_h3m = { .m_binary = tmpDir / "sample.h3m" } } });
+    writer.m_mapFH = generateTestMap(42);
+    writer.run(MapConverter::Task::SaveH3M);
+    Mernel::std_fs::remove_all(tmpDir);
+
+    // objects are repeated until their count alone is enough for 4 chunks; every copy gets own order index,
+    // so merged chunks must keep source order, and towns and heroes of every copy are looked up again.
+    H3Map                     src     = writer.m_mapH3M;
+    const std::vector<Object> objects = src.m_objects;
+    ASSERT_FALSE(objects.empty());
+    while (src.m_objects.size() < 1100)
+        src.m_objects.insert(src.m_objects.end(), objects.cbegin(), objects.cend());
+
+    const Core::IGameDatabase* h3mDatabase = writer.m_mapFH.m_database;
+    auto                       convert     = [&src, h3mDatabase](size_t threads) {
+        FHMap dest;
+        dest.m_database = h3mDatabase;
+        H3M2FHConverter converter(h3mDatabase, threads);
+        converter.convertMap(src, dest);
+        return mapToJsonString(dest);
+    };
+
+    const std::string expected = convert(1);
+    EXPECT_EQ(convert(4), expected);
+}
+
+GTEST_TEST(MapConverterBatchTest, ParallelSameAsSequential)
+{
+    const Core::IGameDatabase* database = getTestDatabase();
+    if (!database)
+        GTEST_SKIP() << "game database is not available";
+
+    const Mernel::std_path tmpDir = Mernel::std_fs::temp_directory_path() / "fh_batch_test";
+    Mernel::std_fs::remove_all(tmpDir);
+    Mernel::std_fs::create_directories(tmpDir);
+    Core::RandomGeneratorFactory rngFactory;
+    std::ostringstream           log;
+
+    std::vector<MapConverter::Settings> batch;
+    {
+        MapConverter writer(log, getTestDatabaseContainer(), &rngFactory, {});
+        writer.m_mapFH = generateTestMap(42);
+        for (const char* name : { "a.h3m", "b.h3m", "c.h3m" }) {
+            writer.setSettings({ .m_outputs = { .m_h3m = { .m_binary = tmpDir / name } } });
+            writer.run(MapConverter::Task::SaveH3M);
+            batch.push_back({ .m_inputs = { .m_h3m = { .m_binary = tmpDir / name } } });
+        }
+    }
+    const Mernel::std_path broken = tmpDir / "broken.h3m";
+    Mernel::writeFileFromBuffer(broken, "not a map");
+    batch.insert(batch.begin() + 1, MapConverter::Settings{ .m_inputs = { .m_h3m = { .m_binary = broken } } });
+
+    auto runBatch = [&](size_t jobs) {
+        MapConverterBatch batchRunner(log, getTestDatabaseContainer(), &rngFactory);
+        return batchRunner.run(batch, { MapConverter::Task::LoadH3M }, jobs);
+    };
+    auto summary = [&batch](const std::vector<MapConverterBatch::Result>& results) {
+        Mernel::PropertyTree json;
+        MapConverterBatch::writeSummaryJson(json, batch, results);
+        return json;
+    };
+
+    const auto sequential = runBatch(1);
+    const auto parallel   = runBatch(3);
+    Mernel::std_fs::remove_all(tmpDir);
+
+    ASSERT_EQ(parallel.size(), batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        EXPECT_EQ(parallel[i].m_status, i == 1 ? MapConverterBatch::RunStatus::Fatal : MapConverterBatch::RunStatus::Succeeded) << i;
+        EXPECT_EQ(parallel[i].m_status, sequential[i].m_status) << i;
+        EXPECT_EQ(parallel[i].m_error, sequential[i].m_error) << i;
+    }
+
+    // results are listed in batch order regardless of finish order.
+    const Mernel::PropertyTree json = summary(parallel);
+    EXPECT_EQ(Mernel::writeJsonToBuffer(json), Mernel::writeJsonToBuffer(summary(sequential)));
+    ASSERT_EQ(json["succeeded"].getList().size(), 3U);
+    EXPECT_EQ(json["succeeded"].getList()[1].getScalar().toString(), Mernel::path2string(tmpDir / "b.h3m"));
+    EXPECT_TRUE(json["failedRoundTrip"].getList().empty());
+    ASSERT_EQ(json["fatal"].getList().size(), 1U);
+    EXPECT_EQ(json["fatal"].getList()[0]["path"].getScalar().toString(), Mernel::path2string(broken));
+    EXPECT_FALSE(json["fatal"].getList()[0]["error"].getScalar().toString().empty());
+}
+
+GTEST_TEST(FHMapTest, DerandomizeWithPoolsSameAsPlain)
+{
+    const Core::IGameDatabase* database = getTestDatabase();
+    if (!database)
+        GTEST_SKIP() << "game database is not available";
+
+    FHMap source;
+    source.m_database = database;
+    for (int x = 0; x < 8; ++x) {
+        source.m_objects.m_resourcesRandom.push_back({ FHRandomResource{ { .m_pos = { x, 0, 0 } } } });
+        source.m_objects.m_artifactsRandom.push_back({ FHRandomArtifact{ { .m_pos = { x, 1, 0 } }, static_cast<FHRandomArtifact::Type>(1 + x % 5) } });
+
+        FHMonster monster;
+        monster.m_pos         = { x, 2, 0 };
+        monster.m_randomLevel = x;
+        source.m_objects.m_monsters.push_back(monster);
+
+        FHTown town;
+        town.m_pos        = { x, 3, 0 };
+        town.m_randomTown = true;
+        source.m_towns.push_back(town);
+
+        FHRandomDwelling dwelling;
+        dwelling.m_pos      = { x, 4, 0 };
+        dwelling.m_hasLevel = x > 0;
+        dwelling.m_minLevel = static_cast<uint8_t>(x > 0 ? x - 1 : 0);
+        dwelling.m_maxLevel = 6;
+        source.m_objects.m_randomDwellings.push_back(dwelling);
+    }
+
+    Core::RandomGeneratorFactory rngFactory;
+    auto                         derandomized = [&source, &rngFactory](const FHDerandomizePools* pools) {
+        FHMap map = source;
+        auto  rng = rngFactory.create();
+        rng->setSeed(42);
+        if (pools)
+            map.derandomize(rng.get(), *pools);
+        else
+            map.derandomize(rng.get());
+        return map;
+    };
+
+    const FHDerandomizePools pools(database);
+    const FHMap              plain      = derandomized(nullptr);
+    const FHMap              withPools  = derandomized(&pools);
+    const FHMap              poolsAgain = derandomized(&pools);
+
+    EXPECT_TRUE(plain.m_objects.m_resourcesRandom.empty());
+    EXPECT_TRUE(plain.m_objects.m_artifactsRandom.empty());
+    EXPECT_TRUE(plain.m_objects.m_randomDwellings.empty());
+    EXPECT_EQ(plain.m_objects.m_resources.size(), 8U);
+    EXPECT_EQ(plain.m_objects.m_artifacts.size(), 8U);
+    EXPECT_EQ(plain.m_objects.m_monsters.size(), 8U);
+    EXPECT_EQ(plain.m_objects.m_dwellings.size(), 8U);
+    EXPECT_EQ(plain.m_towns.size(), 8U);
+    for (const FHMap* map : { &withPools, &poolsAgain }) {
+        EXPECT_EQ(map->m_objects.m_resources, plain.m_objects.m_resources);
+        EXPECT_EQ(map->m_objects.m_artifacts, plain.m_objects.m_artifacts);
+        EXPECT_EQ(map->m_objects.m_monsters, plain.m_objects.m_monsters);
+        EXPECT_EQ(map->m_objects.m_dwellings, plain.m_objects.m_dwellings);
+        EXPECT_EQ(map->m_towns, plain.m_towns);
+    }
+}
+
+GTEST_TEST(ParallelChunksTest, RangesCoverAllItems)
+{
+    EXPECT_EQ(getParallelChunks(0, 100, 4), 1U);
+    EXPECT_EQ(getParallelChunks(250, 100, 4), 2U);
+    EXPECT_EQ(getParallelChunks(10000, 100, 4), 4U);
+    EXPECT_EQ(getParallelChunks(10, 0, 3), 3U);
+
+    // uneven split, more chunks than threads.
+    const size_t                           count = 103;
+    std::vector<int>                       visits(count);
+    std::vector<std::pair<size_t, size_t>> ranges(7);
+    forEachChunkParallel(count, ranges.size(), 3, [&visits, &ranges](size_t chunk, size_t begin, size_t end) {
+        ranges[chunk] = { begin, end };
+        for (size_t i = begin; i < end; ++i)
+            visits[i]++;
+    });
+    EXPECT_EQ(visits, std::vector<int>(count, 1));
+    EXPECT_EQ(ranges.front().first, 0U);
+    EXPECT_EQ(ranges.back().second, count);
+    for (size_t chunk = 1; chunk < ranges.size(); ++chunk)
+        EXPECT_EQ(ranges[chunk].first, ranges[chunk - 1].second) << chunk;
+
+    // all chunks are finished before error of the first failed one is rethrown.
+    std::atomic<int> finished = 0;
+    try {
+        forEachChunkParallel(count, 5, 5, [&finished](size_t chunk, size_t, size_t) {
+            finished++;
+            if (chunk == 2 || chunk == 4)
+                throw std::runtime_error(std::to_string(chunk));
+        });
+        FAIL() << "no exception";
+    }
+    catch (std::runtime_error& ex) {
+        EXPECT_STREQ(ex.what(), "2");
+    }
+    EXPECT_EQ(finished, 5);
+}
@@ -504,6 +504,10 @@ void Archive::convertFromBinary(bool uncompress)
         rec.m_bufferWithFile.m_inMemory         = true;
         m_records.push_back(std::move(rec));
     }
+    // binary records are rebuilt by convertToBinary(); keeping them only holds extra compressed copies.
+    m_binaryRecords.clear();
+    m_binaryRecordsUnnamed.clear();
+    m_binaryRecordsSortedByOffset.clear();
 }
 
 void Archive::readBinaryHDAT(ByteOrderDataStreamReader& stream)
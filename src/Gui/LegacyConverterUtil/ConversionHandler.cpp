@@ -322,6 +322,8 @@ void ConversionHandler::binaryDeserializeArchive()
     catch (std::exception& ex) {
         throw std::runtime_error(ex.what() + std::string(", offset=") + std::to_string(bobuffer.getOffsetRead()));
     }
+    // every record owns a copy of its data now, so whole file is not needed anymore.
+    m_binaryBuffer = {};
 }
 
 void ConversionHandler::binarySerializeArchive()
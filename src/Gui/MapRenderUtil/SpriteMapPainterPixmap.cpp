@@ -67,7 +67,7 @@ void SpriteMapPainterPixmap::paint(Painter*         painter,
             if (!seq)
                 continue;
             auto containsAnyScore = [](const std::set<Core::ScoreAttr>& filter, const Core::MapScore& score) {
-                for (auto& [key, val] : score)
+                for (const auto& [key, val] : score)
                     if (filter.contains(key))
                         return true;
                 return false;